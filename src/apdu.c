@@ -1,4 +1,6 @@
 #include "apdu.h"
+#include "apdu_stack.h"
+#include "apdu_trace.h"
 #include "globals.h"
 #include "to_string.h"
 #include "version.h"
@@ -40,9 +42,16 @@ __attribute__((noreturn)) void main_loop(apdu_handler const *const handlers,
                                          size_t const handlers_size) {
     volatile size_t rx = io_exchange(CHANNEL_APDU, 0);
     while (true) {
+        volatile uint8_t instruction = INS_MAX + 1;  // Not known until the APDU is validated
         BEGIN_TRY {
             TRY {
                 PRINTF("New APDU received:\n%.*H\n", rx, G_io_apdu_buffer);
+                scratch_reset();
+                global.status.apdus++;
+                trace_apdu(rx);
+#ifdef HAVE_STACK_TELEMETRY
+                stack_record();  // What the previous APDU took, its prompt included
+#endif
                 // Process APDU of size rx
 
                 if (rx == 0) {
@@ -62,25 +71,39 @@ __attribute__((noreturn)) void main_loop(apdu_handler const *const handlers,
                     THROW(EXC_WRONG_LENGTH);
                 }
 
-                uint8_t const instruction = G_io_apdu_buffer[OFFSET_INS];
-                apdu_handler const cb =
-                    instruction >= handlers_size ? handle_apdu_error : handlers[instruction];
+                instruction = G_io_apdu_buffer[OFFSET_INS];
+#ifdef HAVE_STACK_TELEMETRY
+                stack_start(instruction);
+#endif
+                if (!is_sign_instruction(instruction) && !suspends_sign_session(instruction)) {
+                    clear_apdu_globals();  // Anything else ends a suspended signing session
+                }
+
+                // The table is in flash, so its function pointers need relocating.
+                apdu_handler cb = instruction < handlers_size ? handlers[instruction] : NULL;
+                cb = cb == NULL ? handle_apdu_error : (apdu_handler) PIC(cb);
 
                 size_t const tx = cb(instruction);
+                trace(TRACE_HANDLED, 0, tx);
                 rx = io_exchange(CHANNEL_APDU, tx);
             }
             CATCH(ASYNC_EXCEPTION) {
+                trace(TRACE_PROMPT, 0, 0);
                 rx = io_exchange(CHANNEL_APDU | IO_ASYNCH_REPLY, 0);
             }
             CATCH(EXCEPTION_IO_RESET) {
                 THROW(EXCEPTION_IO_RESET);
             }
             CATCH_OTHER(e) {
-                clear_apdu_globals();  // IMPORTANT: Application state must not persist through
-                                       // errors
+                // IMPORTANT: Application state must not persist through errors. A read-only
+                // instruction failing in the middle of a signing session cannot have touched it.
+                if (!suspends_sign_session(instruction)) {
+                    clear_apdu_globals();
+                }
 
                 uint16_t sw = e;
                 PRINTF("Error caught at top level, number: %x\n", sw);
+                trace(TRACE_ERROR, 0, sw);
                 switch (sw) {
                     default:
                         sw = 0x6800 | (e & 0x7FF);
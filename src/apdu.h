@@ -1,9 +1,11 @@
 #pragma once
 
+#include "apdu_trace.h"
 #include "exception.h"
 #include "keys.h"
 #include "types.h"
 #include "ui.h"
+#include "wire.h"
 
 #include "os.h"
 
@@ -38,10 +40,54 @@
 #define INS_QUERY_AUTH_KEY_WITH_CURVE 0x0D
 #define INS_HMAC                      0x0E
 #define INS_SIGN_WITH_HASH            0x0F
+#define INS_SET_PAYOUT_POLICY         0x10
+#define INS_QUERY_STACK               0x11  // Builds with STACK_TELEMETRY=1 only
+#define INS_QUERY_STATUS              0x12
+#define INS_DRAIN_TRACE               0x13  // Unless built with TRACE_RECORDS=0
+#define INS_QUERY_AUDIT_LOG           0x14
+#define INS_EXPORT_HWM                0x15
+
+// Short, read-only instructions that may be served in the middle of a multi-packet signing
+// session. They leave the session suspended so the host can continue streaming afterwards.
+// Any other instruction, except the signing instructions themselves, ends the session.
+static inline bool suspends_sign_session(uint8_t const instruction) {
+    switch (instruction) {
+        case INS_VERSION:
+        case INS_GET_PUBLIC_KEY:
+        case INS_GIT:
+        case INS_QUERY_STATUS:
+#if TRACE_RECORDS > 0
+        case INS_DRAIN_TRACE:
+#endif
+#ifdef HAVE_STACK_TELEMETRY
+        case INS_QUERY_STACK:
+#endif
+#ifdef BAKING_APP
+        case INS_QUERY_AUTH_KEY:
+        case INS_QUERY_MAIN_HWM:
+        case INS_QUERY_ALL_HWM:
+        case INS_QUERY_AUTH_KEY_WITH_CURVE:
+        case INS_QUERY_AUDIT_LOG:
+#endif
+            return true;
+        default:
+            return false;
+    }
+}
+
+static inline bool is_sign_instruction(uint8_t const instruction) {
+    return instruction == INS_SIGN || instruction == INS_SIGN_UNSAFE ||
+           instruction == INS_SIGN_WITH_HASH;
+}
 
 __attribute__((noreturn)) void main_loop(apdu_handler const *const handlers,
                                          size_t const handlers_size);
 
+// The payload of the current APDU. main_loop has checked that it is as long as LC says.
+static inline struct wire_cursor apdu_payload(void) {
+    return wire_cursor(&G_io_apdu_buffer[OFFSET_CDATA], G_io_apdu_buffer[OFFSET_LC]);
+}
+
 static inline size_t finalize_successful_send(size_t tx) {
     G_io_apdu_buffer[tx++] = 0x90;
     G_io_apdu_buffer[tx++] = 0x00;
@@ -50,6 +96,7 @@ static inline size_t finalize_successful_send(size_t tx) {
 
 // Send back response; do not restart the event loop
 static inline void delayed_send(size_t tx) {
+    trace(TRACE_HANDLED, 0, tx);
     io_exchange(CHANNEL_APDU | IO_RETURN_AFTER_TX, tx);
 }
 
@@ -17,12 +17,11 @@
 static bool reset_ok(void);
 
 size_t handle_apdu_reset(__attribute__((unused)) uint8_t instruction) {
-    uint8_t *dataBuffer = G_io_apdu_buffer + OFFSET_CDATA;
-    uint32_t dataLength = G_io_apdu_buffer[OFFSET_LC];
-    if (dataLength != sizeof(level_t)) {
+    struct wire_cursor payload = apdu_payload();
+    if (wire_remaining(&payload) != sizeof(level_t)) {
         THROW(EXC_WRONG_LENGTH_FOR_INS);
     }
-    level_t const lvl = READ_UNALIGNED_BIG_ENDIAN(level_t, dataBuffer);
+    level_t const lvl = WIRE_CONSUME(&payload, level_t);
     if (!is_valid_level(lvl)) THROW(EXC_PARSE_ERROR);
 
     G.reset_level = lvl;
@@ -47,30 +46,21 @@ bool reset_ok(void) {
 }
 
 size_t send_word_big_endian(size_t tx, uint32_t word) {
-    char word_bytes[sizeof(word)];
-
-    memcpy(word_bytes, &word, sizeof(word));
-
-    // endian.h functions do not compile
-    uint32_t i = 0;
-    for (; i < sizeof(word); i++) {
-        G_io_apdu_buffer[i + tx] = word_bytes[sizeof(word) - i - 1];
-    }
-
-    return tx + i;
+    wire_write_be32(&G_io_apdu_buffer[tx], word);
+    return tx + sizeof(word);
 }
 
 size_t handle_apdu_all_hwm(__attribute__((unused)) uint8_t instruction) {
     size_t tx = 0;
-    tx = send_word_big_endian(tx, N_data.hwm.main.highest_level);
-    tx = send_word_big_endian(tx, N_data.hwm.test.highest_level);
+    tx = send_word_big_endian(tx, global.nvram.hwm.main.highest_level);
+    tx = send_word_big_endian(tx, global.nvram.hwm.test.highest_level);
     tx = send_word_big_endian(tx, N_data.main_chain_id.v);
     return finalize_successful_send(tx);
 }
 
 size_t handle_apdu_main_hwm(__attribute__((unused)) uint8_t instruction) {
     size_t tx = 0;
-    tx = send_word_big_endian(tx, N_data.hwm.main.highest_level);
+    tx = send_word_big_endian(tx, global.nvram.hwm.main.highest_level);
     return finalize_successful_send(tx);
 }
 
@@ -100,6 +90,33 @@ size_t handle_apdu_query_auth_key_with_curve(__attribute__((unused)) uint8_t ins
     return finalize_successful_send(tx);
 }
 
+// 8 + 12 * 16 bytes, with room for the status word.
+#define AUDIT_RECORDS_PER_RESPONSE 12
+
+size_t handle_apdu_query_audit_log(__attribute__((unused)) uint8_t instruction) {
+    if (G_io_apdu_buffer[OFFSET_P1] != 0) THROW(EXC_WRONG_PARAM);
+    struct wire_cursor payload = apdu_payload();
+    uint32_t first = WIRE_CONSUME(&payload, uint32_t);
+    wire_expect_end(&payload);
+
+    uint32_t const written = global.nvram.written;
+    // The oldest record is not kept: a write cut short by a power failure tears its slot.
+    uint32_t const kept = written < AUDIT_RECORDS - 1 ? written : AUDIT_RECORDS - 1;
+    if (first < written - kept) first = written - kept;
+    if (first > written) first = written;
+
+    size_t tx = 0;
+    tx = send_word_big_endian(tx, written);
+    tx = send_word_big_endian(tx, first);
+    for (uint32_t i = first; i != written && i - first < AUDIT_RECORDS_PER_RESPONSE; i++) {
+        struct audit_record volatile const *const record = &N_nvram.audit[i % AUDIT_RECORDS];
+        tx = send_word_big_endian(tx, record->chain_id.v);
+        tx = send_word_big_endian(tx, record->level);
+        for (size_t j = 0; j < sizeof(record->hash); j++) G_io_apdu_buffer[tx++] = record->hash[j];
+    }
+    return finalize_successful_send(tx);
+}
+
 size_t handle_apdu_deauthorize(__attribute__((unused)) uint8_t instruction) {
     if (G_io_apdu_buffer[OFFSET_P1] != 0) THROW(EXC_WRONG_PARAM);
     if (G_io_apdu_buffer[OFFSET_LC] != 0) THROW(EXC_PARSE_ERROR);
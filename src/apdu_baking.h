@@ -12,4 +12,11 @@ size_t handle_apdu_main_hwm(uint8_t instruction);
 size_t handle_apdu_all_hwm(uint8_t instruction);
 size_t handle_apdu_deauthorize(uint8_t instruction);
 
+// Takes the number of the first record wanted, 4 bytes big-endian. Returns the number of records
+// written, then the number of the first record returned and as many of the records kept from it
+// on as a response holds, oldest first: chain id, level (AUDIT_ENDORSEMENT set for an
+// endorsement) and the first AUDIT_HASH_SIZE bytes of the hash signed. Records no longer kept are
+// skipped, the last AUDIT_RECORDS - 1 being kept. All numbers are big-endian.
+size_t handle_apdu_query_audit_log(uint8_t instruction);
+
 #endif  // #ifdef BAKING_APP
@@ -1,5 +1,23 @@
 #pragma once
 
 #include "apdu.h"
+#include "globals.h"
+
+#ifdef BAKING_APP
+
+#define HMAC_KEY_SEED_SIZE 32
+
+// HMAC-SHA256 of `in`, keyed with the SHA512 of the signature of `key_sha256` by the key at
+// `global.path_with_curve.bip32_path`: only a device with the same seed can compute it. Each use
+// that must not stand in for another has a value of its own.
+size_t hmac(uint8_t *const out,
+            size_t const out_size,
+            apdu_hmac_state_t *const state,
+            uint8_t const *const key_sha256,
+            uint8_t const *const in,
+            size_t const in_size,
+            derivation_type_t derivation_type);
+
+#endif  // #ifdef BAKING_APP
 
 size_t handle_apdu_hmac(uint8_t instruction);
@@ -0,0 +1,102 @@
+#include "apdu_payout.h"
+
+#ifdef HAVE_WALLET
+
+#include "apdu.h"
+#include "globals.h"
+#include "keys.h"
+#include "protocol.h"
+#include "to_string.h"
+#include "ui.h"
+
+#include <string.h>
+
+#define G global.apdu.u.payout
+
+// Followed by a BIP32 path, as read by `read_bip32_path`.
+struct payout_policy_wire {
+    uint32_t max_operations;
+    uint64_t max_amount;
+    uint64_t max_total;
+    uint64_t max_fee;
+    uint64_t max_storage;
+} __attribute__((packed));
+
+static bool ok(void) {
+    memcpy(&global.payout_policy, &G, sizeof(global.payout_policy));
+    ui_initial_screen();  // Show the policy on the idle screen
+    delayed_send(finalize_successful_send(0));
+    return true;
+}
+
+__attribute__((noreturn)) static void prompt_payout_policy(ui_callback_t const ok_cb,
+                                                           ui_callback_t const cxl_cb) {
+    init_screen_stack();
+    push_ui_callback("Auto-Sign", copy_string, "Payouts?");
+    push_ui_callback("Address", bip32_path_with_curve_to_pkh_string, &G.key);
+    push_ui_callback("Operations", number_to_string_indirect32, &G.remaining_operations);
+    push_ui_callback("Max Amount", microtez_to_string_indirect, &G.max_amount);
+    push_ui_callback("Max Total", microtez_to_string_indirect, &G.remaining_amount);
+    push_ui_callback("Max Fee", microtez_to_string_indirect, &G.max_fee);
+    push_ui_callback("Max Storage", number_to_string_indirect64, &G.max_storage);
+
+    ux_confirm_screen(ok_cb, cxl_cb);
+}
+
+size_t handle_apdu_set_payout_policy(__attribute__((unused)) uint8_t instruction) {
+    if (G_io_apdu_buffer[OFFSET_P1] != 0) THROW(EXC_WRONG_PARAM);
+
+    struct wire_cursor payload = apdu_payload();
+    if (wire_remaining(&payload) == 0) {
+        // Revoking the policy is always safe, so it needs no prompt.
+        memset(&global.payout_policy, 0, sizeof(global.payout_policy));
+        ui_initial_screen();
+        return finalize_successful_send(0);
+    }
+
+    G.key.derivation_type = parse_derivation_type(G_io_apdu_buffer[OFFSET_CURVE]);
+
+    struct payout_policy_wire const *const policy = WIRE_TAKE(&payload, struct payout_policy_wire);
+    G.remaining_operations = WIRE_READ(policy, max_operations);
+    G.max_amount = WIRE_READ(policy, max_amount);
+    G.remaining_amount = WIRE_READ(policy, max_total);
+    G.max_fee = WIRE_READ(policy, max_fee);
+    G.max_storage = WIRE_READ(policy, max_storage);
+    read_bip32_path(&G.key.bip32_path, &payload);
+    wire_expect_end(&payload);
+
+    if (G.remaining_operations == 0) THROW(EXC_WRONG_VALUES);
+
+    prompt_payout_policy(ok, delay_reject);
+}
+
+bool payout_policy_consume(struct parsed_operation_group const *const ops,
+                           bip32_path_with_curve_t const *const key) {
+    check_null(ops);
+    check_null(key);
+    struct payout_policy *const policy = &global.payout_policy;
+    struct parsed_batch const *const batch = &ops->batch;
+
+    if (policy->remaining_operations == 0) return false;
+    if (!bip32_path_with_curve_eq(key, &policy->key)) return false;
+
+    // Only plain transactions are covered: `batch` leaves out contract calls, and every operation
+    // in it comes from the signing key.
+    if (ops->operation.tag != OPERATION_TAG_BABYLON_TRANSACTION) return false;
+    if (batch->all.operation_count == 0 || batch->delegation_count != 0) return false;
+    if (batch->all.operation_count > policy->remaining_operations) return false;
+
+    if (batch->largest_amount > policy->max_amount) return false;
+    if (batch->all.amount > policy->remaining_amount) return false;
+    if (ops->total_fee > policy->max_fee) return false;
+    if (ops->total_storage_limit > policy->max_storage) return false;
+
+    policy->remaining_operations -= batch->all.operation_count;
+    policy->remaining_amount -= batch->all.amount;
+    if (policy->remaining_operations == 0) {
+        memset(policy, 0, sizeof(*policy));
+    }
+    return true;
+}
+
+#endif  // #ifdef HAVE_WALLET
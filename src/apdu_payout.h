@@ -0,0 +1,18 @@
+#pragma once
+
+#include "keys.h"
+#include "types.h"
+
+#ifdef HAVE_WALLET
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+size_t handle_apdu_set_payout_policy(uint8_t instruction);
+
+// Returns true if the payout policy covers `ops`, signed with `key`, and deducts them from it.
+bool payout_policy_consume(struct parsed_operation_group const *const ops,
+                           bip32_path_with_curve_t const *const key);
+
+#endif  // #ifdef HAVE_WALLET
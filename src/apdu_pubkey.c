@@ -14,11 +14,13 @@
 #include <string.h>
 
 static bool pubkey_ok(void) {
-    cx_ecfp_public_key_t public_key = {0};
-    generate_public_key(&public_key,
+    cx_ecfp_public_key_t *const public_key = SCRATCH_BORROW(cx_ecfp_public_key_t);
+    generate_public_key(public_key,
                         global.path_with_curve.derivation_type,
                         &global.path_with_curve.bip32_path);
-    delayed_send(provide_pubkey(G_io_apdu_buffer, &public_key));
+    size_t const tx = provide_pubkey(G_io_apdu_buffer, public_key);
+    SCRATCH_RETURN(public_key);
+    delayed_send(tx);
     return true;
 }
 
@@ -70,37 +72,42 @@ __attribute__((noreturn)) static void prompt_address(
 }
 
 size_t handle_apdu_get_public_key(uint8_t instruction) {
-    uint8_t *dataBuffer = G_io_apdu_buffer + OFFSET_CDATA;
+    struct wire_cursor payload = apdu_payload();
 
     if (G_io_apdu_buffer[OFFSET_P1] != 0) THROW(EXC_WRONG_PARAM);
 
     // do not expose pks without prompt through U2F (permissionless legacy comm in browser)
     if (instruction == INS_GET_PUBLIC_KEY) require_permissioned_comm();
 
-    global.path_with_curve.derivation_type = parse_derivation_type(G_io_apdu_buffer[OFFSET_CURVE]);
+    // Providing a key without a prompt may happen in the middle of a suspended signing session,
+    // so it must not touch the key that session will sign with.
+    bip32_path_with_curve_t unprompted_key;
+    bip32_path_with_curve_t *const key =
+        instruction == INS_GET_PUBLIC_KEY ? &unprompted_key : &global.path_with_curve;
 
-    size_t const cdata_size = G_io_apdu_buffer[OFFSET_LC];
+    key->derivation_type = parse_derivation_type(G_io_apdu_buffer[OFFSET_CURVE]);
 
 #ifdef BAKING_APP
-    if (cdata_size == 0 && instruction == INS_AUTHORIZE_BAKING) {
-        copy_bip32_path_with_curve(&global.path_with_curve, &N_data.baking_key);
+    if (wire_remaining(&payload) == 0 && instruction == INS_AUTHORIZE_BAKING) {
+        copy_bip32_path_with_curve(key, &N_data.baking_key);
     } else {
 #endif
-        read_bip32_path(&global.path_with_curve.bip32_path, dataBuffer, cdata_size);
+        read_bip32_path(&key->bip32_path, &payload);
 #ifdef BAKING_APP
-        if (global.path_with_curve.bip32_path.length == 0) THROW(EXC_WRONG_LENGTH_FOR_INS);
+        if (key->bip32_path.length == 0) THROW(EXC_WRONG_LENGTH_FOR_INS);
     }
 #endif
 
-    cx_ecfp_public_key_t public_key = {0};
-    generate_public_key(&public_key,
-                        global.path_with_curve.derivation_type,
-                        &global.path_with_curve.bip32_path);
+    cx_ecfp_public_key_t *const public_key = SCRATCH_BORROW(cx_ecfp_public_key_t);
+    generate_public_key(public_key, key->derivation_type, &key->bip32_path);
 
     if (instruction == INS_GET_PUBLIC_KEY) {
-        return provide_pubkey(G_io_apdu_buffer, &public_key);
+        size_t const tx = provide_pubkey(G_io_apdu_buffer, public_key);
+        SCRATCH_RETURN(public_key);
+        return tx;
     } else {
         // instruction == INS_PROMPT_PUBLIC_KEY || instruction == INS_AUTHORIZE_BAKING
+        SCRATCH_RETURN(public_key);
         ui_callback_t cb;
         bool bake;
 #ifdef BAKING_APP
@@ -3,6 +3,8 @@
 #include "apdu_setup.h"
 
 #include "apdu.h"
+#include "apdu_hmac.h"
+#include "baking_auth.h"
 #include "cx.h"
 #include "globals.h"
 #include "keys.h"
@@ -13,76 +15,169 @@
 
 #define G global.apdu.u.setup
 
+#define P1_SETUP_ATTESTED 0x01
+
+// Followed by a BIP32 path, as read by `read_bip32_path`.
 struct setup_wire {
     uint32_t main_chain_id;
     struct {
         uint32_t main;
         uint32_t test;
     } hwm;
-    struct bip32_path_wire bip32_path;
 } __attribute__((packed));
 
-static bool ok(void) {
+// What INS_EXPORT_HWM returns, and INS_SETUP takes before the path with P1_SETUP_ATTESTED.
+struct attested_hwm_wire {
+    uint32_t main_chain_id;
+    uint32_t main_level;
+    uint8_t main_had_endorsement;
+    uint32_t test_level;
+    uint8_t test_had_endorsement;
+    uint8_t hmac[CX_SHA256_SIZE];  // Of the fields above, see `attestation_key_sha256`
+} __attribute__((packed));
+
+#define ATTESTED_SIZE offsetof(struct attested_hwm_wire, hmac)
+
+// SHA256("Tezos baking: attested high watermarks"): not the value of INS_HMAC, which would
+// otherwise attest any watermarks it was sent.
+static uint8_t const attestation_key_sha256[HMAC_KEY_SEED_SIZE] = {
+    0x9f, 0x25, 0x11, 0xfa, 0x41, 0x48, 0xbb, 0x57, 0x7e, 0x34, 0xab, 0x00, 0x0c, 0x1e, 0xa1, 0x25,
+    0x18, 0xac, 0x10, 0x3d, 0x55, 0xf3, 0xbe, 0xf9, 0x88, 0xa4, 0x4d, 0x51, 0xbf, 0xf7, 0xab, 0x7c};
+
+// Writes the HMAC of the ATTESTED_SIZE bytes at `in` under the key at `global.path_with_curve`.
+static void attest(uint8_t *const out, size_t const out_size, uint8_t const *const in) {
+    apdu_hmac_state_t *const state = &global.apdu.u.hmac;
+    memset(state, 0, sizeof(*state));
+    hmac(out,
+         out_size,
+         state,
+         attestation_key_sha256,
+         in,
+         ATTESTED_SIZE,
+         global.path_with_curve.derivation_type);
+}
+
+// Raises `hwm`, attested with `chain` as main chain, to the watermarks `own` has for the chains
+// each of them is to cover, with `main_chain_id` as main chain. That may be another chain, whose
+// watermark then goes to the test chains, and either may be unset, which makes the main watermark
+// cover every chain.
+static void raise_to_own_hwm(high_watermarks_t *const hwm,
+                             chain_id_t const chain,
+                             chain_id_t const main_chain_id,
+                             high_watermarks_t *const own) {
+    hwm->main = higher_hwm(&hwm->main, select_hwm_by_chain(chain, main_chain_id, own));
+    if (chain.v == 0) hwm->main = higher_hwm(&hwm->main, &own->main);
+    hwm->test = higher_hwm(&hwm->test, &own->test);
+    if (main_chain_id.v != chain.v) hwm->test = higher_hwm(&hwm->test, &own->main);
+}
+
+static bool finish_setup(bool const raise_only) {
     UPDATE_NVRAM(ram, {
+        if (raise_only) {
+            raise_to_own_hwm(&G.hwm, G.main_chain_id, ram->main_chain_id, &ram->hwm);
+        }
         copy_bip32_path_with_curve(&ram->baking_key, &global.path_with_curve);
         ram->main_chain_id = G.main_chain_id;
-        ram->hwm.main.highest_level = G.hwm.main;
-        ram->hwm.main.had_endorsement = false;
-        ram->hwm.test.highest_level = G.hwm.test;
-        ram->hwm.test.had_endorsement = false;
+        ram->hwm.main = G.hwm.main;
+        ram->hwm.test = G.hwm.test;
     });
 
-    cx_ecfp_public_key_t pubkey = {0};
-    generate_public_key(&pubkey,
+    cx_ecfp_public_key_t *const pubkey = SCRATCH_BORROW(cx_ecfp_public_key_t);
+    generate_public_key(pubkey,
                         global.path_with_curve.derivation_type,
                         &global.path_with_curve.bip32_path);
-    delayed_send(provide_pubkey(G_io_apdu_buffer, &pubkey));
+    size_t const tx = provide_pubkey(G_io_apdu_buffer, pubkey);
+    SCRATCH_RETURN(pubkey);
+    delayed_send(tx);
     return true;
 }
 
-__attribute__((noreturn)) static void prompt_setup(ui_callback_t const ok_cb,
+static bool ok(void) {
+    return finish_setup(false);
+}
+
+static bool attested_ok(void) {
+    return finish_setup(true);
+}
+
+__attribute__((noreturn)) static void prompt_setup(char const *const what,
+                                                   ui_callback_t const ok_cb,
                                                    ui_callback_t const cxl_cb) {
     init_screen_stack();
-    push_ui_callback("Setup", copy_string, "Baking?");
+    push_ui_callback("Setup", copy_string, what);
     push_ui_callback("Address", bip32_path_with_curve_to_pkh_string, &global.path_with_curve);
     push_ui_callback("Chain", chain_id_to_string_with_aliases, &G.main_chain_id);
-    push_ui_callback("Main Chain HWM", number_to_string_indirect32, &G.hwm.main);
-    push_ui_callback("Test Chain HWM", number_to_string_indirect32, &G.hwm.test);
+    push_ui_callback("Main Chain HWM", number_to_string_indirect32, &G.hwm.main.highest_level);
+    push_ui_callback("Test Chain HWM", number_to_string_indirect32, &G.hwm.test.highest_level);
 
     ux_confirm_screen(ok_cb, cxl_cb);
 }
 
-__attribute__((noreturn)) size_t handle_apdu_setup(__attribute__((unused)) uint8_t instruction) {
-    if (G_io_apdu_buffer[OFFSET_P1] != 0) THROW(EXC_WRONG_PARAM);
+// The watermarks of the attestation, once its HMAC is checked, raised to those of this device:
+// what the prompt shows is what `attested_ok` writes.
+__attribute__((noreturn)) static void setup_attested(struct wire_cursor *const payload) {
+    struct attested_hwm_wire const *const attested = WIRE_TAKE(payload, struct attested_hwm_wire);
+    read_bip32_path(&global.path_with_curve.bip32_path, payload);
+    wire_expect_end(payload);
+
+    uint8_t expected[CX_SHA256_SIZE];
+    attest(expected, sizeof(expected), (uint8_t const *) attested);
+    uint8_t difference = 0;
+    for (size_t i = 0; i < sizeof(expected); i++) difference |= expected[i] ^ attested->hmac[i];
+    if (difference != 0) THROW(EXC_SECURITY);
+
+    memset(&G, 0, sizeof(G));
+    G.main_chain_id.v = WIRE_READ(attested, main_chain_id);
+    G.hwm.main.highest_level = WIRE_READ(attested, main_level);
+    G.hwm.main.had_endorsement = attested->main_had_endorsement != 0;
+    G.hwm.test.highest_level = WIRE_READ(attested, test_level);
+    G.hwm.test.had_endorsement = attested->test_had_endorsement != 0;
+    raise_to_own_hwm(&G.hwm, G.main_chain_id, N_data.main_chain_id, &global.nvram.hwm);
+
+    prompt_setup("Attested HWM?", attested_ok, delay_reject);
+}
 
-    uint32_t const buff_size = G_io_apdu_buffer[OFFSET_LC];
-    if (buff_size < sizeof(struct setup_wire)) THROW(EXC_WRONG_LENGTH_FOR_INS);
+__attribute__((noreturn)) size_t handle_apdu_setup(__attribute__((unused)) uint8_t instruction) {
+    uint8_t const p1 = G_io_apdu_buffer[OFFSET_P1];
+    if (p1 != 0 && p1 != P1_SETUP_ATTESTED) THROW(EXC_WRONG_PARAM);
 
     global.path_with_curve.derivation_type = parse_derivation_type(G_io_apdu_buffer[OFFSET_CURVE]);
 
-    {
-        struct setup_wire const *const buff_as_setup =
-            (struct setup_wire const *) &G_io_apdu_buffer[OFFSET_CDATA];
-
-        size_t consumed = 0;
-        G.main_chain_id.v =
-            CONSUME_UNALIGNED_BIG_ENDIAN(consumed,
-                                         uint32_t,
-                                         (uint8_t const *) &buff_as_setup->main_chain_id);
-        G.hwm.main = CONSUME_UNALIGNED_BIG_ENDIAN(consumed,
-                                                  uint32_t,
-                                                  (uint8_t const *) &buff_as_setup->hwm.main);
-        G.hwm.test = CONSUME_UNALIGNED_BIG_ENDIAN(consumed,
-                                                  uint32_t,
-                                                  (uint8_t const *) &buff_as_setup->hwm.test);
-        consumed += read_bip32_path(&global.path_with_curve.bip32_path,
-                                    (uint8_t const *) &buff_as_setup->bip32_path,
-                                    buff_size - consumed);
-
-        if (consumed != buff_size) THROW(EXC_WRONG_LENGTH);
-    }
-
-    prompt_setup(ok, delay_reject);
+    struct wire_cursor payload = apdu_payload();
+    if (p1 == P1_SETUP_ATTESTED) setup_attested(&payload);
+
+    struct setup_wire const *const setup = WIRE_TAKE(&payload, struct setup_wire);
+    G.main_chain_id.v = WIRE_READ(setup, main_chain_id);
+    G.hwm.main.highest_level = WIRE_READ(setup, hwm.main);
+    G.hwm.main.had_endorsement = false;
+    G.hwm.test.highest_level = WIRE_READ(setup, hwm.test);
+    G.hwm.test.had_endorsement = false;
+    read_bip32_path(&global.path_with_curve.bip32_path, &payload);
+    wire_expect_end(&payload);
+
+    prompt_setup("Baking?", ok, delay_reject);
+}
+
+size_t handle_apdu_export_hwm(__attribute__((unused)) uint8_t instruction) {
+    if (G_io_apdu_buffer[OFFSET_P1] != 0) THROW(EXC_WRONG_PARAM);
+    if (G_io_apdu_buffer[OFFSET_LC] != 0) THROW(EXC_PARSE_ERROR);
+    if (N_data.baking_key.bip32_path.length == 0) THROW(EXC_SECURITY);
+    copy_bip32_path_with_curve(&global.path_with_curve, &N_data.baking_key);
+
+    size_t tx = 0;
+    wire_write_be32(&G_io_apdu_buffer[tx], N_data.main_chain_id.v);
+    tx += sizeof(uint32_t);
+    wire_write_be32(&G_io_apdu_buffer[tx], global.nvram.hwm.main.highest_level);
+    tx += sizeof(uint32_t);
+    G_io_apdu_buffer[tx++] = global.nvram.hwm.main.had_endorsement;
+    wire_write_be32(&G_io_apdu_buffer[tx], global.nvram.hwm.test.highest_level);
+    tx += sizeof(uint32_t);
+    G_io_apdu_buffer[tx++] = global.nvram.hwm.test.had_endorsement;
+    _Static_assert(ATTESTED_SIZE == 14, "The fields of `attested_hwm_wire` are written above");
+
+    attest(&G_io_apdu_buffer[tx], sizeof(G_io_apdu_buffer) - tx, G_io_apdu_buffer);
+    tx += CX_SHA256_SIZE;
+    return finalize_successful_send(tx);
 }
 
 #endif  // #ifdef BAKING_APP
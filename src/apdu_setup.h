@@ -5,6 +5,12 @@
 #include <stddef.h>
 #include <stdint.h>
 
+// With P1_SETUP_ATTESTED, takes the watermarks exported by INS_EXPORT_HWM from a device with the
+// same seed instead of levels, and only ever raises the watermarks it has.
 size_t handle_apdu_setup(uint8_t instruction);
 
+// Returns the watermarks and main chain id with their HMAC under the authorized baking key, for
+// INS_SETUP with P1_SETUP_ATTESTED on a standby device.
+size_t handle_apdu_export_hwm(uint8_t instruction);
+
 #endif  // #ifdef BAKING_APP
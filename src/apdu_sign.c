@@ -1,6 +1,9 @@
 #include "apdu_sign.h"
 
 #include "apdu.h"
+#include "apdu_payout.h"
+#include "apdu_status.h"
+#include "apdu_trace.h"
 #include "baking_auth.h"
 #include "base58.h"
 #include "globals.h"
@@ -17,9 +20,12 @@
 
 #define G global.apdu.u.sign
 
-#define PARSE_ERROR() THROW(EXC_PARSE_ERROR)
-
-#define B2B_BLOCKBYTES 128
+#define PARSE_ERROR()                                              \
+    do {                                                           \
+        status_count_rejection(REJECTED_PARSE);                    \
+        trace(TRACE_PARSE_ERROR, G.parse_state.op_step, __LINE__); \
+        THROW(EXC_PARSE_ERROR);                                    \
+    } while (0)
 
 static inline void conditional_init_hash_state(blake2b_hash_state_t *const state) {
     check_null(state);
@@ -29,47 +35,60 @@ static inline void conditional_init_hash_state(blake2b_hash_state_t *const state
     }
 }
 
+// Hashes `in` after the `*pending_length` bytes in `pending`, except for the last (possibly
+// partial) block, which is left in `pending`: only the last block is hashed with CX_LAST, and it
+// is not known to be the last yet. Whole blocks are hashed straight from `in`.
 static void blake2b_incremental_hash(
-    /*in/out*/ uint8_t *const out,
-    size_t const out_size,
-    /*in/out*/ size_t *const out_length,
+    /*in/out*/ uint8_t *const pending,
+    /*in/out*/ size_t *const pending_length,
+    uint8_t const *in,
+    size_t in_size,
     /*in/out*/ blake2b_hash_state_t *const state) {
-    check_null(out);
-    check_null(out_length);
+    check_null(pending);
+    check_null(pending_length);
     check_null(state);
 
-    uint8_t *current = out;
-    while (*out_length > B2B_BLOCKBYTES) {
-        if (current - out > (int) out_size) THROW(EXC_MEMORY_ERROR);
-        conditional_init_hash_state(state);
-        cx_hash((cx_hash_t *) &state->state, 0, current, B2B_BLOCKBYTES, NULL, 0);
-        *out_length -= B2B_BLOCKBYTES;
-        current += B2B_BLOCKBYTES;
+    if (*pending_length + in_size <= BLAKE2B_BLOCKBYTES) {
+        memcpy(pending + *pending_length, in, in_size);
+        *pending_length += in_size;
+        return;
+    }
+
+    // There is more than a block, so the pending one is not the last.
+    conditional_init_hash_state(state);
+    size_t const fill = BLAKE2B_BLOCKBYTES - *pending_length;
+    memcpy(pending + *pending_length, in, fill);
+    cx_hash((cx_hash_t *) &state->state, 0, pending, BLAKE2B_BLOCKBYTES, NULL, 0);
+    in += fill;
+    in_size -= fill;
+
+    // Keeps 1 to BLAKE2B_BLOCKBYTES bytes back.
+    size_t const whole_blocks = (in_size - 1) / BLAKE2B_BLOCKBYTES * BLAKE2B_BLOCKBYTES;
+    if (whole_blocks != 0) {
+        cx_hash((cx_hash_t *) &state->state, 0, in, whole_blocks, NULL, 0);
     }
-    // TODO use circular buffer at some point
-    memmove(out, current, *out_length);
+    *pending_length = in_size - whole_blocks;
+    memcpy(pending, in + whole_blocks, *pending_length);
 }
 
 static void blake2b_finish_hash(
     /*out*/ uint8_t *const out,
     size_t const out_size,
-    /*in/out*/ uint8_t *const buff,
-    size_t const buff_size,
-    /*in/out*/ size_t *const buff_length,
+    uint8_t const *const pending,
+    size_t const pending_length,
     /*in/out*/ blake2b_hash_state_t *const state) {
     check_null(out);
-    check_null(buff);
-    check_null(buff_length);
+    check_null(pending);
     check_null(state);
 
     conditional_init_hash_state(state);
-    blake2b_incremental_hash(buff, buff_size, buff_length, state);
-    cx_hash((cx_hash_t *) &state->state, CX_LAST, buff, *buff_length, out, out_size);
+    cx_hash((cx_hash_t *) &state->state, CX_LAST, pending, pending_length, out, out_size);
 }
 
 static int perform_signature(bool const on_hash, bool const send_hash);
 
 static inline void clear_data(void) {
+    ux_review_abandon();
     memset(&G, 0, sizeof(G));
 }
 
@@ -91,23 +110,25 @@ static bool sign_reject(void) {
 
 static bool is_operation_allowed(enum operation_tag tag) {
     switch (tag) {
+#ifdef HAVE_ATHENS_OPERATIONS
         case OPERATION_TAG_ATHENS_DELEGATION:
             return true;
         case OPERATION_TAG_ATHENS_REVEAL:
             return true;
+#endif
         case OPERATION_TAG_BABYLON_DELEGATION:
             return true;
         case OPERATION_TAG_BABYLON_REVEAL:
             return true;
-#ifndef BAKING_APP
+#ifdef HAVE_WALLET
         case OPERATION_TAG_PROPOSAL:
             return true;
         case OPERATION_TAG_BALLOT:
             return true;
-        case OPERATION_TAG_ATHENS_ORIGINATION:
-            return true;
+#ifdef HAVE_ATHENS_OPERATIONS
         case OPERATION_TAG_ATHENS_TRANSACTION:
             return true;
+#endif
         case OPERATION_TAG_BABYLON_ORIGINATION:
             return true;
         case OPERATION_TAG_BABYLON_TRANSACTION:
@@ -131,7 +152,9 @@ static bool parse_allowed_operations(struct parsed_operation_group *const out,
                             &is_operation_allowed);
 }
 
-#else
+#endif
+
+#ifdef HAVE_WALLET
 
 static bool parse_allowed_operation_packet(struct parsed_operation_group *const out,
                                            uint8_t const *const in,
@@ -168,6 +191,7 @@ size_t baking_sign_complete(bool const send_hash) {
 
             // Must be self-delegation signed by the *authorized* baking key
             if (bip32_path_with_curve_eq(&global.path_with_curve, &N_data.baking_key) &&
+                G.maybe_ops.v.batch.all.operation_count == 1 &&
 
                 // ops->signing is generated from G.bip32_path and G.curve
                 COMPARE(&G.maybe_ops.v.operation.source, &G.maybe_ops.v.signing) == 0 &&
@@ -178,51 +202,82 @@ size_t baking_sign_complete(bool const send_hash) {
             THROW(EXC_SECURITY);
             break;
         }
-        case MAGIC_BYTE_UNSAFE_OP2:
         case MAGIC_BYTE_UNSAFE_OP3:
         default:
             PARSE_ERROR();
     }
 }
 
-#else  // ifdef BAKING_APP -----------------------------------------------------
+#endif  // ifdef BAKING_APP -----------------------------------------------------
+
+#ifdef HAVE_WALLET  // ---------------------------------------------------------
 
 static bool sign_unsafe_ok(void) {
     delayed_send(perform_signature(false, false));
     return true;
 }
 
+// Only known once the last packet is in, which a review started early may not have waited for.
+static void final_hash_to_string(char *const out, size_t const out_size, void const *const data) {
+    if (G.early_review == EARLY_REVIEW_RECEIVING) {
+        copy_string(out, out_size, "(receiving)");
+    } else {
+        buffer_to_base58(out, out_size, data);
+    }
+}
+
+// Pushes the hash of the operation, for operations the screens can only partly describe.
+static void push_hash_screen(void) {
+    G.message_data_as_buffer.bytes = (uint8_t *) &G.final_hash;
+    G.message_data_as_buffer.size = sizeof(G.final_hash);
+    G.message_data_as_buffer.length = sizeof(G.final_hash);
+    // Base58 encoding of 32-byte hash is 43 bytes long.
+    push_ui_callback("Sign Hash", final_hash_to_string, &G.message_data_as_buffer);
+}
+
 #define MAX_NUMBER_CHARS (MAX_INT_DIGITS + 2)  // include decimal point and terminating null
 
-bool prompt_transaction(struct parsed_operation_group const *const ops,
-                        bip32_path_with_curve_t const *const key,
-                        ui_callback_t ok,
-                        ui_callback_t cxl) {
-    check_null(ops);
-    check_null(key);
+static void push_batch_screens(struct parsed_operation_group const *const ops) {
+    struct parsed_batch const *const batch = &ops->batch;
 
-    if (called_from_swap) {
-        if (is_safe_to_swap() == true) {
-            // We're called from swap and we've verified that the data is correct. Sign it.
-            ok();
-            // Clear all data.
-            clear_data();
-            // Exit properly.
-            os_sched_exit(0);
+    push_ui_callback("Confirm Batch", batch_total_to_string, &batch->all);
+    push_ui_callback("Fee", microtez_to_string_indirect, &ops->total_fee);
+    // The source of every batched operation was checked to be the signing key.
+    push_ui_callback("Source", parsed_contract_to_string, &ops->signing);
+    push_ui_callback("Storage Limit", number_to_string_indirect64, &ops->total_storage_limit);
+
+    for (size_t i = 0; i < batch->destination_count; i++) {
+        struct batch_destination const *const entry = &batch->destinations[i];
+        if (entry->is_delegation) {
+            push_ui_callback("Delegate", parsed_contract_to_string, &entry->destination);
+            push_ui_callback("Delegate Name", lookup_parsed_contract_name, &entry->destination);
         } else {
-            // Send the error message back in response.
-            cxl();
-            // Exit with error code.
-            os_sched_exit(1);
+            push_ui_callback("Amount", batch_total_to_string, &entry->total);
+            push_ui_callback("Destination", parsed_contract_to_string, &entry->destination);
         }
     }
+}
+
+// Whether every destination of the group gets a screen of its own: the screens cannot be trusted
+// to describe a batch whose further destinations were only summed up in `others`.
+static bool is_fully_listed(struct parsed_operation_group const *const ops) {
+    return ops->batch.others.operation_count == 0;
+}
+
+// Pushes the review screens of a parsed operation group onto a fresh screen stack.
+static void push_operation_screens(struct parsed_operation_group const *const ops) {
+    init_screen_stack();
+
+    if (ops->batch.all.operation_count > 1) {
+        push_batch_screens(ops);
+        return;
+    }
 
     switch (ops->operation.tag) {
         default:
             PARSE_ERROR();
 
-        case OPERATION_TAG_PROPOSAL: {
-            init_screen_stack();
+        case OPERATION_TAG_PROPOSAL:
             push_ui_callback("Confirm", copy_string, "Proposal");
             push_ui_callback("Source", parsed_contract_to_string, &ops->operation.source);
             push_ui_callback("Period",
@@ -231,9 +286,7 @@ bool prompt_transaction(struct parsed_operation_group const *const ops,
             push_ui_callback("Protocol",
                              protocol_hash_to_string,
                              ops->operation.proposal.protocol_hash);
-
-            ux_confirm_screen(ok, cxl);
-        }
+            break;
 
         case OPERATION_TAG_BALLOT: {
             char *vote;
@@ -250,7 +303,6 @@ bool prompt_transaction(struct parsed_operation_group const *const ops,
                     break;
             }
 
-            init_screen_stack();
             push_ui_callback("Confirm Vote", copy_string, vote);
             push_ui_callback("Source", parsed_contract_to_string, &ops->operation.source);
             push_ui_callback("Protocol",
@@ -259,46 +311,34 @@ bool prompt_transaction(struct parsed_operation_group const *const ops,
             push_ui_callback("Period",
                              number_to_string_indirect32,
                              &ops->operation.ballot.voting_period);
-
-            ux_confirm_screen(ok, cxl);
+            break;
         }
 
-        case OPERATION_TAG_ATHENS_ORIGINATION:
-        case OPERATION_TAG_BABYLON_ORIGINATION: {
-            if (!(ops->operation.flags & ORIGINATION_FLAG_SPENDABLE)) return false;
-
-            init_screen_stack();
+        case OPERATION_TAG_BABYLON_ORIGINATION:
+            // The script is not parsed, so the hash stands in for it.
             push_ui_callback("Confirm", copy_string, "Origination");
             push_ui_callback("Amount", microtez_to_string_indirect, &ops->operation.amount);
             push_ui_callback("Fee", microtez_to_string_indirect, &ops->total_fee);
             push_ui_callback("Source", parsed_contract_to_string, &ops->operation.source);
-            push_ui_callback("Manager", parsed_contract_to_string, &ops->operation.destination);
-
-            bool const delegatable = ops->operation.flags & ORIGINATION_FLAG_DELEGATABLE;
-            bool const has_delegate =
-                ops->operation.delegate.signature_type != SIGNATURE_TYPE_UNSET;
-            if (delegatable && has_delegate) {
+            if (ops->operation.delegate.kind != CONTRACT_NONE) {
                 push_ui_callback("Delegate", parsed_contract_to_string, &ops->operation.delegate);
-            } else if (delegatable && !has_delegate) {
-                push_ui_callback("Delegate", copy_string, "Any");
-            } else if (!delegatable && has_delegate) {
-                push_ui_callback("Fixed Delegate",
-                                 parsed_contract_to_string,
-                                 &ops->operation.delegate);
-            } else if (!delegatable && !has_delegate) {
-                push_ui_callback("Delegation", copy_string, "Disabled");
+            } else {
+                push_ui_callback("Delegate", copy_string, "None");
             }
             push_ui_callback("Storage Limit",
                              number_to_string_indirect64,
                              &ops->total_storage_limit);
+            push_ui_callback("Script",
+                             byte_count_to_string_indirect32,
+                             &ops->operation.skipped_length);
+            push_hash_screen();
+            break;
 
-            ux_confirm_screen(ok, cxl);
-        }
+#ifdef HAVE_ATHENS_OPERATIONS
         case OPERATION_TAG_ATHENS_DELEGATION:
+#endif
         case OPERATION_TAG_BABYLON_DELEGATION: {
-            bool const withdrawal =
-                ops->operation.destination.originated == 0 &&
-                ops->operation.destination.signature_type == SIGNATURE_TYPE_UNSET;
+            bool const withdrawal = ops->operation.destination.kind == CONTRACT_NONE;
 
             char *type_msg;
             if (withdrawal) {
@@ -306,7 +346,6 @@ bool prompt_transaction(struct parsed_operation_group const *const ops,
             } else {
                 type_msg = "Confirm";
             }
-            init_screen_stack();
             push_ui_callback(type_msg, copy_string, "Delegation");
 
             push_ui_callback("Fee", microtez_to_string_indirect, &ops->total_fee);
@@ -318,13 +357,32 @@ bool prompt_transaction(struct parsed_operation_group const *const ops,
             push_ui_callback("Storage Limit",
                              number_to_string_indirect64,
                              &ops->total_storage_limit);
-
-            ux_confirm_screen(ok, cxl);
+            break;
         }
 
+#ifdef HAVE_ATHENS_OPERATIONS
         case OPERATION_TAG_ATHENS_TRANSACTION:
-        case OPERATION_TAG_BABYLON_TRANSACTION: {
-            init_screen_stack();
+#endif
+        case OPERATION_TAG_BABYLON_TRANSACTION:
+            if (ops->operation.is_contract_call) {
+                // The parameters are not parsed, so the hash stands in for them.
+                push_ui_callback("Confirm", copy_string, "Contract Call");
+                push_ui_callback("Amount", microtez_to_string_indirect, &ops->operation.amount);
+                push_ui_callback("Fee", microtez_to_string_indirect, &ops->total_fee);
+                push_ui_callback("Source", parsed_contract_to_string, &ops->operation.source);
+                push_ui_callback("Destination",
+                                 parsed_contract_to_string,
+                                 &ops->operation.destination);
+                push_ui_callback("Entrypoint", copy_string, ops->operation.entrypoint);
+                push_ui_callback("Parameters",
+                                 byte_count_to_string_indirect32,
+                                 &ops->operation.skipped_length);
+                push_ui_callback("Storage Limit",
+                                 number_to_string_indirect64,
+                                 &ops->total_storage_limit);
+                push_hash_screen();
+                break;
+            }
             push_ui_callback("Confirm", copy_string, "Transaction");
             push_ui_callback("Amount", microtez_to_string_indirect, &ops->operation.amount);
             push_ui_callback("Fee", microtez_to_string_indirect, &ops->total_fee);
@@ -333,21 +391,66 @@ bool prompt_transaction(struct parsed_operation_group const *const ops,
             push_ui_callback("Storage Limit",
                              number_to_string_indirect64,
                              &ops->total_storage_limit);
+            break;
 
-            ux_confirm_screen(ok, cxl);
-        }
-        case OPERATION_TAG_NONE: {
-            init_screen_stack();
+        case OPERATION_TAG_NONE:
             push_ui_callback("Reveal Key", copy_string, "To Blockchain");
             push_ui_callback("Key", parsed_contract_to_string, &ops->operation.source);
             push_ui_callback("Fee", microtez_to_string_indirect, &ops->total_fee);
             push_ui_callback("Storage Limit",
                              number_to_string_indirect64,
                              &ops->total_storage_limit);
+            break;
+    }
+}
 
-            ux_confirm_screen(ok, cxl);
+bool prompt_transaction(struct parsed_operation_group const *const ops,
+                        bip32_path_with_curve_t const *const key,
+                        ui_callback_t ok,
+                        ui_callback_t cxl) {
+    check_null(ops);
+    check_null(key);
+
+    if (called_from_swap) {
+        if (is_safe_to_swap() == true) {
+            // We're called from swap and we've verified that the data is correct. Sign it.
+            ok();
+            // Clear all data.
+            clear_data();
+            // Exit properly.
+            os_sched_exit(0);
+        } else {
+            // Send the error message back in response.
+            cxl();
+            // Exit with error code.
+            os_sched_exit(1);
         }
     }
+
+    if (!is_fully_listed(ops)) return false;  // Only its hash is shown
+    push_operation_screens(ops);
+    ux_confirm_screen(ok, cxl);
+}
+
+static bool early_review_reject(void) {
+    clear_data();
+    G.early_review = EARLY_REVIEW_REJECTED;
+    return true;  // Return to idle
+}
+
+// Starts the review of an operation group before its last packet, once the parser has read
+// everything the screens show; the rest is opaque data that is only hashed. The user reads the
+// screens while the remaining packets come in, and can only accept once all of them are in.
+static void start_early_review(void) {
+    if (G.early_review != EARLY_REVIEW_NONE || G.hash_only || called_from_swap) return;
+    if (!parse_operations_fields_final(&G.parse_state)) return;
+    if (!is_fully_listed(&G.maybe_ops.v)) return;
+    // A payout policy may sign the group without a prompt.
+    if (global.payout_policy.remaining_operations != 0) return;
+
+    G.early_review = EARLY_REVIEW_RECEIVING;
+    push_operation_screens(&G.maybe_ops.v);
+    ux_review_screen(early_review_reject);
 }
 
 static size_t wallet_sign_complete(uint8_t instruction, uint8_t magic_byte) {
@@ -359,6 +462,13 @@ static size_t wallet_sign_complete(uint8_t instruction, uint8_t magic_byte) {
     }
 
     if (instruction == INS_SIGN_UNSAFE) {
+#ifdef BAKING_APP
+        // The hash could be that of a block or an endorsement, which the baking key only signs
+        // under its high watermark.
+        if (bip32_path_with_curve_eq(&global.path_with_curve, &N_data.baking_key)) {
+            THROW(EXC_SECURITY);
+        }
+#endif
         G.message_data_as_buffer.bytes = (uint8_t *) &G.message_data;
         G.message_data_as_buffer.size = sizeof(G.message_data);
         G.message_data_as_buffer.length = G.message_data_length;
@@ -377,6 +487,14 @@ static size_t wallet_sign_complete(uint8_t instruction, uint8_t magic_byte) {
             default:
                 PARSE_ERROR();
             case MAGIC_BYTE_UNSAFE_OP:
+                if (G.early_review == EARLY_REVIEW_COMPLETE && G.maybe_ops.is_valid) {
+                    ux_review_ready(ok_c, sign_reject);  // The screens shown were final
+                }
+                if (G.maybe_ops.is_valid && !G.hash_only &&
+                    payout_policy_consume(&G.maybe_ops.v, &global.path_with_curve)) {
+                    ui_initial_screen();  // Show what is left of the policy
+                    return perform_signature(true, instruction == INS_SIGN_WITH_HASH);
+                }
                 if (!G.maybe_ops.is_valid || !prompt_transaction(&G.maybe_ops.v,
                                                                  &global.path_with_curve,
                                                                  ok_c,
@@ -384,23 +502,18 @@ static size_t wallet_sign_complete(uint8_t instruction, uint8_t magic_byte) {
                     goto unsafe;
                 }
 
-            case MAGIC_BYTE_UNSAFE_OP2:
             case MAGIC_BYTE_UNSAFE_OP3:
                 goto unsafe;
         }
     unsafe:
-        G.message_data_as_buffer.bytes = (uint8_t *) &G.final_hash;
-        G.message_data_as_buffer.size = sizeof(G.final_hash);
-        G.message_data_as_buffer.length = sizeof(G.final_hash);
         init_screen_stack();
-        // Base58 encoding of 32-byte hash is 43 bytes long.
         push_ui_callback("Unrecognized", copy_string, ops);
-        push_ui_callback("Sign Hash", buffer_to_base58, &G.message_data_as_buffer);
+        push_hash_screen();
         ux_confirm_screen(ok_c, sign_reject);
     }
 }
 
-#endif  // ifdef BAKING_APP ----------------------------------------------------
+#endif  // ifdef HAVE_WALLET ---------------------------------------------------
 
 #define P1_FIRST          0x00
 #define P1_NEXT           0x01
@@ -413,19 +526,67 @@ static uint8_t get_magic_byte_or_throw(uint8_t const *const buff, size_t const b
 #ifdef BAKING_APP
         case MAGIC_BYTE_BLOCK:
         case MAGIC_BYTE_BAKING_OP:
-        case MAGIC_BYTE_UNSAFE_OP:  // Only for self-delegations
-#else
-        case MAGIC_BYTE_UNSAFE_OP:
+#endif
+#ifdef HAVE_WALLET
         case MAGIC_BYTE_UNSAFE_OP3:
 #endif
+        case MAGIC_BYTE_UNSAFE_OP:  // The baking app alone only signs self-delegations
             return magic_byte;
 
-        case MAGIC_BYTE_UNSAFE_OP2:
-        default:
+        default:  // Including MAGIC_BYTE_UNSAFE_OP2, which nothing signs
             PARSE_ERROR();
     }
 }
 
+// Never returns 0, which marks the absence of a session.
+static uint8_t next_session_id(void) {
+    global.last_sign_session_id++;
+    if (global.last_sign_session_id == 0) global.last_sign_session_id++;
+    return global.last_sign_session_id;
+}
+
+// Intermediate packets are acknowledged with the session id so the host can tell that the
+// session it is streaming into is still the one it started.
+static size_t send_session_id(void) {
+    size_t tx = 0;
+    G_io_apdu_buffer[tx++] = G.session_id;
+    return finalize_successful_send(tx);
+}
+
+#ifdef BAKING_APP
+static void parse_baking_packet(uint8_t const *const buff, size_t const buff_size) {
+    if (G.packet_index != 1) PARSE_ERROR();  // Only parse a single packet when baking
+
+    if (G.magic_byte == MAGIC_BYTE_UNSAFE_OP) {
+        // Parse the operation. It will be verified in `baking_sign_complete`.
+        G.maybe_ops.is_valid =
+            parse_allowed_operations(&G.maybe_ops.v, buff, buff_size, &global.path_with_curve);
+    } else {
+        // This should be a baking operation so parse it.
+        if (!parse_baking_data(&G.parsed_baking_data, buff, buff_size)) PARSE_ERROR();
+    }
+}
+#endif
+
+#ifdef HAVE_WALLET
+static void parse_wallet_packet(uint8_t const *const buff, size_t const buff_size) {
+    // If it is an "operation" (starting with the 0x03 magic byte), set up parsing
+    // If it is arbitrary Michelson (starting with 0x05), dont bother parsing and show
+    // the "Sign Hash" prompt
+    if (G.packet_index == 1 && G.magic_byte == MAGIC_BYTE_UNSAFE_OP) {
+        parse_operations_init(&G.maybe_ops.v,
+                              global.path_with_curve.derivation_type,
+                              &global.path_with_curve.bip32_path,
+                              &G.parse_state);
+    }
+
+    // Only parse if the message is an "Operation"
+    if (G.magic_byte == MAGIC_BYTE_UNSAFE_OP) {
+        parse_allowed_operation_packet(&G.maybe_ops.v, buff, buff_size);
+    }
+}
+#endif
+
 static size_t handle_apdu(bool const enable_hashing,
                           bool const enable_parsing,
                           uint8_t const instruction) {
@@ -436,23 +597,30 @@ static size_t handle_apdu(bool const enable_hashing,
 
     bool last = (p1 & P1_LAST_MARKER) != 0;
     switch (p1 & ~P1_LAST_MARKER) {
-        case P1_FIRST:
+        case P1_FIRST: {
             clear_data();
-            read_bip32_path(&global.path_with_curve.bip32_path, buff, buff_size);
+            struct wire_cursor payload = apdu_payload();
+            read_bip32_path(&global.path_with_curve.bip32_path, &payload);
             global.path_with_curve.derivation_type =
                 parse_derivation_type(G_io_apdu_buffer[OFFSET_CURVE]);
-            return finalize_successful_send(0);
-#ifndef BAKING_APP
+            G.session_id = next_session_id();
+            return send_session_id();
+        }
+#ifdef HAVE_WALLET
         case P1_HASH_ONLY_NEXT:
             // This is a debugging Easter egg
             G.hash_only = true;
             // FALL THROUGH
 #endif
         case P1_NEXT:
+            if (G.early_review == EARLY_REVIEW_REJECTED) THROW(EXC_REJECT);
             if (global.path_with_curve.bip32_path.length == 0) THROW(EXC_WRONG_LENGTH_FOR_INS);
+            // The session was ended (by an error or another instruction) since P1_FIRST.
+            if (G.session_id == 0) THROW(EXC_WRONG_LENGTH_FOR_INS);
 
-            // Guard against overflow
-            if (G.packet_index >= 0xFF) PARSE_ERROR();
+            // Guard against overflow. Hashing only keeps the unhashed tail of the message, so
+            // this is the only limit on the length of what can be signed.
+            if (G.packet_index == UINT32_MAX) PARSE_ERROR();
             G.packet_index++;
 
             break;
@@ -461,84 +629,68 @@ static size_t handle_apdu(bool const enable_hashing,
     }
 
     if (enable_parsing) {
-#ifdef BAKING_APP
-        if (G.packet_index != 1) PARSE_ERROR();  // Only parse a single packet when baking
-
-        G.magic_byte = get_magic_byte_or_throw(buff, buff_size);
-        if (G.magic_byte == MAGIC_BYTE_UNSAFE_OP) {
-            // Parse the operation. It will be verified in `baking_sign_complete`.
-            G.maybe_ops.is_valid =
-                parse_allowed_operations(&G.maybe_ops.v, buff, buff_size, &global.path_with_curve);
-        } else {
-            // This should be a baking operation so parse it.
-            if (!parse_baking_data(&G.parsed_baking_data, buff, buff_size)) PARSE_ERROR();
-        }
-#else
         if (G.packet_index == 1) {
             G.maybe_ops.is_valid = false;
             G.magic_byte = get_magic_byte_or_throw(buff, buff_size);
-
-            // If it is an "operation" (starting with the 0x03 magic byte), set up parsing
-            // If it is arbitrary Michelson (starting with 0x05), dont bother parsing and show
-            // the "Sign Hash" prompt
-            if (G.magic_byte == MAGIC_BYTE_UNSAFE_OP) {
-                parse_operations_init(&G.maybe_ops.v,
-                                      global.path_with_curve.derivation_type,
-                                      &global.path_with_curve.bip32_path,
-                                      &G.parse_state);
-            }
-            // If magic byte is not 0x03 or 0x05, fail
-            else if (G.magic_byte != MAGIC_BYTE_UNSAFE_OP3) {
-                PARSE_ERROR();
-            }
         }
-
-        // Only parse if the message is an "Operation"
-        if (G.magic_byte == MAGIC_BYTE_UNSAFE_OP) {
-            parse_allowed_operation_packet(&G.maybe_ops.v, buff, buff_size);
+#if defined(BAKING_APP) && defined(HAVE_WALLET)
+        if (is_baking_magic_byte(G.magic_byte)) {
+            parse_baking_packet(buff, buff_size);
+        } else {
+            parse_wallet_packet(buff, buff_size);
         }
-
+#elif defined(BAKING_APP)
+        parse_baking_packet(buff, buff_size);
+#else
+        parse_wallet_packet(buff, buff_size);
 #endif
     }
 
     if (enable_hashing) {
-        // Hash contents of *previous* message (which may be empty).
+        uint32_t const started = status_clock();
         blake2b_incremental_hash(G.message_data,
-                                 sizeof(G.message_data),
                                  &G.message_data_length,
+                                 buff,
+                                 buff_size,
                                  &G.hash_state);
+        status_phase_end(PHASE_HASHING, started);
+    } else {
+        // Signed as is, so it must fit whole.
+        if (G.message_data_length + buff_size > sizeof(G.message_data)) PARSE_ERROR();
+        memmove(G.message_data + G.message_data_length, buff, buff_size);
+        G.message_data_length += buff_size;
     }
 
-    if (G.message_data_length + buff_size > sizeof(G.message_data)) PARSE_ERROR();
-
-    memmove(G.message_data + G.message_data_length, buff, buff_size);
-    G.message_data_length += buff_size;
-
     if (last) {
         if (enable_hashing) {
-            // Hash contents of *this* message and then get the final hash value.
-            blake2b_incremental_hash(G.message_data,
-                                     sizeof(G.message_data),
-                                     &G.message_data_length,
-                                     &G.hash_state);
+            uint32_t const started = status_clock();
             blake2b_finish_hash(G.final_hash,
                                 sizeof(G.final_hash),
                                 G.message_data,
-                                sizeof(G.message_data),
-                                &G.message_data_length,
+                                G.message_data_length,
                                 &G.hash_state);
+            status_phase_end(PHASE_HASHING, started);
         }
 
         G.maybe_ops.is_valid = parse_operations_final(&G.parse_state, &G.maybe_ops.v);
+        if (G.early_review == EARLY_REVIEW_RECEIVING) G.early_review = EARLY_REVIEW_COMPLETE;
 
-        return
-#ifdef BAKING_APP
-            baking_sign_complete(instruction == INS_SIGN_WITH_HASH);
+#if defined(BAKING_APP) && defined(HAVE_WALLET)
+        // Pre-hashed messages have no magic byte and always take the wallet's path.
+        if (is_baking_magic_byte(G.magic_byte)) {
+            return baking_sign_complete(instruction == INS_SIGN_WITH_HASH);
+        }
+        return wallet_sign_complete(instruction, G.magic_byte);
+#elif defined(BAKING_APP)
+        return baking_sign_complete(instruction == INS_SIGN_WITH_HASH);
 #else
-            wallet_sign_complete(instruction, G.magic_byte);
+        return wallet_sign_complete(instruction, G.magic_byte);
 #endif
     } else {
-        return finalize_successful_send(0);
+#ifdef HAVE_WALLET
+        if (enable_parsing && G.magic_byte == MAGIC_BYTE_UNSAFE_OP) start_early_review();
+#endif
+        return send_session_id();
     }
 }
 
@@ -555,15 +707,21 @@ size_t handle_apdu_sign_with_hash(uint8_t instruction) {
 }
 
 static int perform_signature(bool const on_hash, bool const send_hash) {
-#ifdef BAKING_APP
-    write_high_water_mark(&G.parsed_baking_data);
-#else
+#ifdef HAVE_WALLET
     if (on_hash && G.hash_only) {
         memcpy(G_io_apdu_buffer, G.final_hash, sizeof(G.final_hash));
         clear_data();
         return finalize_successful_send(sizeof(G.final_hash));
     }
 #endif
+#if defined(BAKING_APP) && defined(HAVE_WALLET)
+    // Only blocks and endorsements move the high watermark.
+    if (is_baking_magic_byte(G.magic_byte)) {
+        write_high_water_mark(&G.parsed_baking_data, G.final_hash);
+    }
+#elif defined(BAKING_APP)
+    write_high_water_mark(&G.parsed_baking_data, G.final_hash);
+#endif
 
     size_t tx = 0;
     if (send_hash && on_hash) {
@@ -574,40 +732,19 @@ static int perform_signature(bool const on_hash, bool const send_hash) {
     uint8_t const *const data = on_hash ? G.final_hash : G.message_data;
     size_t const data_length = on_hash ? sizeof(G.final_hash) : G.message_data_length;
 
-    key_pair_t key_pair = {0};
     size_t signature_size = 0;
-
-    int error = generate_key_pair(&key_pair,
-                                  global.path_with_curve.derivation_type,
-                                  &global.path_with_curve.bip32_path);
-    if (error) {
-        THROW(EXC_WRONG_VALUES);
-    }
-
-    error = 0;
-    BEGIN_TRY {
-        TRY {
-            signature_size = sign(&G_io_apdu_buffer[tx],
-                                  MAX_SIGNATURE_SIZE,
-                                  global.path_with_curve.derivation_type,
-                                  &key_pair,
-                                  data,
-                                  data_length);
-        }
-        CATCH_OTHER(e) {
-            error = e;
-        }
-        FINALLY {
-            memset(&key_pair, 0, sizeof(key_pair));
-        }
-    }
-    END_TRY
-
-    if (error) {
-        THROW(error);
-    }
+    int const error = generate_signature(&G_io_apdu_buffer[tx],
+                                         MAX_SIGNATURE_SIZE,
+                                         &signature_size,
+                                         global.path_with_curve.derivation_type,
+                                         &global.path_with_curve.bip32_path,
+                                         data,
+                                         data_length);
+    if (error) THROW(error);
 
     tx += signature_size;
+    status_count_signature(G.magic_byte);
+    trace(TRACE_SIGNED, G.parse_state.op_step, G.magic_byte << 8 | signature_size);
 
     clear_data();
     return finalize_successful_send(tx);
@@ -0,0 +1,65 @@
+#include "apdu_stack.h"
+
+#ifdef HAVE_STACK_TELEMETRY
+
+#include "apdu.h"
+#include "globals.h"
+
+#define STACK_PAINT 0xA5A5A5A5u
+
+// Left alone below the frame of the painter, which may keep data there (x86 hosts have a red zone).
+#define STACK_PAINT_MARGIN 256
+
+static uint32_t volatile *stack_bottom(void) {
+    return (uint32_t volatile *) (&app_stack_canary + 1);
+}
+
+// Not inlined, so that the margin is measured from a frame of its own. The stores are volatile, so
+// that the loop does not become a call to memset, whose frame would be painted over.
+static __attribute__((noinline)) void paint_from(uint32_t volatile *word) {
+    uint8_t here;
+    uintptr_t const end = ((uintptr_t) &here - STACK_PAINT_MARGIN) & ~(uintptr_t) 3;
+    for (; (uintptr_t) word < end; word++) *word = STACK_PAINT;
+}
+
+void stack_paint(void) {
+    paint_from(stack_bottom());
+    global.stack_telemetry.instruction = INS_MAX + 1;
+}
+
+void stack_record(void) {
+    struct stack_telemetry *const telemetry = &global.stack_telemetry;
+
+    // Our own frame is not painted, so this stops.
+    uint32_t volatile *deepest = stack_bottom();
+    while (*deepest == STACK_PAINT) deepest++;
+
+    if (telemetry->instruction <= INS_MAX) {
+        size_t const depth = (uint8_t *) global.stack_root - (uint8_t volatile *) deepest;
+        uint16_t *const peak = &telemetry->peak[telemetry->instruction];
+        if (depth > *peak) *peak = depth > UINT16_MAX ? UINT16_MAX : depth;
+    }
+    telemetry->instruction = INS_MAX + 1;
+
+    paint_from(deepest);
+}
+
+void stack_start(uint8_t const instruction) {
+    global.stack_telemetry.instruction = instruction;
+}
+
+size_t handle_apdu_query_stack(__attribute__((unused)) uint8_t instruction) {
+    if (G_io_apdu_buffer[OFFSET_P1] != 0) THROW(EXC_WRONG_PARAM);
+
+    size_t const size = (uint8_t *) global.stack_root - (uint8_t volatile *) stack_bottom();
+    size_t tx = 0;
+    wire_write_be16(&G_io_apdu_buffer[tx], size > UINT16_MAX ? UINT16_MAX : size);
+    tx += sizeof(uint16_t);
+    for (size_t i = 0; i < NUM_ELEMENTS(global.stack_telemetry.peak); i++) {
+        wire_write_be16(&G_io_apdu_buffer[tx], global.stack_telemetry.peak[i]);
+        tx += sizeof(uint16_t);
+    }
+    return finalize_successful_send(tx);
+}
+
+#endif  // #ifdef HAVE_STACK_TELEMETRY
@@ -0,0 +1,27 @@
+#pragma once
+
+#ifdef HAVE_STACK_TELEMETRY
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Measuring how close each instruction comes to overflowing the stack. The free part of the stack
+// is painted with a pattern at boot; before each APDU, `main_loop` looks for the deepest word the
+// previous one overwrote, prompt callbacks included, records it as the peak of that instruction and
+// paints it over again.
+
+// Paints the stack from `app_stack_canary` up to a little below the frame of the caller.
+void stack_paint(void);
+
+// Records the depth the stack reached since it was painted against the instruction it was last
+// told about with `stack_start`, and paints it again.
+void stack_record(void);
+
+// The instruction the stack is used for from now on, until the next `stack_record`.
+void stack_start(uint8_t instruction);
+
+// Returns the size of the stack, then the peak of each instruction code up to INS_MAX, all as
+// big-endian 16-bit numbers of bytes. Peaks count from `global.stack_root`.
+size_t handle_apdu_query_stack(uint8_t instruction);
+
+#endif  // #ifdef HAVE_STACK_TELEMETRY
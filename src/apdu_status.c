@@ -0,0 +1,84 @@
+#include "apdu_status.h"
+
+#include "apdu.h"
+#include "globals.h"
+#include "keys.h"
+
+#define S global.status
+
+#ifdef HAVE_PHASE_TIMES
+void status_phase_end(enum status_phase const phase, uint32_t const started) {
+    struct status_phase_time *const time = &S.phases[phase];
+    uint32_t const elapsed = status_clock() - started;
+    time->count++;
+    time->total += elapsed;
+    if (elapsed > time->max) time->max = elapsed;
+}
+#endif
+
+void status_count_signature(uint8_t const magic_byte) {
+    S.signatures[magic_byte < NUM_ELEMENTS(S.signatures) ? magic_byte : MAGIC_BYTE_INVALID]++;
+}
+
+void status_count_rejection(enum status_rejection const reason) {
+    S.rejections[reason]++;
+}
+
+void status_count_nvram_write(size_t const size, uint32_t const started) {
+    status_phase_end(PHASE_NVRAM, started);
+    S.nvram_writes++;
+    S.nvram_bytes += size;
+}
+
+void status_prompt_shown(void) {
+#ifdef HAVE_PHASE_TIMES
+    S.prompt_shown_at = status_clock();
+#endif
+}
+
+void status_prompt_answered(bool const accepted) {
+#ifdef HAVE_PHASE_TIMES
+    status_phase_end(PHASE_UI, S.prompt_shown_at);
+#endif
+    if (!accepted) status_count_rejection(REJECTED_USER);
+}
+
+static size_t send_word(size_t const tx, uint32_t const word) {
+    wire_write_be32(&G_io_apdu_buffer[tx], word);
+    return tx + sizeof(word);
+}
+
+size_t handle_apdu_query_status(__attribute__((unused)) uint8_t instruction) {
+    if (G_io_apdu_buffer[OFFSET_P1] != 0) THROW(EXC_WRONG_PARAM);
+
+    size_t tx = 0;
+    tx = send_word(tx, S.apdus);
+    for (size_t i = 0; i < NUM_ELEMENTS(S.signatures); i++) tx = send_word(tx, S.signatures[i]);
+    for (size_t i = 0; i < NUM_ELEMENTS(S.rejections); i++) tx = send_word(tx, S.rejections[i]);
+    tx = send_word(tx, S.nvram_writes);
+    tx = send_word(tx, S.nvram_bytes);
+#ifdef HAVE_PHASE_TIMES
+    for (size_t i = 0; i < NUM_ELEMENTS(S.phases); i++) {
+        tx = send_word(tx, S.phases[i].count);
+        tx = send_word(tx, S.phases[i].total);
+        tx = send_word(tx, S.phases[i].max);
+    }
+#endif
+
+#ifdef BAKING_APP
+    tx = send_word(tx, N_data.main_chain_id.v);
+    tx = send_word(tx, global.nvram.hwm.main.highest_level);
+    G_io_apdu_buffer[tx++] = global.nvram.hwm.main.had_endorsement;
+    tx = send_word(tx, global.nvram.hwm.test.highest_level);
+    G_io_apdu_buffer[tx++] = global.nvram.hwm.test.had_endorsement;
+
+    uint8_t const length = N_data.baking_key.bip32_path.length;
+    G_io_apdu_buffer[tx++] = unparse_derivation_type(N_data.baking_key.derivation_type);
+    G_io_apdu_buffer[tx++] = length;
+    for (uint8_t i = 0; i < length; ++i) {
+        tx = send_word(tx, N_data.baking_key.bip32_path.components[i]);
+    }
+#endif
+
+    return finalize_successful_send(tx);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "protocol.h"
+
+// Counters since the app started, for monitoring a device that signs unattended. They are kept in
+// RAM only and survive clear_apdu_globals. Counting is a handful of additions per APDU; timing
+// reads `status_clock` twice per phase, and is only built with HAVE_PHASE_TIMES.
+
+// Where the time of a request goes.
+enum status_phase {
+    PHASE_DERIVATION,  // Deriving a key pair, or a public key that is not cached
+    PHASE_HASHING,     // Hashing the packets of a signing request
+    PHASE_SIGNING,     // The signature itself, once the key is derived
+    PHASE_NVRAM,       // Writing NVRAM
+    PHASE_UI,          // From a prompt being shown to the user answering it
+    NUM_PHASES,
+};
+
+// Why a request was refused.
+enum status_rejection {
+    REJECTED_HWM,    // Baking data at or below the high watermark
+    REJECTED_PATH,   // Baking data signed with a key that is not authorized
+    REJECTED_PARSE,  // A signing request that could not be parsed
+    REJECTED_USER,   // A prompt the user rejected
+    NUM_REJECTIONS,
+};
+
+struct status_phase_time {
+    uint32_t count;
+    uint32_t total;  // Milliseconds, see `status_clock`
+    uint32_t max;
+};
+
+struct status_counters {
+    uint32_t apdus;
+    uint32_t signatures[MAGIC_BYTE_UNSAFE_OP3 + 1];  // By magic byte; unknown ones count as 0
+    uint32_t rejections[NUM_REJECTIONS];
+    uint32_t nvram_writes;
+    uint32_t nvram_bytes;
+#ifdef HAVE_PHASE_TIMES
+    struct status_phase_time phases[NUM_PHASES];
+    uint32_t prompt_shown_at;  // `status_clock` when the current prompt was shown
+#endif
+
+    uint32_t ticks;  // Ticker events, which are the clock of the device
+};
+
+// Milliseconds since the app started, from the platform: on the device, the 100 ms ticker of the
+// SDK, which only advances while the app waits for events (see ui_nano_x.c). Most phases are much
+// shorter than that, so only builds with a real clock, such as the host build, define
+// HAVE_PHASE_TIMES and time them.
+uint32_t status_clock(void);
+
+#ifdef HAVE_PHASE_TIMES
+// Adds the time since `started`, a reading of `status_clock`, to `phase`.
+void status_phase_end(enum status_phase phase, uint32_t started);
+#else
+static inline void status_phase_end(__attribute__((unused)) enum status_phase phase,
+                                    __attribute__((unused)) uint32_t started) {
+}
+#endif
+
+void status_count_signature(uint8_t magic_byte);
+void status_count_rejection(enum status_rejection reason);
+
+// Counts a write of `size` bytes of NVRAM that started at `started`.
+void status_count_nvram_write(size_t size, uint32_t started);
+
+// A prompt was shown, and then answered. Time spent in a review abandoned before it could be
+// answered is not counted.
+void status_prompt_shown(void);
+void status_prompt_answered(bool accepted);
+
+// Returns, all as big-endian 32-bit numbers: the APDUs handled, the signatures by magic byte 0 to
+// 5, the rejections by `enum status_rejection`, the NVRAM writes and the bytes written, and the
+// count, total and maximum milliseconds of each `enum status_phase` with HAVE_PHASE_TIMES. The
+// baking app then adds its
+// main chain id, the main and test high watermarks (a level and an endorsement flag of 1 byte
+// each) and its authorized key, as INS_QUERY_AUTH_KEY_WITH_CURVE returns it.
+size_t handle_apdu_query_status(uint8_t instruction);
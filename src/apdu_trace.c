@@ -0,0 +1,47 @@
+#include "apdu_trace.h"
+
+#if TRACE_RECORDS > 0
+
+#include "apdu.h"
+#include "apdu_status.h"
+#include "globals.h"
+
+#define T global.trace
+
+void trace(enum trace_event const event, int16_t const op_step, uint32_t const payload) {
+    struct trace_record *const record = &T.records[T.written++ % TRACE_RECORDS];
+    record->time = status_clock();
+    record->payload = payload;
+    record->op_step = op_step;
+    record->event = event;
+    record->instruction = T.instruction;
+    if (T.held < TRACE_RECORDS) T.held++;
+}
+
+void trace_apdu(size_t const rx) {
+    T.instruction = rx > OFFSET_INS ? G_io_apdu_buffer[OFFSET_INS] : INS_MAX + 1;
+    trace(TRACE_APDU, 0, rx);
+}
+
+size_t handle_apdu_drain_trace(__attribute__((unused)) uint8_t instruction) {
+    if (G_io_apdu_buffer[OFFSET_P1] != 0) THROW(EXC_WRONG_PARAM);
+
+    size_t tx = 0;
+    wire_write_be32(&G_io_apdu_buffer[tx], T.written);
+    tx += sizeof(uint32_t);
+    for (uint32_t i = T.written - T.held; i != T.written; i++) {
+        struct trace_record const *const record = &T.records[i % TRACE_RECORDS];
+        wire_write_be32(&G_io_apdu_buffer[tx], record->time);
+        tx += sizeof(uint32_t);
+        wire_write_be32(&G_io_apdu_buffer[tx], record->payload);
+        tx += sizeof(uint32_t);
+        wire_write_be16(&G_io_apdu_buffer[tx], record->op_step);
+        tx += sizeof(uint16_t);
+        G_io_apdu_buffer[tx++] = record->event;
+        G_io_apdu_buffer[tx++] = record->instruction;
+    }
+    T.held = 0;
+    return finalize_successful_send(tx);
+}
+
+#endif  // #if TRACE_RECORDS > 0
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A ring of compact binary records of what the app did and when, for finding latency problems in
+// builds without PRINTF. Recording is a dozen stores and no formatting, so it is cheap enough to
+// leave on in production. INS_DRAIN_TRACE hands the records over, and tools/trace-decode.py turns
+// them into a timeline.
+
+// Records kept, a power of two; TRACE_RECORDS=0 in the Makefile leaves tracing out.
+#ifndef TRACE_RECORDS
+#define TRACE_RECORDS 16
+#endif
+
+enum trace_event {
+    TRACE_APDU = 1,         // `main_loop` received an APDU; payload: its length
+    TRACE_HANDLED,          // Its handler returned; payload: the length of the response
+    TRACE_PROMPT,           // Its handler waits for the user instead
+    TRACE_ERROR,            // It failed; payload: the status word
+    TRACE_PARSE_ERROR,      // The sign handler refused the data; payload: line in apdu_sign.c
+    TRACE_OPERATION_ERROR,  // The operation parser refused a field; payload: line in operations.c
+    TRACE_HWM,              // The high watermark was written; payload: level, top bit if endorsed
+    TRACE_SIGNED,           // A signature was sent; payload: magic byte << 8 | signature length
+};
+
+struct trace_record {
+    uint32_t time;        // `status_clock`
+    uint32_t payload;     // Depends on the event
+    int16_t op_step;      // Of the operation parser, for the events of a signing request
+    uint8_t event;        // enum trace_event
+    uint8_t instruction;  // Of the APDU being handled
+};
+
+#if TRACE_RECORDS > 0
+
+_Static_assert((TRACE_RECORDS & (TRACE_RECORDS - 1)) == 0 && TRACE_RECORDS <= 16,
+               "TRACE_RECORDS must be a power of two that a response can hold");
+
+struct trace {
+    struct trace_record records[TRACE_RECORDS];
+    uint32_t written;     // Records written since the app started; the last TRACE_RECORDS are kept
+    uint8_t held;         // Records not drained yet
+    uint8_t instruction;  // Of the APDU being handled
+};
+
+void trace(enum trace_event event, int16_t op_step, uint32_t payload);
+
+// Records an APDU of `rx` bytes in G_io_apdu_buffer and tags what follows with its instruction.
+void trace_apdu(size_t rx);
+
+// Returns the number of records written since the app started, then the records that were not
+// drained yet, oldest first, and forgets them. All numbers are big-endian.
+size_t handle_apdu_drain_trace(uint8_t instruction);
+
+#else
+
+static inline void trace(__attribute__((unused)) enum trace_event event,
+                         __attribute__((unused)) int16_t op_step,
+                         __attribute__((unused)) uint32_t payload) {
+}
+
+static inline void trace_apdu(__attribute__((unused)) size_t rx) {
+}
+
+#endif  // #if TRACE_RECORDS > 0
@@ -3,6 +3,8 @@
 #include "baking_auth.h"
 
 #include "apdu.h"
+#include "apdu_status.h"
+#include "apdu_trace.h"
 #include "globals.h"
 #include "keys.h"
 #include "memory.h"
@@ -18,15 +20,85 @@ bool is_valid_level(level_t lvl) {
     return !(lvl & 0xC0000000);
 }
 
-void write_high_water_mark(parsed_baking_data_t const *const in) {
+// A signature writes nothing but the next audit record, in a single nvm_write: the record carries
+// the watermarks it raises (see recover_high_water_marks), and the records spread the writes over
+// the pages of the ring.
+void write_high_water_mark(parsed_baking_data_t const *const in, uint8_t const *const hash) {
     check_null(in);
+    check_null(hash);
     if (!is_valid_level(in->level)) THROW(EXC_WRONG_VALUES);
-    UPDATE_NVRAM(ram, {
-        // If the chain matches the main chain *or* the main chain is not set, then use 'main' HWM.
-        high_watermark_t volatile *const dest = select_hwm_by_chain(in->chain_id, ram);
-        dest->highest_level = CUSTOM_MAX(in->level, dest->highest_level);
-        dest->had_endorsement = in->is_endorsement;
-    });
+
+    struct audit_record record;
+    memset(&record, 0, sizeof(record));  // Its padding is written too
+    record.hwm = global.nvram.hwm;
+    // If the chain matches the main chain *or* the main chain is not set, then use 'main' HWM.
+    high_watermark_t *const dest =
+        select_hwm_by_chain(in->chain_id, N_data.main_chain_id, &record.hwm);
+    dest->highest_level = CUSTOM_MAX(in->level, dest->highest_level);
+    dest->had_endorsement = in->is_endorsement;
+    record.chain_id = in->chain_id;
+    record.level = in->level | (in->is_endorsement ? AUDIT_ENDORSEMENT : 0);
+    memcpy(record.hash, hash, sizeof(record.hash));
+    record.number = global.nvram.written + 1;
+
+    uint32_t const started = status_clock();
+    nvm_write((void *) &N_nvram.audit[global.nvram.written % AUDIT_RECORDS],
+              &record,
+              sizeof(record));
+    status_count_nvram_write(sizeof(record), started);
+    global.nvram.written = record.number;
+    global.nvram.hwm = record.hwm;
+
+    update_baking_idle_screens();
+    trace(TRACE_HWM, 0, in->level | (uint32_t) in->is_endorsement << 31);
+}
+
+// The higher level wins, then an endorsement (see baking_auth.h).
+high_watermark_t higher_hwm(high_watermark_t volatile const *const a,
+                            high_watermark_t volatile const *const b) {
+    high_watermark_t const x = {a->highest_level, a->had_endorsement};
+    high_watermark_t const y = {b->highest_level, b->had_endorsement};
+    if (x.highest_level != y.highest_level) return x.highest_level > y.highest_level ? x : y;
+    return x.had_endorsement ? x : y;
+}
+
+static bool hwms_eq(high_watermark_t volatile const *const a,
+                    high_watermark_t volatile const *const b) {
+    return a->highest_level == b->highest_level && a->had_endorsement == b->had_endorsement;
+}
+
+// Finds the watermarks in force at boot. A write cut short by a power failure may leave bytes of it
+// new and the others old:
+// - In N_data, a torn watermark may read as a level below both (0x000000FF, then 0x00000100
+//   written from the low byte, reads as 0). As `hwm` is always written before `hwm_copy`
+//   (nvm_write goes in address order), either `hwm` is torn and `hwm_copy` still holds the
+//   watermarks from before, or `hwm` holds the new ones, so the higher of the two is taken. A torn
+//   `audit_base` only reads as lower, which lets the newest record raise `hwm` again.
+// - In a record, the number is written last, and either still reads as that of the record it
+//   replaces or is torn below it: the newest record is then the one before, whole.
+// Neither is below any level signed, as a signature is only sent once its write is over.
+void recover_high_water_marks(void) {
+    uint32_t written = 0;
+    for (size_t i = 0; i < AUDIT_RECORDS; i++) {
+        uint32_t const number = N_nvram.audit[i].number;
+        if (number > written) written = number;
+    }
+    global.nvram.written = written;
+
+    high_watermarks_t *const hwm = &global.nvram.hwm;
+    hwm->main = higher_hwm(&N_data.hwm.main, &N_data.hwm_copy.main);
+    hwm->test = higher_hwm(&N_data.hwm.test, &N_data.hwm_copy.test);
+    if (written > N_data.audit_base) {
+        struct audit_record volatile const *const newest =
+            &N_nvram.audit[(written - 1) % AUDIT_RECORDS];
+        hwm->main = higher_hwm(&hwm->main, &newest->hwm.main);
+        hwm->test = higher_hwm(&hwm->test, &newest->hwm.test);
+    }
+
+    if (hwms_eq(&N_data.hwm.main, &N_data.hwm_copy.main) &&
+        hwms_eq(&N_data.hwm.test, &N_data.hwm_copy.test))
+        return;
+    UPDATE_NVRAM(ram, {});  // Writes the watermarks in force over the torn ones
 }
 
 void authorize_baking(derivation_type_t const derivation_type,
@@ -45,8 +117,8 @@ void authorize_baking(derivation_type_t const derivation_type,
 static bool is_level_authorized(parsed_baking_data_t const *const baking_info) {
     check_null(baking_info);
     if (!is_valid_level(baking_info->level)) return false;
-    high_watermark_t volatile const *const hwm =
-        select_hwm_by_chain(baking_info->chain_id, &N_data);
+    high_watermark_t const *const hwm =
+        select_hwm_by_chain(baking_info->chain_id, N_data.main_chain_id, &global.nvram.hwm);
     return baking_info->level > hwm->highest_level
 
            // Levels are tied. In order for this to be OK, this must be an endorsement, and we must
@@ -67,8 +139,14 @@ void guard_baking_authorized(parsed_baking_data_t const *const baking_info,
                              bip32_path_with_curve_t const *const key) {
     check_null(baking_info);
     check_null(key);
-    if (!is_path_authorized(key->derivation_type, &key->bip32_path)) THROW(EXC_SECURITY);
-    if (!is_level_authorized(baking_info)) THROW(EXC_WRONG_VALUES);
+    if (!is_path_authorized(key->derivation_type, &key->bip32_path)) {
+        status_count_rejection(REJECTED_PATH);
+        THROW(EXC_SECURITY);
+    }
+    if (!is_level_authorized(baking_info)) {
+        status_count_rejection(REJECTED_HWM);
+        THROW(EXC_WRONG_VALUES);
+    }
 }
 
 struct block_wire {
@@ -95,15 +173,15 @@ bool parse_baking_data(parsed_baking_data_t *const out,
             if (length != sizeof(struct endorsement_wire)) return false;
             struct endorsement_wire const *const endorsement = data;
             out->is_endorsement = true;
-            out->chain_id.v = READ_UNALIGNED_BIG_ENDIAN(uint32_t, &endorsement->chain_id);
-            out->level = READ_UNALIGNED_BIG_ENDIAN(uint32_t, &endorsement->level);
+            out->chain_id.v = WIRE_READ(endorsement, chain_id);
+            out->level = WIRE_READ(endorsement, level);
             return true;
         case MAGIC_BYTE_BLOCK:
             if (length < sizeof(struct block_wire)) return false;
             struct block_wire const *const block = data;
             out->is_endorsement = false;
-            out->chain_id.v = READ_UNALIGNED_BIG_ENDIAN(uint32_t, &block->chain_id);
-            out->level = READ_UNALIGNED_BIG_ENDIAN(level_t, &block->level);
+            out->chain_id.v = WIRE_READ(block, chain_id);
+            out->level = WIRE_READ(block, level);
             return true;
         case MAGIC_BYTE_INVALID:
         default:
@@ -17,7 +17,15 @@ void guard_baking_authorized(parsed_baking_data_t const *const baking_data,
 bool is_path_authorized(derivation_type_t const derivation_type,
                         bip32_path_t const *const bip32_path);
 bool is_valid_level(level_t level);
-void write_high_water_mark(parsed_baking_data_t const *const in);
+// Raises the watermark to what `in` describes, and records it in the audit log with the first
+// bytes of `hash`, the hash about to be signed.
+void write_high_water_mark(parsed_baking_data_t const *const in, uint8_t const *const hash);
+void recover_high_water_marks(void);
+
+// The more restrictive of two watermarks: the higher level, or at the same level the one that had
+// an endorsement.
+high_watermark_t higher_hwm(high_watermark_t volatile const *const a,
+                            high_watermark_t volatile const *const b);
 
 // Return false if it is invalid
 bool parse_baking_data(parsed_baking_data_t *const out,
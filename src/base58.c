@@ -24,8 +24,14 @@ bool b58enc(/* out */ char *b58, /* in/out */ size_t *b58sz, const void *data, s
 
     while (zcount < binsz && !bin[zcount]) ++zcount;
 
-    size = (binsz - zcount) * 138 / 100 + 1;
-    uint8_t buf[size];
+    // At most log(256) / log(58) < 1.366 digits per byte. They are worked out in `b58` itself,
+    // after the '1's that stand for the leading zeros, then moved to follow them.
+    size = ((binsz - zcount) * 1366 + 999) / 1000;
+    if (*b58sz < zcount + size) {
+        *b58sz = zcount + size + 1;
+        return false;
+    }
+    uint8_t *const buf = (uint8_t *) b58 + zcount;
     memset(buf, 0, size);
 
     for (i = zcount, high = size - 1; i < binsz; ++i, high = j) {
@@ -51,3 +57,23 @@ bool b58enc(/* out */ char *b58, /* in/out */ size_t *b58sz, const void *data, s
 
     return true;
 }
+
+bool b58dec(/* out */ void *bin, size_t binsz, const char *b58, size_t b58sz) {
+    uint8_t *const out = bin;
+    memset(out, 0, binsz);
+
+    for (size_t i = 0; i < b58sz; i++) {
+        const char *const digit = memchr(b58digits_ordered, b58[i], sizeof(b58digits_ordered) - 1);
+        if (digit == NULL) return false;
+
+        // out = out * 58 + digit
+        unsigned int carry = digit - b58digits_ordered;
+        for (size_t j = binsz; j-- > 0;) {
+            carry += 58 * out[j];
+            out[j] = carry & 0xFF;
+            carry >>= 8;
+        }
+        if (carry != 0) return false;
+    }
+    return true;
+}
@@ -1,5 +1,10 @@
 #include <stdbool.h>
 #include <stddef.h>
 
-/* Return true IFF successful, false otherwise. */
+/* Return true IFF successful, false otherwise. `b58` is also the work space of the encoding, so it
+ * must not overlap `bin`, and `*b58sz` must have room for 1.366 digits per byte of `bin`. */
 bool b58enc(/* out */ char *b58, /* in/out */ size_t *b58sz, const void *bin, size_t binsz);
+
+/* Decodes `b58sz` base58 digits into exactly `binsz` big-endian bytes. Returns false if any is
+ * not a base58 digit or the number does not fit. Leading '1's only add leading zero bytes. */
+bool b58dec(/* out */ void *bin, size_t binsz, const char *b58, size_t b58sz);
@@ -6,6 +6,7 @@
 
 #include "swap/swap_lib_calls.h"
 
+#include "apdu_stack.h"
 #include "globals.h"
 
 __attribute__((noreturn)) void app_main(void);
@@ -29,6 +30,9 @@ __attribute__((section(".boot"))) int main(arg0) {
         uint8_t tag;
         init_globals();
         global.stack_root = &tag;
+#ifdef HAVE_STACK_TELEMETRY
+        stack_paint();
+#endif
         called_from_swap = false;
 
         for (;;) {
@@ -2,6 +2,7 @@
 
 #include "exception.h"
 #include "to_string.h"
+#include "ui.h"
 
 #include "ux.h"
 
@@ -23,9 +24,37 @@ bolos_ux_params_t G_ux_params;
 unsigned char G_io_seproxyhal_spi_buffer[IO_SEPROXYHAL_BUFFER_SIZE_B];
 
 void clear_apdu_globals(void) {
+    ux_review_abandon();  // It belongs to the signing session being ended
     memset(&global.apdu, 0, sizeof(global.apdu));
 }
 
+void *scratch_borrow(size_t const size) {
+    struct scratch *const scratch = &global.scratch;
+    size_t const rounded = SCRATCH_ROUND(size);
+    if (rounded > sizeof(scratch->bytes) - scratch->used) THROW(EXC_MEMORY_ERROR);
+    void *const borrowed = &scratch->bytes[scratch->used];
+    scratch->used += rounded;
+    return borrowed;
+}
+
+void scratch_return(void *const borrowed, size_t const size) {
+    struct scratch *const scratch = &global.scratch;
+    size_t const rounded = SCRATCH_ROUND(size);
+    // Only the last borrowing can be given back.
+    if (rounded > scratch->used || borrowed != &scratch->bytes[scratch->used - rounded]) {
+        THROW(EXC_MEMORY_ERROR);
+    }
+    explicit_bzero(borrowed, rounded);
+    scratch->used -= rounded;
+}
+
+void scratch_reset(void) {
+    struct scratch *const scratch = &global.scratch;
+    if (scratch->used == 0) return;
+    explicit_bzero(scratch->bytes, sizeof(scratch->bytes));
+    scratch->used = 0;
+}
+
 void init_globals(void) {
     memset(&global, 0, sizeof(global));
 
@@ -39,13 +68,13 @@ void init_globals(void) {
 
 // DO NOT TRY TO INIT THIS. This can only be written via an system call.
 // The "N_" is *significant*. It tells the linker to put this in NVRAM.
-nvram_data const N_data_real;
+struct nvram const N_nvram_real;
 
-high_watermark_t volatile *select_hwm_by_chain(chain_id_t const chain_id,
-                                               nvram_data volatile *const ram) {
-    check_null(ram);
-    return chain_id.v == ram->main_chain_id.v || ram->main_chain_id.v == 0 ? &ram->hwm.main
-                                                                           : &ram->hwm.test;
+high_watermark_t *select_hwm_by_chain(chain_id_t const chain_id,
+                                      chain_id_t const main_chain_id,
+                                      high_watermarks_t *const hwm) {
+    check_null(hwm);
+    return chain_id.v == main_chain_id.v || main_chain_id.v == 0 ? &hwm->main : &hwm->test;
 }
 
 void copy_chain(char *out, size_t out_size, void *data) {
@@ -63,7 +92,7 @@ void copy_key(char *out, size_t out_size, void *data) {
     if (baking_key->bip32_path.length == 0) {
         copy_string(out, out_size, "No Key Authorized");
     } else {
-        cx_ecfp_public_key_t pubkey = {0};
+        cx_ecfp_public_key_t pubkey;
         generate_public_key(&pubkey,
                             (derivation_type_t const) baking_key->derivation_type,
                             (bip32_path_t const *const) & baking_key->bip32_path);
@@ -85,7 +114,10 @@ void calculate_baking_idle_screens_data(void) {
     push_ui_callback("Tezos Baking", copy_string, VERSION);
     push_ui_callback("Chain", copy_chain, &N_data.main_chain_id);
     push_ui_callback("Public Key Hash", copy_key, &N_data.baking_key);
-    push_ui_callback("High Watermark", copy_hwm, &N_data.hwm.main.highest_level);
+    push_ui_callback("High Watermark", copy_hwm, &global.nvram.hwm.main.highest_level);
+#ifdef HAVE_WALLET
+    calculate_payout_policy_idle_screens_data();
+#endif
 }
 
 void update_baking_idle_screens(void) {
@@ -94,4 +126,26 @@ void update_baking_idle_screens(void) {
     ui_refresh();
 }
 
+#else
+
+void calculate_wallet_idle_screens_data(void) {
+    push_ui_callback("Tezos Wallet", copy_string, VERSION);
+    calculate_payout_policy_idle_screens_data();
+}
+
 #endif  // #ifdef BAKING_APP
+
+#ifdef HAVE_WALLET
+
+void calculate_payout_policy_idle_screens_data(void) {
+    if (global.payout_policy.remaining_operations != 0) {
+        push_ui_callback("Auto-Sign Ops",
+                         number_to_string_indirect32,
+                         &global.payout_policy.remaining_operations);
+        push_ui_callback("Auto-Sign Left",
+                         microtez_to_string_indirect,
+                         &global.payout_policy.remaining_amount);
+    }
+}
+
+#endif  // #ifdef HAVE_WALLET
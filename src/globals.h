@@ -2,6 +2,9 @@
 
 #include "types.h"
 
+#include "apdu_status.h"
+#include "apdu_trace.h"
+
 #include "bolos_target.h"
 
 #include "operations.h"
@@ -15,13 +18,42 @@ void init_globals(void);
 
 #define MAX_APDU_SIZE 230  // Maximum number of bytes in a single APDU
 
-// Our buffer must accommodate any remainder from hashing and the next message at once.
-#define TEZOS_BUFSIZE (BLAKE2B_BLOCKBYTES + MAX_APDU_SIZE)
+// Holds the block that is yet to be hashed, or a whole message that is signed without hashing.
+#define TEZOS_BUFSIZE MAX_APDU_SIZE
+_Static_assert(BLAKE2B_BLOCKBYTES <= TEZOS_BUFSIZE, "The sign buffer must hold a block");
 
 #define PRIVATE_KEY_DATA_SIZE 64
 
 #define MAX_SIGNATURE_SIZE 100
 
+// Space for the large temporaries of the crypto and formatting helpers, which would otherwise add
+// up on the stack of whatever calls them. What is borrowed is given back in the reverse order, and
+// zeroed when it is. Nothing stays borrowed from one APDU to the next, so `main_loop` resets it,
+// which also takes back whatever a THROW skipped over. UI formatters run between APDUs, after that
+// reset, so they keep their own temporaries on the stack, and what they call gives back what it
+// borrows even when it throws.
+void *scratch_borrow(size_t size);
+void scratch_return(void *borrowed, size_t size);
+void scratch_reset(void);
+
+// Borrows a zeroed `type`, or THROWs if there is no room left.
+#define SCRATCH_BORROW(type)     ((type *) scratch_borrow(sizeof(type)))
+#define SCRATCH_RETURN(borrowed) scratch_return((borrowed), sizeof(*(borrowed)))
+
+#define SCRATCH_ROUND(size) (((size) + 7) & ~(size_t) 7)
+
+// The most that is borrowed at once: a public key, and the copy `public_key_hash` compresses it
+// into and hashes.
+#define SCRATCH_SIZE \
+    (2 * SCRATCH_ROUND(sizeof(cx_ecfp_public_key_t)) + SCRATCH_ROUND(sizeof(cx_blake2b_t)))
+_Static_assert(SCRATCH_ROUND(sizeof(key_pair_t)) + PRIVATE_KEY_DATA_SIZE <= SCRATCH_SIZE,
+               "Signing borrows a key pair, then the data it derives the private key from");
+
+struct scratch {
+    uint8_t bytes[SCRATCH_SIZE] __attribute__((aligned(8)));
+    size_t used;  // Bytes borrowed, from the start of `bytes`; all others are zero
+};
+
 #ifdef BAKING_APP
 typedef struct {
     uint8_t signed_hmac_key[MAX_SIGNATURE_SIZE];
@@ -30,13 +62,50 @@ typedef struct {
 } apdu_hmac_state_t;
 #endif
 
+#ifdef HAVE_WALLET
+// Limits within which payouts are signed without a prompt, approved once on the device with
+// INS_SET_PAYOUT_POLICY. It is only kept in RAM, so it never outlives the app.
+struct payout_policy {
+    bip32_path_with_curve_t key;    // Only operation groups signed with this key are covered
+    uint32_t remaining_operations;  // 0 when no policy is set
+    uint64_t remaining_amount;      // Total that may still be sent under the policy
+    uint64_t max_amount;            // Per transaction
+    uint64_t max_fee;               // Per operation group
+    uint64_t max_storage;           // Storage limit per operation group
+};
+#endif
+
 typedef struct {
     cx_blake2b_t state;
     bool initialized;
 } blake2b_hash_state_t;
 
+// Last key derived by `generate_public_key`. A public key only depends on the seed and its path.
+struct public_key_cache {
+    bool is_valid;
+    bip32_path_with_curve_t key;
+    cx_ecfp_public_key_t public_key;
+};
+
+#ifdef HAVE_STACK_TELEMETRY
+// See apdu_stack.h.
+struct stack_telemetry {
+    uint16_t peak[INS_MAX + 1];  // Most stack taken by each instruction code, in bytes
+    uint8_t instruction;         // What the stack was used for since it was painted, if <= INS_MAX
+};
+#endif
+
+// Review of an operation group started before its last packet, see `start_early_review`.
+enum early_review {
+    EARLY_REVIEW_NONE,       // Reviewed once the last packet is in, as usual
+    EARLY_REVIEW_RECEIVING,  // Shown while packets still come in; Accept is disabled
+    EARLY_REVIEW_COMPLETE,   // The last packet came in during the review
+    EARLY_REVIEW_REJECTED,   // Rejected before the last packet; the next packet is refused
+};
+
 typedef struct {
-    uint8_t packet_index;  // 0-index is the initial setup packet, 1 is first packet to hash, etc.
+    uint8_t session_id;     // 0 when no signing session is in progress
+    uint32_t packet_index;  // 0-index is the initial setup packet, 1 is first packet to hash, etc.
 
 #ifdef BAKING_APP
     parsed_baking_data_t parsed_baking_data;
@@ -48,7 +117,7 @@ typedef struct {
     } maybe_ops;
 
     uint8_t message_data[TEZOS_BUFSIZE];
-    uint32_t message_data_length;
+    size_t message_data_length;
     buffer_t message_data_as_buffer;
 
     blake2b_hash_state_t hash_state;
@@ -56,6 +125,7 @@ typedef struct {
 
     uint8_t magic_byte;
     bool hash_only;
+    uint8_t early_review;  // enum early_review
     struct parse_state parse_state;
 } apdu_sign_state_t;
 
@@ -92,6 +162,8 @@ typedef struct {
         ui_callback_t ok_callback;
         // Callback function if user rejected prompt.
         ui_callback_t cxl_callback;
+        // Accept is disabled: the data under review is still being received.
+        bool receiving;
 
         // Title to be displayed on the screen.
         char screen_title[PROMPT_WIDTH + 1];
@@ -100,8 +172,27 @@ typedef struct {
     } dynamic_display;
 
     void *stack_root;
-    apdu_handler handlers[INS_MAX + 1];
     bip32_path_with_curve_t path_with_curve;
+    uint8_t last_sign_session_id;  // Survives clear_apdu_globals so ids are not reused
+
+    struct public_key_cache public_key_cache;  // Survives clear_apdu_globals
+    struct scratch scratch;                    // Reset by main_loop, see scratch_borrow
+    struct status_counters status;             // Survives clear_apdu_globals
+#if TRACE_RECORDS > 0
+    struct trace trace;  // Survives clear_apdu_globals
+#endif
+#ifdef HAVE_STACK_TELEMETRY
+    struct stack_telemetry stack_telemetry;  // Survives clear_apdu_globals
+#endif
+#ifdef HAVE_WALLET
+    struct payout_policy payout_policy;  // Survives clear_apdu_globals until the app exits
+#endif
+#ifdef BAKING_APP
+    struct {
+        high_watermarks_t hwm;  // In force: N_data.hwm, raised by the newest audit record
+        uint32_t written;       // The number of the newest audit record, 0 if none
+    } nvram;                    // Survives clear_apdu_globals, see recover_high_water_marks
+#endif
 
     struct {
         union {
@@ -114,13 +205,13 @@ typedef struct {
 
             struct {
                 chain_id_t main_chain_id;
-                struct {
-                    level_t main;
-                    level_t test;
-                } hwm;
+                high_watermarks_t hwm;
             } setup;
 
             apdu_hmac_state_t hmac;
+#endif
+#ifdef HAVE_WALLET
+            struct payout_policy payout;  // Staging area while the policy is reviewed
 #endif
         } u;
 
@@ -139,25 +230,39 @@ extern unsigned int app_stack_canary;  // From SDK
 extern unsigned char G_io_seproxyhal_spi_buffer[IO_SEPROXYHAL_BUFFER_SIZE_B];
 
 #ifdef BAKING_APP
-extern nvram_data const N_data_real;
-#define N_data (*(volatile nvram_data *) PIC(&N_data_real))
+extern struct nvram const N_nvram_real;
+#define N_nvram (*(volatile struct nvram *) PIC(&N_nvram_real))
+#define N_data  (N_nvram.data)
 
 void calculate_baking_idle_screens_data(void);
 void update_baking_idle_screens(void);
-high_watermark_t volatile *select_hwm_by_chain(chain_id_t const chain_id,
-                                               nvram_data volatile *const ram);
+high_watermark_t *select_hwm_by_chain(chain_id_t const chain_id,
+                                      chain_id_t const main_chain_id,
+                                      high_watermarks_t *const hwm);
 
 // Properly updates NVRAM data to prevent any clobbering of data.
 // 'out_param' defines the name of a pointer to the nvram_data struct
-// that 'body' can change to apply updates.
+// that 'body' can change to apply updates. Its `hwm` starts as the watermarks in force.
+// Only N_data is staged and written, not the audit records.
 #define UPDATE_NVRAM(out_name, body)                                                    \
     ({                                                                                  \
         nvram_data *const out_name = &global.apdu.baking_auth.new_data;                 \
         memcpy(&global.apdu.baking_auth.new_data,                                       \
                (nvram_data const *const) & N_data,                                      \
                sizeof(global.apdu.baking_auth.new_data));                               \
+        out_name->hwm = global.nvram.hwm;                                               \
         body;                                                                           \
+        out_name->hwm_copy = out_name->hwm;                                             \
+        out_name->audit_base = global.nvram.written;                                    \
+        uint32_t const nvram_started_ = status_clock();                                 \
         nvm_write((void *) &N_data, &global.apdu.baking_auth.new_data, sizeof(N_data)); \
+        status_count_nvram_write(sizeof(N_data), nvram_started_);                       \
+        global.nvram.hwm = out_name->hwm;                                               \
         update_baking_idle_screens();                                                   \
     })
+#else
+void calculate_wallet_idle_screens_data(void);
+#endif
+#ifdef HAVE_WALLET
+void calculate_payout_policy_idle_screens_data(void);
 #endif
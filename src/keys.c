@@ -18,6 +18,7 @@
 #include "keys.h"
 
 #include "apdu.h"
+#include "apdu_status.h"
 #include "globals.h"
 #include "memory.h"
 #include "protocol.h"
@@ -26,31 +27,22 @@
 #include <stdbool.h>
 #include <string.h>
 
-size_t read_bip32_path(bip32_path_t *const out, uint8_t const *const in, size_t const in_size) {
-    struct bip32_path_wire const *const buf_as_bip32 = (struct bip32_path_wire const *) in;
+void read_bip32_path(bip32_path_t *const out, struct wire_cursor *const cursor) {
+    out->length = WIRE_CONSUME(cursor, uint8_t);
 
-    if (in_size < sizeof(buf_as_bip32->length)) THROW(EXC_WRONG_LENGTH_FOR_INS);
-
-    size_t ix = 0;
-    out->length = CONSUME_UNALIGNED_BIG_ENDIAN(ix, uint8_t, &buf_as_bip32->length);
-
-    if (in_size - ix < out->length * sizeof(*buf_as_bip32->components))
-        THROW(EXC_WRONG_LENGTH_FOR_INS);
+    uint8_t const *const components = wire_take(cursor, out->length * sizeof(uint32_t));
     if (out->length == 0 || out->length > NUM_ELEMENTS(out->components)) THROW(EXC_WRONG_VALUES);
 
     for (size_t i = 0; i < out->length; i++) {
-        out->components[i] =
-            CONSUME_UNALIGNED_BIG_ENDIAN(ix, uint32_t, &buf_as_bip32->components[i]);
+        out->components[i] = wire_read_be32(&components[i * sizeof(uint32_t)]);
     }
-
-    return ix;
 }
 
 int crypto_derive_private_key(cx_ecfp_private_key_t *private_key,
                               derivation_type_t const derivation_type,
                               bip32_path_t const *const bip32_path) {
     check_null(bip32_path);
-    uint8_t raw_private_key[PRIVATE_KEY_DATA_SIZE] = {0};
+    uint8_t *const raw_private_key = scratch_borrow(PRIVATE_KEY_DATA_SIZE);
     int error = 0;
 
     cx_curve_t const cx_curve =
@@ -58,6 +50,7 @@ int crypto_derive_private_key(cx_ecfp_private_key_t *private_key,
 
     BEGIN_TRY {
         TRY {
+#ifdef HAVE_CURVE_ED25519
             if (derivation_type == DERIVATION_TYPE_ED25519) {
                 // Old, non BIP32_Ed25519 way...
                 os_perso_derive_node_bip32_seed_key(HDW_ED25519_SLIP10,
@@ -68,7 +61,9 @@ int crypto_derive_private_key(cx_ecfp_private_key_t *private_key,
                                                     NULL,
                                                     NULL,
                                                     0);
-            } else {
+            } else
+#endif
+            {
                 // derive the seed with bip32_path
                 os_perso_derive_node_bip32(cx_curve,
                                            bip32_path->components,
@@ -84,7 +79,7 @@ int crypto_derive_private_key(cx_ecfp_private_key_t *private_key,
             error = 1;
         }
         FINALLY {
-            explicit_bzero(raw_private_key, sizeof(raw_private_key));
+            scratch_return(raw_private_key, PRIVATE_KEY_DATA_SIZE);
         }
     }
     END_TRY;
@@ -101,11 +96,13 @@ int crypto_init_public_key(derivation_type_t const derivation_type,
     // generate corresponding public key
     cx_ecfp_generate_pair(cx_curve, public_key, private_key, 1);
 
+#ifdef HAVE_EDDSA
     // If we're using the old curve, make sure to adjust accordingly.
     if (cx_curve == CX_CURVE_Ed25519) {
         cx_edward_compress_point(CX_CURVE_Ed25519, public_key->W, public_key->W_len);
         public_key->W_len = 33;
     }
+#endif
 
     return 0;
 }
@@ -115,6 +112,7 @@ int generate_key_pair(key_pair_t *key_pair,
                       derivation_type_t const derivation_type,
                       bip32_path_t const *const bip32_path) {
     int error;
+    uint32_t const started = status_clock();
 
     // derive private key according to BIP32 path
     error = crypto_derive_private_key(&key_pair->private_key, derivation_type, bip32_path);
@@ -123,61 +121,119 @@ int generate_key_pair(key_pair_t *key_pair,
     }
     // generate corresponding public key
     error = crypto_init_public_key(derivation_type, &key_pair->private_key, &key_pair->public_key);
+    status_phase_end(PHASE_DERIVATION, started);
     return error;
 }
 
+// Deriving a key takes most of the time of a signing request, and the key of the request is
+// derived again to check the source and to display it, so the last one is kept.
 int generate_public_key(cx_ecfp_public_key_t *public_key,
                         derivation_type_t const derivation_type,
                         bip32_path_t const *const bip32_path) {
-    cx_ecfp_private_key_t private_key = {0};
-    int error;
+    check_null(public_key);
+    check_null(bip32_path);
+    struct public_key_cache *const cache = &global.public_key_cache;
+    if (cache->is_valid && cache->key.derivation_type == derivation_type &&
+        bip32_paths_eq(&cache->key.bip32_path, bip32_path)) {
+        memcpy(public_key, &cache->public_key, sizeof(*public_key));
+        return 0;
+    }
 
-    error = crypto_derive_private_key(&private_key, derivation_type, bip32_path);
+    cx_ecfp_private_key_t *const private_key = SCRATCH_BORROW(cx_ecfp_private_key_t);
+    volatile int error;
+    uint32_t const started = status_clock();
+
+    // Also called by UI formatters, which nothing resets the scratch arena after: what is
+    // borrowed is given back even if the key cannot be derived.
+    BEGIN_TRY {
+        TRY {
+            error = crypto_derive_private_key(private_key, derivation_type, bip32_path);
+            if (!error) error = crypto_init_public_key(derivation_type, private_key, public_key);
+        }
+        FINALLY {
+            SCRATCH_RETURN(private_key);
+        }
+    }
+    END_TRY;
+    status_phase_end(PHASE_DERIVATION, started);
     if (error) {
         return (error);
     }
-    error = crypto_init_public_key(derivation_type, &private_key, public_key);
-    return (error);
+
+    cache->is_valid = true;
+    cache->key.derivation_type = derivation_type;
+    copy_bip32_path(&cache->key.bip32_path, bip32_path);
+    memcpy(&cache->public_key, public_key, sizeof(cache->public_key));
+    return 0;
 }
 
-void public_key_hash(uint8_t *const hash_out,
-                     size_t const hash_out_size,
-                     cx_ecfp_public_key_t *compressed_out,
-                     derivation_type_t const derivation_type,
-                     cx_ecfp_public_key_t const *const restrict public_key) {
+void public_key_hash_with(uint8_t *const hash_out,
+                          size_t const hash_out_size,
+                          cx_ecfp_public_key_t *const compressed,
+                          cx_blake2b_t *const hash_state,
+                          derivation_type_t const derivation_type,
+                          cx_ecfp_public_key_t const *const restrict public_key) {
     check_null(hash_out);
+    check_null(compressed);
+    check_null(hash_state);
     check_null(public_key);
     if (hash_out_size < HASH_SIZE) THROW(EXC_WRONG_LENGTH);
 
-    cx_ecfp_public_key_t compressed = {0};
     switch (derivation_type_to_signature_type(derivation_type)) {
+#ifdef HAVE_EDDSA
         case SIGNATURE_TYPE_ED25519: {
-            compressed.W_len = public_key->W_len - 1;
-            memcpy(compressed.W, public_key->W + 1, compressed.W_len);
+            compressed->W_len = public_key->W_len - 1;
+            memcpy(compressed->W, public_key->W + 1, compressed->W_len);
             break;
         }
+#endif
+#ifdef HAVE_ECDSA
         case SIGNATURE_TYPE_SECP256K1:
         case SIGNATURE_TYPE_SECP256R1: {
-            memcpy(compressed.W, public_key->W, public_key->W_len);
-            compressed.W[0] = 0x02 + (public_key->W[64] & 0x01);
-            compressed.W_len = 33;
+            memcpy(compressed->W, public_key->W, public_key->W_len);
+            compressed->W[0] = 0x02 + (public_key->W[64] & 0x01);
+            compressed->W_len = 33;
             break;
         }
+#endif
         default:
             THROW(EXC_WRONG_PARAM);
     }
 
-    cx_blake2b_t hash_state;
-    cx_blake2b_init(&hash_state, HASH_SIZE * 8);  // cx_blake2b_init takes size in bits.
-    cx_hash((cx_hash_t *) &hash_state,
+    cx_blake2b_init(hash_state, HASH_SIZE * 8);  // cx_blake2b_init takes size in bits.
+    cx_hash((cx_hash_t *) hash_state,
             CX_LAST,
-            compressed.W,
-            compressed.W_len,
+            compressed->W,
+            compressed->W_len,
             hash_out,
             HASH_SIZE);
-    if (compressed_out != NULL) {
-        memmove(compressed_out, &compressed, sizeof(*compressed_out));
+}
+
+void public_key_hash(uint8_t *const hash_out,
+                     size_t const hash_out_size,
+                     cx_ecfp_public_key_t *compressed_out,
+                     derivation_type_t const derivation_type,
+                     cx_ecfp_public_key_t const *const restrict public_key) {
+    cx_ecfp_public_key_t *const compressed = SCRATCH_BORROW(cx_ecfp_public_key_t);
+    cx_blake2b_t *const hash_state = SCRATCH_BORROW(cx_blake2b_t);
+    BEGIN_TRY {
+        TRY {
+            public_key_hash_with(hash_out,
+                                 hash_out_size,
+                                 compressed,
+                                 hash_state,
+                                 derivation_type,
+                                 public_key);
+            if (compressed_out != NULL) {
+                memmove(compressed_out, compressed, sizeof(*compressed_out));
+            }
+        }
+        FINALLY {
+            SCRATCH_RETURN(hash_state);
+            SCRATCH_RETURN(compressed);
+        }
     }
+    END_TRY;
 }
 
 size_t sign(uint8_t *const out,
@@ -192,6 +248,7 @@ size_t sign(uint8_t *const out,
 
     size_t tx = 0;
     switch (derivation_type_to_signature_type(derivation_type)) {
+#ifdef HAVE_EDDSA
         case SIGNATURE_TYPE_ED25519: {
             static size_t const SIG_SIZE = 64;
             if (out_size < SIG_SIZE) THROW(EXC_WRONG_LENGTH);
@@ -206,6 +263,8 @@ size_t sign(uint8_t *const out,
                                 SIG_SIZE,
                                 NULL);
         } break;
+#endif
+#ifdef HAVE_ECDSA
         case SIGNATURE_TYPE_SECP256K1:
         case SIGNATURE_TYPE_SECP256R1: {
             static size_t const SIG_SIZE = 100;
@@ -223,9 +282,46 @@ size_t sign(uint8_t *const out,
                 out[0] |= 0x01;
             }
         } break;
+#endif
         default:
             THROW(EXC_WRONG_PARAM);  // This should not be able to happen.
     }
 
     return tx;
 }
+
+int generate_signature(uint8_t *const out,
+                       size_t const out_size,
+                       size_t *const out_length,
+                       derivation_type_t const derivation_type,
+                       bip32_path_t const *const bip32_path,
+                       uint8_t const *const in,
+                       size_t const in_size) {
+    check_null(out_length);
+    key_pair_t *const key_pair = SCRATCH_BORROW(key_pair_t);
+    volatile int error = 0;
+    volatile size_t signature_size = 0;
+
+    if (generate_key_pair(key_pair, derivation_type, bip32_path)) {
+        SCRATCH_RETURN(key_pair);
+        return EXC_WRONG_VALUES;
+    }
+
+    BEGIN_TRY {
+        TRY {
+            uint32_t const started = status_clock();
+            signature_size = sign(out, out_size, derivation_type, key_pair, in, in_size);
+            status_phase_end(PHASE_SIGNING, started);
+        }
+        CATCH_OTHER(e) {
+            error = e;
+        }
+        FINALLY {
+            SCRATCH_RETURN(key_pair);
+        }
+    }
+    END_TRY;
+
+    *out_length = signature_size;
+    return error;
+}
@@ -8,24 +8,22 @@
 #include "memory.h"
 #include "os_cx.h"
 #include "types.h"
+#include "wire.h"
 
 #if CX_APILEVEL <= 8
 #error "CX_APILEVEL 8 and below is not supported"
 #endif
 
-struct bip32_path_wire {
-    uint8_t length;
-    uint32_t components[0];
-} __attribute__((packed));
-
-// throws
-size_t read_bip32_path(bip32_path_t *const out, uint8_t const *const in, size_t const in_size);
+// Reads a BIP32 path from `cursor`: a length byte, followed by that many big-endian components.
+// Throws if it is cut short or too long.
+void read_bip32_path(bip32_path_t *const out, struct wire_cursor *const cursor);
 
 int generate_key_pair(key_pair_t *key_pair,
                       derivation_type_t const derivation_type,
                       bip32_path_t const *const bip32_path);
 
-// Non-reentrant
+// Non-reentrant. Borrows its temporaries from the scratch arena, and gives them back even if it
+// throws.
 void public_key_hash(
     uint8_t *const hash_out,
     size_t const hash_out_size,
@@ -33,6 +31,15 @@ void public_key_hash(
     derivation_type_t const derivation_type,
     cx_ecfp_public_key_t const *const restrict public_key);
 
+// The same, with temporaries from the caller: for the UI formatters, which run between APDUs and
+// must not borrow (see scratch_borrow).
+void public_key_hash_with(uint8_t *const hash_out,
+                          size_t const hash_out_size,
+                          cx_ecfp_public_key_t *const compressed,
+                          cx_blake2b_t *const hash_state,
+                          derivation_type_t const derivation_type,
+                          cx_ecfp_public_key_t const *const restrict public_key);
+
 size_t sign(uint8_t *const out,
             size_t const out_size,
             derivation_type_t const derivation_type,
@@ -40,17 +47,36 @@ size_t sign(uint8_t *const out,
             uint8_t const *const in,
             size_t const in_size);
 
-// Read a curve code from wire-format and parse into `deviration_type`.
+// Derives the key at `bip32_path`, signs `in` with it and wipes the key. Returns 0, or the status
+// word of what went wrong; nothing is thrown.
+int generate_signature(uint8_t *const out,
+                       size_t const out_size,
+                       size_t *const out_length,
+                       derivation_type_t const derivation_type,
+                       bip32_path_t const *const bip32_path,
+                       uint8_t const *const in,
+                       size_t const in_size);
+
+// Read a curve code from wire-format and parse into `deviration_type`. Curves left out of the build
+// are refused here, so no other code sees them.
 static inline derivation_type_t parse_derivation_type(uint8_t const curve_code) {
     switch (curve_code) {
+#ifdef HAVE_CURVE_ED25519
         case 0:
             return DERIVATION_TYPE_ED25519;
+#endif
+#ifdef HAVE_CURVE_SECP256K1
         case 1:
             return DERIVATION_TYPE_SECP256K1;
+#endif
+#ifdef HAVE_CURVE_SECP256R1
         case 2:
             return DERIVATION_TYPE_SECP256R1;
+#endif
+#ifdef HAVE_CURVE_BIP32_ED25519
         case 3:
             return DERIVATION_TYPE_BIP32_ED25519;
+#endif
         default:
             THROW(EXC_WRONG_PARAM);
     }
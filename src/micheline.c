@@ -0,0 +1,262 @@
+#include "micheline.h"
+
+#include "michelson.h"
+
+#include <string.h>
+
+// What the next byte is
+#define STEP_NODE   0  // The tag of a node
+#define STEP_PRIM   1  // The primitive of a MICHELSON_TYPE_PRIM* node
+#define STEP_LENGTH 2  // Part of a big-endian length prefix
+#define STEP_DATA   3  // Part of a string, byte sequence or annotations
+#define STEP_INT    4  // Part of an integer
+#define STEP_DONE   5  // Nothing: the input was decoded
+
+// Kinds of nodes on the stack
+#define FRAME_SEQUENCE     0
+#define FRAME_ARGS         1  // Arguments of a primitive, counted in `args_left`
+#define FRAME_GENERIC_ARGS 2  // Arguments of a MICHELSON_TYPE_PRIM_GENERIC node, with their size
+
+// Not a node tag: the value of `tag` while the annotations of a primitive are read
+#define TAG_ANNOTS 0xff
+
+void micheline_init(struct micheline_decoder *const decoder, uint32_t const length) {
+    check_null(decoder);
+    memset(decoder, 0, sizeof(*decoder));
+    decoder->end = length;
+    decoder->step = STEP_NODE;
+}
+
+bool micheline_done(struct micheline_decoder const *const decoder) {
+    return decoder->step == STEP_DONE;
+}
+
+static inline bool emit(struct micheline_decoder *const decoder,
+                        enum micheline_event_kind const kind,
+                        micheline_handler handler,
+                        void *context) {
+    decoder->event.kind = kind;
+    return handler(&decoder->event, context);
+}
+
+static inline bool push(struct micheline_decoder *const decoder,
+                        uint8_t const kind,
+                        uint32_t const end,
+                        uint8_t const args_left,
+                        bool const has_annots) {
+    if (decoder->depth == MICHELINE_MAX_DEPTH) return false;
+    struct micheline_frame *const frame = &decoder->stack[decoder->depth++];
+    frame->end = end;
+    frame->kind = kind;
+    frame->args_left = args_left;
+    frame->has_annots = has_annots;
+    return true;
+}
+
+static inline void read_length(struct micheline_decoder *const decoder, uint8_t const tag) {
+    decoder->tag = tag;
+    decoder->fill = 0;
+    decoder->length = 0;
+    decoder->step = STEP_LENGTH;
+}
+
+// Called when a node ends: closes the nodes that end with it, then sets up what comes next.
+static bool node_complete(struct micheline_decoder *const decoder,
+                          micheline_handler handler,
+                          void *context) {
+    while (decoder->depth != 0) {
+        struct micheline_frame *const frame = &decoder->stack[decoder->depth - 1];
+
+        if (frame->kind == FRAME_ARGS) {
+            if (--frame->args_left != 0) break;
+            decoder->depth--;
+            if (frame->has_annots) {
+                read_length(decoder, TAG_ANNOTS);
+                return true;
+            }
+            continue;  // The primitive ends with its last argument.
+        }
+
+        if (decoder->offset < frame->end) break;
+        if (decoder->offset > frame->end) return false;  // A node overran its parent
+        decoder->depth--;
+        if (frame->kind == FRAME_GENERIC_ARGS) {
+            read_length(decoder, TAG_ANNOTS);
+            return true;
+        }
+        if (!emit(decoder, MICHELINE_SEQ_END, handler, context)) return false;
+    }
+
+    if (decoder->depth != 0) {
+        decoder->step = STEP_NODE;
+    } else if (decoder->offset == decoder->end) {
+        decoder->step = STEP_DONE;
+    } else {
+        return false;  // Anything after the first node
+    }
+    return true;
+}
+
+// For nodes prefixed with their size; `length` was just read.
+static bool open_node(struct micheline_decoder *const decoder,
+                      uint8_t const kind,
+                      micheline_handler handler,
+                      void *context) {
+    if (decoder->length > decoder->end - decoder->offset) return false;
+    if (!push(decoder, kind, decoder->offset + decoder->length, 0, false)) return false;
+    if (kind == FRAME_SEQUENCE && !emit(decoder, MICHELINE_SEQ_BEGIN, handler, context)) {
+        return false;
+    }
+    return node_complete(decoder, handler, context);  // Closes it right away if it is empty
+}
+
+static bool data_complete(struct micheline_decoder *const decoder,
+                          micheline_handler handler,
+                          void *context) {
+    decoder->event.length = decoder->length;
+    decoder->event.data = decoder->data;
+    enum micheline_event_kind kind;
+    switch (decoder->tag) {
+        case MICHELSON_TYPE_STRING:
+            kind = MICHELINE_STRING;
+            break;
+        case MICHELSON_TYPE_BYTE_SEQUENCE:
+            kind = MICHELINE_BYTES;
+            break;
+        default:
+            kind = MICHELINE_ANNOTS;
+            break;
+    }
+    if (!emit(decoder, kind, handler, context)) return false;
+    return node_complete(decoder, handler, context);
+}
+
+static bool length_complete(struct micheline_decoder *const decoder,
+                            micheline_handler handler,
+                            void *context) {
+    switch (decoder->tag) {
+        case MICHELSON_TYPE_SEQUENCE:
+            return open_node(decoder, FRAME_SEQUENCE, handler, context);
+        case MICHELSON_TYPE_PRIM_GENERIC:
+            return open_node(decoder, FRAME_GENERIC_ARGS, handler, context);
+        default:  // String, byte sequence or annotations
+            if (decoder->length > decoder->end - decoder->offset) return false;
+            decoder->read = 0;
+            decoder->step = STEP_DATA;
+            if (decoder->length == 0) return data_complete(decoder, handler, context);
+            return true;
+    }
+}
+
+static bool prim_complete(struct micheline_decoder *const decoder,
+                          uint8_t const prim,
+                          micheline_handler handler,
+                          void *context) {
+    decoder->event.code = (uint16_t) decoder->tag << 8 | prim;
+    if (!emit(decoder, MICHELINE_PRIM, handler, context)) return false;
+
+    switch (decoder->tag) {
+        case MICHELSON_TYPE_PRIM:
+            return node_complete(decoder, handler, context);
+        case MICHELSON_TYPE_PRIM_ANNOTS:
+            read_length(decoder, TAG_ANNOTS);
+            return true;
+        case MICHELSON_TYPE_PRIM_1:
+        case MICHELSON_TYPE_PRIM_1_ANNOTS:
+            decoder->step = STEP_NODE;
+            return push(decoder,
+                        FRAME_ARGS,
+                        0,
+                        1,
+                        decoder->tag == MICHELSON_TYPE_PRIM_1_ANNOTS);
+        case MICHELSON_TYPE_PRIM_2:
+        case MICHELSON_TYPE_PRIM_2_ANNOTS:
+            decoder->step = STEP_NODE;
+            return push(decoder,
+                        FRAME_ARGS,
+                        0,
+                        2,
+                        decoder->tag == MICHELSON_TYPE_PRIM_2_ANNOTS);
+        default:  // MICHELSON_TYPE_PRIM_GENERIC
+            read_length(decoder, MICHELSON_TYPE_PRIM_GENERIC);
+            return true;
+    }
+}
+
+static bool int_byte(struct micheline_decoder *const decoder,
+                     uint8_t const byte,
+                     micheline_handler handler,
+                     void *context) {
+    struct micheline_event *const event = &decoder->event;
+    if (decoder->shift == 0) {
+        // The first byte holds the sign and the 6 lowest bits.
+        event->negative = byte & 0x40;
+        event->value = byte & 0x3F;
+        decoder->shift = 6;
+    } else {
+        uint64_t const bits = byte & 0x7F;
+        if (decoder->shift >= 64 || (bits << decoder->shift) >> decoder->shift != bits) {
+            return false;  // Does not fit in 64 bits
+        }
+        event->value |= bits << decoder->shift;
+        decoder->shift += 7;
+    }
+    if (byte & 0x80) return true;  // More bytes to come
+
+    if (!emit(decoder, MICHELINE_INT, handler, context)) return false;
+    return node_complete(decoder, handler, context);
+}
+
+bool micheline_feed(struct micheline_decoder *const decoder,
+                    uint8_t const byte,
+                    micheline_handler handler,
+                    void *context) {
+    if (decoder->offset == decoder->end) return false;  // Past the end of the input
+    decoder->offset++;
+
+    switch (decoder->step) {
+        case STEP_NODE:
+            decoder->tag = byte;
+            switch (byte) {
+                case MICHELSON_TYPE_INT:
+                    decoder->shift = 0;
+                    decoder->step = STEP_INT;
+                    return true;
+                case MICHELSON_TYPE_STRING:
+                case MICHELSON_TYPE_SEQUENCE:
+                case MICHELSON_TYPE_BYTE_SEQUENCE:
+                    read_length(decoder, byte);
+                    return true;
+                case MICHELSON_TYPE_PRIM:
+                case MICHELSON_TYPE_PRIM_ANNOTS:
+                case MICHELSON_TYPE_PRIM_1:
+                case MICHELSON_TYPE_PRIM_1_ANNOTS:
+                case MICHELSON_TYPE_PRIM_2:
+                case MICHELSON_TYPE_PRIM_2_ANNOTS:
+                case MICHELSON_TYPE_PRIM_GENERIC:
+                    decoder->step = STEP_PRIM;
+                    return true;
+                default:
+                    return false;
+            }
+
+        case STEP_PRIM:
+            return prim_complete(decoder, byte, handler, context);
+
+        case STEP_LENGTH:
+            decoder->length = decoder->length << 8 | byte;
+            if (++decoder->fill < sizeof(decoder->length)) return true;
+            return length_complete(decoder, handler, context);
+
+        case STEP_DATA:
+            if (decoder->read < sizeof(decoder->data)) decoder->data[decoder->read] = byte;
+            if (++decoder->read < decoder->length) return true;
+            return data_complete(decoder, handler, context);
+
+        case STEP_INT:
+            return int_byte(decoder, byte, handler, context);
+
+        default:
+            return false;
+    }
+}
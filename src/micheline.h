@@ -0,0 +1,77 @@
+// Streaming decoder for binary Micheline, the encoding of Michelson parameters.
+//
+// Bytes are fed one at a time, as they arrive across APDUs, and the decoder reports the nodes it
+// finds as a flat stream of events. It keeps an explicit stack of the nodes it is inside of, so
+// its state has a fixed size however long the input is; nesting deeper than
+// MICHELINE_MAX_DEPTH is rejected.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "types.h"
+
+#define MICHELINE_MAX_DEPTH 8
+
+// Strings, byte sequences and annotations up to this size are passed along with their event
+// (enough for a base58 address); only the length of longer ones is.
+#define MICHELINE_MAX_DATA_LENGTH HASH_SIZE_B58
+
+enum micheline_event_kind {
+    MICHELINE_INT,
+    MICHELINE_STRING,
+    MICHELINE_BYTES,
+    MICHELINE_PRIM,     // Followed by the events of its arguments, then MICHELINE_ANNOTS if any
+    MICHELINE_ANNOTS,   // Space-separated annotations of the last primitive
+    MICHELINE_SEQ_BEGIN,
+    MICHELINE_SEQ_END,
+};
+
+struct micheline_event {
+    enum micheline_event_kind kind;
+    uint16_t code;        // MICHELINE_PRIM: node tag and primitive, as in `enum michelson_code`
+    bool negative;        // MICHELINE_INT
+    uint64_t value;       // MICHELINE_INT: absolute value
+    uint32_t length;      // MICHELINE_STRING, MICHELINE_BYTES and MICHELINE_ANNOTS
+    uint8_t const *data;  // The first min(length, MICHELINE_MAX_DATA_LENGTH) bytes
+};
+
+// Called for every event, in order. Returning false stops decoding, and micheline_feed returns
+// false.
+typedef bool (*micheline_handler)(struct micheline_event const *event, void *context);
+
+struct micheline_frame {
+    uint32_t end;       // Offset just past the node, for nodes that are prefixed with their size
+    uint8_t kind;       // What the node is; see micheline.c
+    uint8_t args_left;  // For primitives with a fixed number of arguments
+    bool has_annots;
+};
+
+struct micheline_decoder {
+    uint32_t offset;  // Bytes fed so far
+    uint32_t end;     // Size of the whole input, which must hold exactly one node
+    uint8_t step;     // What the next byte is
+    uint8_t tag;      // Of the node being read
+    uint8_t fill;     // Bytes of `length` read so far
+    uint8_t depth;
+    uint32_t length;  // Of the string, byte sequence or annotations being read
+    uint32_t read;    // Bytes of them read so far
+    uint8_t shift;    // Of the next bits of an integer
+    struct micheline_event event;
+    struct micheline_frame stack[MICHELINE_MAX_DEPTH];
+    uint8_t data[MICHELINE_MAX_DATA_LENGTH];
+};
+
+// `length` is the size of the input, as given by its length prefix.
+void micheline_init(struct micheline_decoder *const decoder, uint32_t const length);
+
+// Returns false if the input is not valid Micheline, does not fit the decoder, or was refused by
+// `handler`. Nothing throws: this runs for every byte of the parameters.
+bool micheline_feed(struct micheline_decoder *const decoder,
+                    uint8_t const byte,
+                    micheline_handler handler,
+                    void *context);
+
+// True once the whole input has been decoded.
+bool micheline_done(struct micheline_decoder const *const decoder);
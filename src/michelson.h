@@ -1,5 +1,5 @@
-// Subset of Michelson constants, used in parsing manager.tz
-// operations.
+// Subset of Michelson constants, used in decoding Micheline and
+// matching manager.tz operations.
 
 #pragma once
 
@@ -29,9 +29,18 @@ enum michelson_code {
     MICHELSON_CONTRACT_UNIT = 0x036c,
 };
 
+// Tags of the nodes of binary Micheline
 enum michelson_type {
+    MICHELSON_TYPE_INT = 0x00,
     MICHELSON_TYPE_STRING = 0x01,
     MICHELSON_TYPE_SEQUENCE = 0x02,
+    MICHELSON_TYPE_PRIM = 0x03,  // Without arguments or annotations
+    MICHELSON_TYPE_PRIM_ANNOTS = 0x04,
+    MICHELSON_TYPE_PRIM_1 = 0x05,  // One argument
+    MICHELSON_TYPE_PRIM_1_ANNOTS = 0x06,
+    MICHELSON_TYPE_PRIM_2 = 0x07,  // Two arguments
+    MICHELSON_TYPE_PRIM_2_ANNOTS = 0x08,
+    MICHELSON_TYPE_PRIM_GENERIC = 0x09,  // Any number of arguments, and annotations
     MICHELSON_TYPE_BYTE_SEQUENCE = 0x0a,
 };
 
@@ -40,8 +49,6 @@ enum michelson_params_tag {
     MICHELSON_PARAMS_SOME = 0xff,
 };
 
-#define MAX_MICHELSON_SEQUENCE_LENGTH 200
-
 #define MAX_ENTRYPOINT_LENGTH 31
 enum entrypoint_tag {
     ENTRYPOINT_DEFAULT = 0,
@@ -1,6 +1,7 @@
 #include "operations.h"
 
 #include "apdu.h"
+#include "apdu_trace.h"
 #include "globals.h"
 #include "memory.h"
 #include "to_string.h"
@@ -10,31 +11,27 @@
 #include <stdint.h>
 #include <string.h>
 
-#define STEP_HARD_FAIL -2
-
-// Argument is to distinguish between different parse errors for debugging purposes only
-__attribute__((noreturn)) static void parse_error(
-#ifndef TEZOS_DEBUG
-    __attribute__((unused))
-#endif
-    uint32_t lineno) {
+// Nothing in here throws while bytes are parsed: the parser runs for every byte of every packet,
+// and a TRY context per packet costs more than the parsing itself. Errors are returned instead,
+// up to parse_operations_packet, which returns false.
 
-    global.apdu.u.sign.parse_state.op_step = STEP_HARD_FAIL;
-#ifdef TEZOS_DEBUG
-    THROW(0x9000 + lineno);
-#else
-    THROW(EXC_PARSE_ERROR);
-#endif
-}
+#define STEP_HARD_FAIL -2
 
-#define PARSE_ERROR() parse_error(__LINE__)
+// Returns STEP_HARD_FAIL from a step handler. The line tells parse errors apart in debug builds,
+// and in the trace.
+#define PARSE_ERROR()                                           \
+    do {                                                        \
+        PRINTF("Parse error at line %d\n", __LINE__);           \
+        trace(TRACE_OPERATION_ERROR, state->op_step, __LINE__); \
+        return STEP_HARD_FAIL;                                  \
+    } while (0)
 
 // Conversion/check functions
 
+// Returns SIGNATURE_TYPE_UNSET for anything unknown.
 static inline signature_type_t parse_raw_tezos_header_signature_type(
     raw_tezos_header_signature_type_t const *const raw_signature_type) {
-    check_null(raw_signature_type);
-    switch (READ_UNALIGNED_BIG_ENDIAN(uint8_t, &raw_signature_type->v)) {
+    switch (raw_signature_type->v) {
         case 0:
             return SIGNATURE_TYPE_ED25519;
         case 1:
@@ -42,7 +39,7 @@ static inline signature_type_t parse_raw_tezos_header_signature_type(
         case 2:
             return SIGNATURE_TYPE_SECP256R1;
         default:
-            PARSE_ERROR();
+            return SIGNATURE_TYPE_UNSET;
     }
 }
 
@@ -53,935 +50,936 @@ static inline void compute_pkh(cx_ecfp_public_key_t *const compressed_pubkey_out
     check_null(bip32_path);
     check_null(compressed_pubkey_out);
     check_null(contract_out);
-    cx_ecfp_public_key_t pubkey = {0};
-    generate_public_key(&pubkey, derivation_type, bip32_path);
+    cx_ecfp_public_key_t *const pubkey = SCRATCH_BORROW(cx_ecfp_public_key_t);
+    generate_public_key(pubkey, derivation_type, bip32_path);
     public_key_hash(contract_out->hash,
                     sizeof(contract_out->hash),
                     compressed_pubkey_out,
                     derivation_type,
-                    &pubkey);
-    contract_out->signature_type = derivation_type_to_signature_type(derivation_type);
-    if (contract_out->signature_type == SIGNATURE_TYPE_UNSET) THROW(EXC_MEMORY_ERROR);
-    contract_out->originated = 0;
+                    pubkey);
+    SCRATCH_RETURN(pubkey);
+    contract_out->kind = derivation_type_to_signature_type(derivation_type);
+    if (contract_out->kind == CONTRACT_NONE) THROW(EXC_MEMORY_ERROR);
 }
 
-static inline void parse_implicit(parsed_contract_t *const out,
+// These return false if the signature type is unknown.
+
+static inline bool parse_implicit(parsed_contract_t *const out,
                                   raw_tezos_header_signature_type_t const *const raw_signature_type,
                                   uint8_t const hash[HASH_SIZE]) {
-    check_null(raw_signature_type);
-    out->originated = 0;
-    out->signature_type = parse_raw_tezos_header_signature_type(raw_signature_type);
+    out->kind = parse_raw_tezos_header_signature_type(raw_signature_type);
     memcpy(out->hash, hash, sizeof(out->hash));
+    return out->kind != CONTRACT_NONE;
 }
 
-static inline void parse_contract(parsed_contract_t *const out, struct contract const *const in) {
-    out->originated = in->originated;
-    if (out->originated == 0) {  // implicit
-        out->signature_type = parse_raw_tezos_header_signature_type(&in->u.implicit.signature_type);
-        memcpy(out->hash, in->u.implicit.pkh, sizeof(out->hash));
-    } else {  // originated
-        out->signature_type = SIGNATURE_TYPE_UNSET;
-        memcpy(out->hash, in->u.originated.pkh, sizeof(out->hash));
+static inline bool parse_contract(parsed_contract_t *const out, struct contract const *const in) {
+    if (in->originated == 0) {  // implicit
+        return parse_implicit(out, &in->u.implicit.signature_type, in->u.implicit.pkh);
     }
+    out->kind = CONTRACT_ORIGINATED;
+    memcpy(out->hash, in->u.originated.pkh, sizeof(out->hash));
+    return true;
 }
 
-#define CALL_SUBPARSER_LN(func, line, ...) \
-    if (func(__VA_ARGS__, line)) return true
-#define CALL_SUBPARSER(func, ...) CALL_SUBPARSER_LN(func, __LINE__, __VA_ARGS__)
+// The parser reads an operation group as a series of fields. Each step of the parser reads one
+// field and hands it to its handler, which says which step reads the next field; see
+// OPERATION_STEPS below.
+
+// How the field of a step is read.
+enum field_reader {
+    READ_BYTE,
+    READ_Z,           // A Zarith natural
+    READ_FIXED,       // `size` bytes, e.g. one of the packed structs in operations.h
+    READ_LENGTH,      // A 4-byte big-endian length
+    READ_PUBLIC_KEY,  // As many bytes as the public key of the signing key
+    READ_MICHELINE,   // The manager.tz parameters, as long as the length before them
+};
+
+#ifdef HAVE_ATHENS_OPERATIONS
+// Before Babylon, the source of a manager operation was a `struct contract`, and could be
+// originated.
+#define ATHENS_STEPS(X) X(CONTRACT_SOURCE, step_contract_source, READ_FIXED, sizeof(struct contract))
+#else
+#define ATHENS_STEPS(X)
+#endif
 
-// Subparsers: no function here should be called anywhere in this file without using the
-// CALL_SUBPARSER macro above. Verify this with
-// /<funcname>\s*(
-// the only result should be the functiond definition.
+// The layout of an operation group: X(name, handler, reader, size of READ_FIXED fields). Steps
+// are numbered in this order, and a handler returns STEP_NEXT for the step right below its own.
+#define OPERATION_STEPS(X)                                                                 \
+    X(GROUP_HEADER, step_group_header, READ_FIXED, sizeof(struct operation_group_header))  \
+    X(TAG, step_tag, READ_BYTE, 0)                                                         \
+    X(IMPLICIT_SOURCE, step_implicit_source, READ_FIXED, sizeof(struct implicit_contract)) \
+    ATHENS_STEPS(X)                                                                        \
+    /* Manager operations */                                                               \
+    X(FEE, step_fee, READ_Z, 0)                                                            \
+    X(COUNTER, step_ignore, READ_Z, 0)                                                     \
+    X(GAS_LIMIT, step_ignore, READ_Z, 0)                                                   \
+    X(STORAGE_LIMIT, step_storage_limit, READ_Z, 0)                                        \
+    /* Reveal */                                                                           \
+    X(REVEAL_KEY_TYPE,                                                                     \
+      step_reveal_key_type,                                                                \
+      READ_FIXED,                                                                          \
+      sizeof(raw_tezos_header_signature_type_t))                                           \
+    X(REVEAL_KEY, step_reveal_key, READ_PUBLIC_KEY, 0)                                     \
+    /* Proposal and ballot */                                                              \
+    X(PROPOSAL, step_proposal, READ_FIXED, sizeof(struct proposal_contents))               \
+    X(BALLOT, step_ballot, READ_FIXED, sizeof(struct ballot_contents))                     \
+    /* Delegation */                                                                       \
+    X(DELEGATE_PRESENT, step_delegate_present, READ_BYTE, 0)                               \
+    X(DELEGATE, step_delegate, READ_FIXED, sizeof(struct delegation_contents))             \
+    /* Origination */                                                                      \
+    X(BALANCE, step_balance, READ_Z, 0)                                                    \
+    X(ORIGINATION_DELEGATE_PRESENT, step_origination_delegate_present, READ_BYTE, 0)       \
+    X(ORIGINATION_DELEGATE,                                                                \
+      step_origination_delegate,                                                           \
+      READ_FIXED,                                                                          \
+      sizeof(struct delegation_contents))                                                  \
+    X(CODE, step_code, READ_LENGTH, 0)                                                     \
+    X(STORAGE, step_storage, READ_LENGTH, 0)                                               \
+    /* Transaction */                                                                      \
+    X(AMOUNT, step_amount, READ_Z, 0)                                                      \
+    X(DESTINATION, step_destination, READ_FIXED, sizeof(struct contract))                  \
+    X(HAS_PARAMETERS, step_has_parameters, READ_BYTE, 0)                                   \
+    X(ENTRYPOINT, step_entrypoint, READ_BYTE, 0)                                           \
+    X(MANAGER_TZ_LENGTH, step_manager_tz_length, READ_LENGTH, 0)                           \
+    X(MANAGER_TZ_PARAMETERS, step_manager_tz_parameters, READ_MICHELINE, 0)                \
+    X(ENTRYPOINT_NAME_LENGTH, step_entrypoint_name_length, READ_BYTE, 0)                   \
+    X(ENTRYPOINT_NAME, step_entrypoint_name, READ_BYTE, 0)                                 \
+    X(PARAMETERS, step_parameters, READ_LENGTH, 0)
+
+enum parse_step {
+#define STEP_ENUM(name, handler, reader, size) STEP_##name,
+    OPERATION_STEPS(STEP_ENUM)
+#undef STEP_ENUM
+};
+
+// Steps that read nothing
+#define STEP_NEXT           -3  // Returned by handlers only
+#define STEP_END_OF_MESSAGE -1
+
+struct step_field {
+    uint8_t reader;  // enum field_reader
+    uint8_t size;
+};
+
+static const struct step_field step_fields[] = {
+#define STEP_FIELD(name, handler, reader, size) {reader, size},
+    OPERATION_STEPS(STEP_FIELD)
+#undef STEP_FIELD
+};
+
+#define STEP_SIZE_FITS(name, handler, reader, size)                                 \
+    _Static_assert((size) <= sizeof(((struct nexttype_subparser_state *) 0)->body), \
+                   #name " does not fit");
+OPERATION_STEPS(STEP_SIZE_FITS)
+#undef STEP_SIZE_FITS
+
+// Gets ready to read the field of `state->op_step`.
+static inline void start_field(struct parse_state *const state) {
+    if (state->op_step < 0) return;
+    switch (step_fields[state->op_step].reader) {
+        case READ_Z:
+            state->subparser_state.integer.value = 0;
+            state->subparser_state.integer.shift = 0;
+            break;
+        case READ_MICHELINE:
+            break;  // Set up by the step before
+        default:
+            state->subparser_state.nexttype.fill_idx = 0;
+            break;
+    }
+}
 
-#define NEXT_BYTE (byte)
+void parse_operations_init(struct parsed_operation_group *const out,
+                           derivation_type_t derivation_type,
+                           bip32_path_t const *const bip32_path,
+                           struct parse_state *const state) {
+    check_null(out);
+    check_null(bip32_path);
+    memset(out, 0, sizeof(*out));
 
-static inline bool parse_z(uint8_t current_byte,
-                           struct int_subparser_state *state,
-                           uint32_t lineno) {
-    if (state->lineno != lineno) {
-        // New call; initialize.
-        state->lineno = lineno;
-        state->value = 0;
-        state->shift = 0;
-    }
-    state->value |= ((uint64_t) current_byte & 0x7F) << state->shift;
-    state->shift += 7;
-    return current_byte & 0x80;  // Return true if we need more bytes.
-}
-
-#define PARSE_Z                                                             \
-    ({                                                                      \
-        CALL_SUBPARSER(parse_z, (byte), &(state)->subparser_state.integer); \
-        (state)->subparser_state.integer.value;                             \
-    })
-
-// Only used through the macro
-static inline bool parse_z_michelson(uint8_t current_byte,
-                                     struct int_subparser_state *state,
-                                     uint32_t lineno) {
-    if (state->lineno != lineno) {
-        // New call; initialize.
-        state->lineno = lineno;
-        state->value = 0;
-        state->shift = 0;
-    }
-    state->value |= ((uint64_t) current_byte & 0x7F) << state->shift;
-    // For some reason we are getting numbers shifted 1 bit to the
-    // left. TODO: figure out why this happens
-    if (state->shift == 0) {
-        state->shift += 6;
-    } else {
-        state->shift += 7;
-    }
-    return current_byte & 0x80;  // Return true if we need more bytes.
-}
-
-#define PARSE_Z_MICHELSON                                                             \
-    ({                                                                                \
-        CALL_SUBPARSER(parse_z_michelson, (byte), (&state->subparser_state.integer)); \
-        state->subparser_state.integer.value;                                         \
-    })
-
-static inline bool parse_next_type(uint8_t current_byte,
-                                   struct nexttype_subparser_state *state,
-                                   uint32_t sizeof_type,
-                                   uint32_t lineno) {
-#ifdef DEBUG
-    if (sizeof_type > sizeof(state->body))
-        PARSE_ERROR();  // Shouldn't happen, but error if it does and we're debugging. Neither side
-                        // is dynamic.
-#endif
+    out->operation.tag = OPERATION_TAG_NONE;
 
-    if (state->lineno != lineno) {
-        state->lineno = lineno;
-        state->fill_idx = 0;
-    }
+    compute_pkh(&out->public_key, &out->signing, derivation_type, bip32_path);
 
-    state->body.raw[state->fill_idx] = current_byte;
-    state->fill_idx++;
-
-    return state->fill_idx < sizeof_type;  // Return true if we need more bytes.
-}
-
-// do _NOT_ keep pointers to this data around.
-#define NEXT_TYPE(type)                                                                          \
-    ({                                                                                           \
-        CALL_SUBPARSER(parse_next_type, byte, &(state->subparser_state.nexttype), sizeof(type)); \
-        (const type *) &(state->subparser_state.nexttype.body);                                  \
-    })
-
-static inline bool michelson_read_length(uint8_t current_byte,
-                                         struct nexttype_subparser_state *state,
-                                         uint32_t lineno) {
-    CALL_SUBPARSER_LN(parse_next_type,
-                      lineno,
-                      current_byte,
-                      state,
-                      sizeof(uint32_t));  // Using the line number we were called with.
-    uint32_t res = READ_UNALIGNED_BIG_ENDIAN(uint32_t, &state->body.raw);
-    state->body.i32 = res;
-    return false;
+    // Start out with source = signing, for reveals
+    // TODO: This is slightly hackish
+    memcpy(&out->operation.source, &out->signing, sizeof(out->signing));
+
+    state->op_step = STEP_GROUP_HEADER;
+    start_field(state);
+    state->tag = OPERATION_TAG_NONE;  // This and the rest shouldn't be required.
+    state->argument_length = 0;
+    state->skip_length = 0;
 }
 
-#define MICHELSON_READ_LENGTH                                                          \
-    ({                                                                                 \
-        CALL_SUBPARSER(michelson_read_length, byte, &state->subparser_state.nexttype); \
-        state->subparser_state.nexttype.body.i32;                                      \
-    })
+// Only plain transactions and delegations can be batched; anything else must be alone in its group,
+// apart from reveals.
+static inline bool is_batchable(enum operation_tag const tag) {
+    return tag == OPERATION_TAG_BABYLON_TRANSACTION || tag == OPERATION_TAG_BABYLON_DELEGATION;
+}
 
-static inline bool michelson_read_short(uint8_t current_byte,
-                                        struct nexttype_subparser_state *state,
-                                        uint32_t lineno) {
-    CALL_SUBPARSER_LN(parse_next_type, lineno, current_byte, state, sizeof(uint16_t));
-    uint32_t res = READ_UNALIGNED_BIG_ENDIAN(uint16_t, &state->body.raw);
-    state->body.i16 = res;
-    return false;
+static inline void add_to_batch_total(struct batch_total *const total, uint64_t const amount) {
+    total->operation_count++;
+    total->amount += amount;
 }
 
-#define MICHELSON_READ_SHORT                                                          \
-    ({                                                                                \
-        CALL_SUBPARSER(michelson_read_short, byte, &state->subparser_state.nexttype); \
-        state->subparser_state.nexttype.body.i16;                                     \
-    })
-
-static inline bool michelson_read_address(uint8_t byte,
-                                          parsed_contract_t *const out,
-                                          char *base58_address_buffer,
-                                          struct michelson_address_subparser_state *state,
-                                          uint32_t lineno) {
-    if (state->lineno != lineno) {  // We won't have to use CALL_SUBPARSER_LN because we're
-                                    // initializing ourselves here.
-        memset(state, 0, sizeof(*state));
-        state->lineno = lineno;
-    }
-    switch (state->address_step) {
-        case 0:
-            state->micheline_type = byte;
-            state->address_step = 1;
+// Folds the operation that was just parsed into the batch summary. Returns false if it overflows.
+static bool add_to_batch(struct parsed_operation_group *const out) {
+    struct parsed_batch *const batch = &out->batch;
+    struct parsed_operation const *const op = &out->operation;
+    bool const is_delegation = is_delegation_tag(op->tag);
+
+    // Every other total is bounded by `all`, so checking it is enough.
+    if (batch->all.operation_count == UINT16_MAX) return false;
+    if (batch->all.amount + op->amount < batch->all.amount) return false;
+    add_to_batch_total(&batch->all, op->amount);
+    if (op->amount > batch->largest_amount) batch->largest_amount = op->amount;
+    if (is_delegation) batch->delegation_count++;
+
+    for (size_t i = 0; i < batch->destination_count; i++) {
+        struct batch_destination *const entry = &batch->destinations[i];
+        if (entry->is_delegation == is_delegation &&
+            COMPARE(&entry->destination, &op->destination) == 0) {
+            add_to_batch_total(&entry->total, op->amount);
             return true;
+        }
+    }
 
-        case 1:
+    if (batch->destination_count < NUM_ELEMENTS(batch->destinations)) {
+        struct batch_destination *const entry = &batch->destinations[batch->destination_count];
+        batch->destination_count++;
+        memcpy(&entry->destination, &op->destination, sizeof(entry->destination));
+        entry->is_delegation = is_delegation;
+        add_to_batch_total(&entry->total, op->amount);
+    } else {
+        add_to_batch_total(&batch->others, op->amount);
+    }
+    return true;
+}
 
-            CALL_SUBPARSER(michelson_read_length, byte, &state->subsub_state);
-            state->addr_length = state->subsub_state.body.i32;
+// manager.tz parameters are matched against these patterns as they are decoded, all at once: each
+// event rules out the patterns that do not expect it next. A pattern lists the Micheline events of
+// a manager.tz script and ends with MATCH_END, whose `code` says what the operation does.
+enum manager_tz_match {
+    MATCH_END,
+    MATCH_PRIM,  // The primitive in `code`
+    MATCH_SEQ_BEGIN,
+    MATCH_SEQ_END,
+    MATCH_KEY_HASH,       // The destination, as a key_hash
+    MATCH_ADDRESS,        // The destination, as an address
+    MATCH_AMOUNT,         // The amount, in mutez
+    MATCH_DEFAULT_ANNOT,  // Entrypoint annotation of CONTRACT
+};
+
+enum manager_tz_action {
+    MANAGER_TZ_SET_DELEGATE,
+    MANAGER_TZ_REMOVE_DELEGATE,
+    MANAGER_TZ_TRANSFER,
+};
+
+struct manager_tz_step {
+    uint8_t match;  // enum manager_tz_match
+    uint16_t code;  // enum michelson_code for MATCH_PRIM, enum manager_tz_action for MATCH_END
+};
+
+#define PRIM(code)  {MATCH_PRIM, code}
+#define SEQ_BEGIN   {MATCH_SEQ_BEGIN, 0}
+#define SEQ_END     {MATCH_SEQ_END, 0}
+#define END(action) {MATCH_END, action}
+
+// DROP ; NIL operation ; ...
+#define MANAGER_TZ_PROLOGUE                                                         \
+    SEQ_BEGIN, PRIM(MICHELSON_DROP), PRIM(MICHELSON_NIL), PRIM(MICHELSON_OPERATION)
+// ... ; CONS
+#define MANAGER_TZ_EPILOGUE PRIM(MICHELSON_CONS), SEQ_END
+// PUSH mutez <amount> ; UNIT ; TRANSFER_TOKENS
+#define MANAGER_TZ_TRANSFER_TOKENS                                                        \
+    PRIM(MICHELSON_PUSH), PRIM(MICHELSON_MUTEZ), {MATCH_AMOUNT, 0}, PRIM(MICHELSON_UNIT), \
+        PRIM(MICHELSON_TRANSFER_TOKENS)
+// ASSERT_SOME, i.e. IF_NONE { { UNIT ; FAILWITH } } {}
+#define MANAGER_TZ_ASSERT_SOME                                                                     \
+    PRIM(MICHELSON_IF_NONE), SEQ_BEGIN, SEQ_BEGIN, PRIM(MICHELSON_UNIT), PRIM(MICHELSON_FAILWITH), \
+        SEQ_END, SEQ_END, SEQ_BEGIN, SEQ_END
+
+#define NUM_MANAGER_TZ_PATTERNS       5
+#define MAX_MANAGER_TZ_PATTERN_LENGTH 27
+
+static const struct manager_tz_step manager_tz_patterns[NUM_MANAGER_TZ_PATTERNS]
+                                                       [MAX_MANAGER_TZ_PATTERN_LENGTH] = {
+    // Set delegate: PUSH key_hash <delegate> ; SOME ; SET_DELEGATE
+    {MANAGER_TZ_PROLOGUE,
+     PRIM(MICHELSON_PUSH),
+     PRIM(MICHELSON_KEY_HASH),
+     {MATCH_KEY_HASH, 0},
+     PRIM(MICHELSON_SOME),
+     PRIM(MICHELSON_SET_DELEGATE),
+     MANAGER_TZ_EPILOGUE,
+     END(MANAGER_TZ_SET_DELEGATE)},
+
+    // Remove delegate: NONE key_hash ; SET_DELEGATE
+    {MANAGER_TZ_PROLOGUE,
+     PRIM(MICHELSON_NONE),
+     PRIM(MICHELSON_KEY_HASH),
+     PRIM(MICHELSON_SET_DELEGATE),
+     MANAGER_TZ_EPILOGUE,
+     END(MANAGER_TZ_REMOVE_DELEGATE)},
+
+    // Transfer to an implicit account: PUSH key_hash <destination> ; IMPLICIT_ACCOUNT ; ...
+    {MANAGER_TZ_PROLOGUE,
+     PRIM(MICHELSON_PUSH),
+     PRIM(MICHELSON_KEY_HASH),
+     {MATCH_KEY_HASH, 0},
+     PRIM(MICHELSON_IMPLICIT_ACCOUNT),
+     MANAGER_TZ_TRANSFER_TOKENS,
+     MANAGER_TZ_EPILOGUE,
+     END(MANAGER_TZ_TRANSFER)},
+
+    // Transfer to a contract: PUSH address <destination> ; CONTRACT unit ; ASSERT_SOME ; ...
+    {MANAGER_TZ_PROLOGUE,
+     PRIM(MICHELSON_PUSH),
+     PRIM(MICHELSON_ADDRESS),
+     {MATCH_ADDRESS, 0},
+     PRIM(MICHELSON_CONTRACT),
+     PRIM(MICHELSON_CONTRACT_UNIT),
+     MANAGER_TZ_ASSERT_SOME,
+     MANAGER_TZ_TRANSFER_TOKENS,
+     MANAGER_TZ_EPILOGUE,
+     END(MANAGER_TZ_TRANSFER)},
+
+    // The same, with CONTRACT %default unit
+    {MANAGER_TZ_PROLOGUE,
+     PRIM(MICHELSON_PUSH),
+     PRIM(MICHELSON_ADDRESS),
+     {MATCH_ADDRESS, 0},
+     PRIM(MICHELSON_CONTRACT_WITH_ENTRYPOINT),
+     PRIM(MICHELSON_CONTRACT_UNIT),
+     {MATCH_DEFAULT_ANNOT, 0},
+     MANAGER_TZ_ASSERT_SOME,
+     MANAGER_TZ_TRANSFER_TOKENS,
+     MANAGER_TZ_EPILOGUE,
+     END(MANAGER_TZ_TRANSFER)},
+};
+
+#define DEFAULT_ANNOT "%default"
+
+struct manager_tz_match_context {
+    struct parse_state *state;
+    struct parsed_operation_group *out;
+};
+
+// A string or bytes event holding the destination. Key hashes are `implicit_contract`s in binary
+// and addresses are `contract`s; either can also be a base58 string.
+static bool match_destination(struct micheline_event const *const event,
+                              bool const is_address,
+                              parsed_contract_t *const out) {
+    if (event->kind == MICHELINE_STRING) {
+        if (!base58_to_parsed_contract(out, (char const *) event->data, event->length)) {
+            return false;
+        }
+        return is_address || contract_is_implicit(out);
+    }
+    if (event->kind != MICHELINE_BYTES) return false;
+    if (is_address) {
+        if (event->length != sizeof(struct contract)) return false;
+        return parse_contract(out, (struct contract const *) event->data);
+    }
+    if (event->length != sizeof(struct implicit_contract)) return false;
+    struct implicit_contract const *const implicit = (struct implicit_contract const *) event->data;
+    return parse_implicit(out, &implicit->signature_type, implicit->pkh);
+}
 
-            state->address_step = 2;
+static bool match_manager_tz_step(struct manager_tz_step const *const step,
+                                  struct micheline_event const *const event,
+                                  struct parsed_operation_group *const out) {
+    switch (step->match) {
+        case MATCH_PRIM:
+            return event->kind == MICHELINE_PRIM && event->code == step->code;
+        case MATCH_SEQ_BEGIN:
+            return event->kind == MICHELINE_SEQ_BEGIN;
+        case MATCH_SEQ_END:
+            return event->kind == MICHELINE_SEQ_END;
+        case MATCH_KEY_HASH:
+            return match_destination(event, false, &out->operation.destination);
+        case MATCH_ADDRESS:
+            return match_destination(event, true, &out->operation.destination);
+        case MATCH_AMOUNT:
+            if (event->kind != MICHELINE_INT || event->negative) return false;
+            out->operation.amount = event->value;
             return true;
-        default: {
-            switch (state->micheline_type) {
-                case MICHELSON_TYPE_BYTE_SEQUENCE: {
-                    switch (state->address_step) {
-                        case 2:
-
-                            // Need 1 byte for signature, plus the rest of the hash.
-                            if (state->addr_length != HASH_SIZE + 1) {
-                                PARSE_ERROR();
-                            }
-
-                            CALL_SUBPARSER(parse_next_type,
-                                           byte,
-                                           &(state->subsub_state),
-                                           sizeof(state->signature_type));
-                            memcpy(&(state->signature_type),
-                                   &(state->subsub_state.body),
-                                   sizeof(state->signature_type));
-
-                        case 3:
-
-                            CALL_SUBPARSER(parse_next_type,
-                                           byte,
-                                           &(state->subsub_state),
-                                           sizeof(state->key_hash));
-                            memcpy(&(state->key_hash),
-                                   &(state->subsub_state.body),
-                                   sizeof(state->key_hash));
-
-                            parse_implicit(out,
-                                           &state->signature_type,
-                                           (const uint8_t *) &state->key_hash);
-
-                            return false;
-                    }
-                    case MICHELSON_TYPE_STRING: {
-                        if (state->addr_length != HASH_SIZE_B58) {
-                            PARSE_ERROR();
-                        }
-
-                        CALL_SUBPARSER(parse_next_type,
-                                       byte,
-                                       &(state->subsub_state),
-                                       sizeof(state->subsub_state.body.text_pkh));
-
-                        memcpy(base58_address_buffer,
-                               state->subsub_state.body.text_pkh,
-                               sizeof(state->subsub_state.body.text_pkh));
-                        out->hash_ptr = base58_address_buffer;
-                        out->originated = false;
-                        out->signature_type = SIGNATURE_TYPE_UNSET;
-                        return false;
-                    }
-                    default:
-                        PARSE_ERROR();
-                }
-            }
+        case MATCH_DEFAULT_ANNOT:
+            return event->kind == MICHELINE_ANNOTS && event->length == strlen(DEFAULT_ANNOT) &&
+                   memcmp(event->data, DEFAULT_ANNOT, strlen(DEFAULT_ANNOT)) == 0;
+        default:  // MATCH_END: nothing may follow
+            return false;
+    }
+}
+
+// Returns false once no pattern matches any more.
+static bool match_manager_tz_event(struct micheline_event const *const event, void *context) {
+    struct parse_state *const state = ((struct manager_tz_match_context *) context)->state;
+    struct parsed_operation_group *const out = ((struct manager_tz_match_context *) context)->out;
+    uint8_t const position = state->manager_tz_position;
+
+    for (uint8_t i = 0; i < NUM_MANAGER_TZ_PATTERNS; i++) {
+        if (!(state->manager_tz_candidates & (1 << i))) continue;
+        if (!match_manager_tz_step(&manager_tz_patterns[i][position], event, out)) {
+            state->manager_tz_candidates &= ~(1 << i);
         }
     }
+    if (state->manager_tz_candidates == 0) return false;
+    state->manager_tz_position++;
+    return true;
 }
 
-#define MICHELSON_READ_ADDRESS(out, buffer) \
-    CALL_SUBPARSER(michelson_read_address,  \
-                   byte,                    \
-                   (out),                   \
-                   buffer,                  \
-                   &state->subparser_state.michelson_address)
+// Applies the pattern that matched the whole script. Returns false if the script ended before any
+// pattern did.
+static bool manager_tz_complete(struct parse_state *const state,
+                                struct parsed_operation_group *const out) {
+    for (uint8_t i = 0; i < NUM_MANAGER_TZ_PATTERNS; i++) {
+        struct manager_tz_step const *const step =
+            &manager_tz_patterns[i][state->manager_tz_position];
+        if (!(state->manager_tz_candidates & (1 << i)) || step->match != MATCH_END) continue;
+
+        switch (step->code) {
+            case MANAGER_TZ_SET_DELEGATE:
+                out->operation.tag = OPERATION_TAG_BABYLON_DELEGATION;
+                return true;
+            case MANAGER_TZ_REMOVE_DELEGATE:
+                out->operation.tag = OPERATION_TAG_BABYLON_DELEGATION;
+                memset(&out->operation.destination, 0, sizeof(out->operation.destination));
+                return true;
+            default:  // MANAGER_TZ_TRANSFER
+                out->operation.tag = OPERATION_TAG_BABYLON_TRANSACTION;
+                return true;
+        }
+    }
+    return false;
+}
 
-// End of subparsers.
+// Step handlers: each is called once its field is read, and returns the step that reads the next,
+// or STEP_HARD_FAIL.
 
-void parse_operations_init(struct parsed_operation_group *const out,
-                           derivation_type_t derivation_type,
-                           bip32_path_t const *const bip32_path,
-                           struct parse_state *const state) {
-    check_null(out);
-    check_null(bip32_path);
-    memset(out, 0, sizeof(*out));
+// Most handlers only use some of the parameters.
+#define STEP_HANDLER(name)                                                                   \
+    static int16_t name(__attribute__((unused)) struct parse_state *const state,             \
+                        __attribute__((unused)) struct parsed_operation_group *const out,    \
+                        __attribute__((unused)) is_operation_allowed_t is_operation_allowed)
 
-    out->operation.tag = OPERATION_TAG_NONE;
+// The field that was just read
+#define FIELD_BYTE   (state->subparser_state.nexttype.body.raw[0])
+#define FIELD_Z      (state->subparser_state.integer.value)
+#define FIELD_LENGTH (state->subparser_state.nexttype.body.i32)
+#define FIELD(type)  ((type const *) &state->subparser_state.nexttype.body)
 
-    compute_pkh(&out->public_key, &out->signing, derivation_type, bip32_path);
+// Hash the next `length` bytes without parsing them, then go on with the next step.
+#define SKIP_OPAQUE(length) state->skip_length = (length)
 
-    // Start out with source = signing, for reveals
-    // TODO: This is slightly hackish
-    memcpy(&out->operation.source, &out->signing, sizeof(out->signing));
+STEP_HANDLER(step_ignore) {
+    return STEP_NEXT;
+}
 
-    state->op_step = 0;
-    state->subparser_state.integer.lineno = -1;
-    state->tag = OPERATION_TAG_NONE;  // This and the rest shouldn't be required.
-    state->argument_length = 0;
-    state->michelson_op = -1;
-}
-
-// Named steps in the top-level state machine
-#define STEP_END_OF_MESSAGE                         -1
-#define STEP_OP_TYPE_DISPATCH                       10001
-#define STEP_AFTER_MANAGER_FIELDS                   10002
-#define STEP_HAS_DELEGATE                           10003
-#define STEP_MICHELSON_FIRST_IS_PUSH                10010
-#define STEP_MICHELSON_FIRST_IS_NONE                10011
-#define STEP_MICHELSON_SECOND_IS_KEY_HASH           10012
-#define STEP_MICHELSON_CONTRACT_TO_CONTRACT         10013
-#define STEP_MICHELSON_SET_DELEGATE_CHAIN           10014
-#define STEP_MICHELSON_CONTRACT_TO_IMPLICIT_CHAIN   10015
-#define STEP_MICHELSON_CONTRACT_END                 10016
-#define STEP_MICHELSON_CHECKING_CONTRACT_ENTRYPOINT 10017
-#define STEP_MICHELSON_CONTRACT_TO_CONTRACT_CHAIN_2 10018
+STEP_HANDLER(step_group_header) {
+    // Verify magic byte, ignore block hash
+    if (FIELD(struct operation_group_header)->magic_byte != MAGIC_BYTE_UNSAFE_OP) PARSE_ERROR();
+    return STEP_NEXT;
+}
 
-bool parse_operations_final(struct parse_state *const state,
-                            struct parsed_operation_group *const out) {
-    if (out->operation.tag == OPERATION_TAG_NONE && !out->has_reveal) {
-        return false;
+STEP_HANDLER(step_tag) {
+    state->tag = FIELD_BYTE;
+
+    if (!is_operation_allowed(state->tag)) PARSE_ERROR();
+
+    // Parse 'source'
+    switch (state->tag) {
+        // Tags that don't have "originated" byte only support tz accounts, not KT or tz.
+        case OPERATION_TAG_PROPOSAL:
+        case OPERATION_TAG_BALLOT:
+        case OPERATION_TAG_BABYLON_DELEGATION:
+        case OPERATION_TAG_BABYLON_ORIGINATION:
+        case OPERATION_TAG_BABYLON_REVEAL:
+        case OPERATION_TAG_BABYLON_TRANSACTION:
+            return STEP_IMPLICIT_SOURCE;
+
+#ifdef HAVE_ATHENS_OPERATIONS
+        case OPERATION_TAG_ATHENS_DELEGATION:
+        case OPERATION_TAG_ATHENS_REVEAL:
+        case OPERATION_TAG_ATHENS_TRANSACTION:
+            return STEP_CONTRACT_SOURCE;
+#endif
+
+        default:
+            PARSE_ERROR();
     }
-    return state->op_step == STEP_END_OF_MESSAGE || state->op_step == 1;
 }
 
-static inline bool parse_byte(uint8_t byte,
-                              struct parse_state *const state,
-                              struct parsed_operation_group *const out,
-                              is_operation_allowed_t is_operation_allowed) {
-// OP_STEP finishes the current state transition, setting the state, and introduces the next state.
-// For linear chains of states, this keeps the code structurally similar to equivalent imperative
-// parsing code.
-#define OP_STEP                \
-    state->op_step = __LINE__; \
-    return true;               \
-    case __LINE__:
-
-// The same as OP_STEP, but with a particular name, such that we could jump to this state.
-#define OP_NAMED_STEP(name) \
-    state->op_step = name;  \
-    return true;            \
-    case name:
-
-// "jump" to specific state: (set state to foo and return.)
-#define JMP(step)          \
-    state->op_step = step; \
-    return true
-
-// Set the next state to end-of-message
-#define JMP_EOM JMP(-1)
-
-// Set the next state to start-of-payload; used after reveal.
-#define JMP_TO_TOP JMP(1)
-
-// Conditionally set the next state.
-#define OP_JMPIF(step, cond)   \
-    if (cond) {                \
-        state->op_step = step; \
-        return true;           \
+// Anything but a reveal, once the fields common to manager operations are read.
+static int16_t after_manager_fields(struct parse_state *const state,
+                                    struct parsed_operation_group *const out) {
+    if (out->operation.tag != OPERATION_TAG_NONE) {
+        // Another non-reveal operation was already parsed: both must be batchable.
+        if (!is_batchable(out->operation.tag) || !is_batchable(state->tag)) PARSE_ERROR();
     }
 
-// Shortcuts for defining literal-matching states; mostly used for contract-call boilerplate.
-#define OP_STEP_REQUIRE_SHORT(constant)                       \
-    {                                                         \
-        uint16_t val = MICHELSON_READ_SHORT;                  \
-        if (val != constant) {                                \
-            PRINTF("Expected: %d, got: %d\n", constant, val); \
-            PARSE_ERROR();                                    \
-        }                                                     \
-    }                                                         \
-    OP_STEP
-#define OP_STEP_REQUIRE_BYTE(constant)                         \
-    {                                                          \
-        if (byte != constant) {                                \
-            PRINTF("Expected: %d, got: %d\n", constant, byte); \
-            PARSE_ERROR();                                     \
-        }                                                      \
-    }                                                          \
-    OP_STEP
-#define OP_STEP_REQUIRE_LENGTH(constant)      \
-    {                                         \
-        uint32_t val = MICHELSON_READ_LENGTH; \
-        if (val != constant) {                \
-            PARSE_ERROR();                    \
-        }                                     \
-    }                                         \
-    OP_STEP
+    out->operation.tag = (uint8_t) state->tag;
+    out->operation.amount = 0;
+    memset(&out->operation.destination, 0, sizeof(out->operation.destination));
 
-    switch (state->op_step) {
-        case STEP_HARD_FAIL:
+    // If the source is an implicit contract,...
+    if (out->operation.source.kind != CONTRACT_ORIGINATED) {
+        // ... it had better match our key, otherwise why are we signing it?
+        if (COMPARE(&out->operation.source, &out->signing) != 0) PARSE_ERROR();
+    }
+    // OK, it passes muster.
+
+    // This should by default be blanked out
+    memset(&out->operation.delegate, 0, sizeof(out->operation.delegate));
+
+    switch (state->tag) {
+        case OPERATION_TAG_PROPOSAL:
+            return STEP_PROPOSAL;
+        case OPERATION_TAG_BALLOT:
+            return STEP_BALLOT;
+#ifdef HAVE_ATHENS_OPERATIONS
+        case OPERATION_TAG_ATHENS_DELEGATION:
+#endif
+        case OPERATION_TAG_BABYLON_DELEGATION:
+            return STEP_DELEGATE_PRESENT;
+        case OPERATION_TAG_BABYLON_ORIGINATION:
+            return STEP_BALANCE;
+#ifdef HAVE_ATHENS_OPERATIONS
+        case OPERATION_TAG_ATHENS_TRANSACTION:
+#endif
+        case OPERATION_TAG_BABYLON_TRANSACTION:
+            return STEP_AMOUNT;
+        default:  // Athens originations are not supported any more.
             PARSE_ERROR();
+    }
+}
+
+static int16_t after_source(struct parse_state *const state,
+                            struct parsed_operation_group *const out) {
+    // out->operation.source IS NORMALIZED AT THIS POINT
 
-        case STEP_END_OF_MESSAGE:
-            PARSE_ERROR();  // We already hit a hard end of message; fail.
+    if (state->tag == OPERATION_TAG_PROPOSAL || state->tag == OPERATION_TAG_BALLOT) {
+        return after_manager_fields(state, out);
+    }
+    return STEP_FEE;
+}
 
-        case 0: {
-            // Verify magic byte, ignore block hash
-            const struct operation_group_header *ogh = NEXT_TYPE(struct operation_group_header);
-            if (ogh->magic_byte != MAGIC_BYTE_UNSAFE_OP) PARSE_ERROR();
-        }
+STEP_HANDLER(step_implicit_source) {
+    struct implicit_contract const *const implicit_source = FIELD(struct implicit_contract);
+    if (!parse_implicit(&out->operation.source,
+                        &implicit_source->signature_type,
+                        implicit_source->pkh)) {
+        PARSE_ERROR();
+    }
+    return after_source(state, out);
+}
 
-            OP_NAMED_STEP(1)
-
-            state->tag = NEXT_BYTE;
-
-            if (!is_operation_allowed(state->tag)) PARSE_ERROR();
-
-            OP_STEP
-
-            // Parse 'source'
-            switch (state->tag) {
-                // Tags that don't have "originated" byte only support tz accounts, not KT or tz.
-                case OPERATION_TAG_PROPOSAL:
-                case OPERATION_TAG_BALLOT:
-                case OPERATION_TAG_BABYLON_DELEGATION:
-                case OPERATION_TAG_BABYLON_ORIGINATION:
-                case OPERATION_TAG_BABYLON_REVEAL:
-                case OPERATION_TAG_BABYLON_TRANSACTION: {
-                    struct implicit_contract const *const implicit_source =
-                        NEXT_TYPE(struct implicit_contract);
-                    out->operation.source.originated = 0;
-                    out->operation.source.signature_type =
-                        parse_raw_tezos_header_signature_type(&implicit_source->signature_type);
-                    memcpy(out->operation.source.hash,
-                           implicit_source->pkh,
-                           sizeof(out->operation.source.hash));
-                    break;
-                }
-
-                case OPERATION_TAG_ATHENS_DELEGATION:
-                case OPERATION_TAG_ATHENS_ORIGINATION:
-                case OPERATION_TAG_ATHENS_REVEAL:
-                case OPERATION_TAG_ATHENS_TRANSACTION: {
-                    struct contract const *const source = NEXT_TYPE(struct contract);
-                    parse_contract(&out->operation.source, source);
-                    break;
-                }
-
-                default:
-                    PARSE_ERROR();
-            }
+#ifdef HAVE_ATHENS_OPERATIONS
+STEP_HANDLER(step_contract_source) {
+    if (!parse_contract(&out->operation.source, FIELD(struct contract))) PARSE_ERROR();
+    return after_source(state, out);
+}
+#endif
 
-            OP_JMPIF(STEP_AFTER_MANAGER_FIELDS,
-                     (state->tag == OPERATION_TAG_PROPOSAL || state->tag == OPERATION_TAG_BALLOT));
+STEP_HANDLER(step_fee) {
+    out->total_fee += FIELD_Z;
+    return STEP_NEXT;
+}
 
-            OP_STEP
+STEP_HANDLER(step_storage_limit) {
+    out->total_storage_limit += FIELD_Z;
 
-            // out->operation.source IS NORMALIZED AT THIS POINT
+    if (!is_reveal_tag(state->tag)) return after_manager_fields(state, out);
+    return STEP_REVEAL_KEY_TYPE;
+}
 
-            // Parse common fields for non-governance related operations.
+// Public key up next! Ensure it matches signing key.
+// Ignore source :-) and do not parse it from hdr.
+// We don't much care about reveals, they have very little in the way of bad security
+// implications and any fees have already been accounted for
+STEP_HANDLER(step_reveal_key_type) {
+    if (parse_raw_tezos_header_signature_type(FIELD(raw_tezos_header_signature_type_t)) !=
+        contract_signature_type(&out->signing))
+        PARSE_ERROR();
+    return STEP_NEXT;
+}
 
-            out->total_fee += PARSE_Z;  // fee
-            OP_STEP
-            PARSE_Z;  // counter
-            OP_STEP
-            PARSE_Z;  // gas limit
-            OP_STEP
-            out->total_storage_limit += PARSE_Z;  // storage limit
+STEP_HANDLER(step_reveal_key) {
+    if (memcmp(out->public_key.W, FIELD(uint8_t), out->public_key.W_len) != 0) PARSE_ERROR();
 
-            OP_JMPIF(STEP_AFTER_MANAGER_FIELDS,
-                     (state->tag != OPERATION_TAG_ATHENS_REVEAL &&
-                      state->tag != OPERATION_TAG_BABYLON_REVEAL))
-            OP_STEP
+    out->has_reveal = true;
+    return STEP_TAG;
+}
 
-            // We know this is a reveal
+STEP_HANDLER(step_proposal) {
+    struct proposal_contents const *const proposal_data = FIELD(struct proposal_contents);
 
-            // Public key up next! Ensure it matches signing key.
-            // Ignore source :-) and do not parse it from hdr.
-            // We don't much care about reveals, they have very little in the way of bad security
-            // implications and any fees have already been accounted for
-            {
-                raw_tezos_header_signature_type_t const *const sig_type =
-                    NEXT_TYPE(raw_tezos_header_signature_type_t);
-                if (parse_raw_tezos_header_signature_type(sig_type) != out->signing.signature_type)
-                    PARSE_ERROR();
-            }
+    const size_t payload_size = WIRE_READ(proposal_data, num_bytes);
+    if (payload_size != PROTOCOL_HASH_SIZE)
+        PARSE_ERROR();  // We only accept exactly 1 proposal hash.
 
-            OP_STEP
+    out->operation.proposal.voting_period = WIRE_READ(proposal_data, period);
 
-            {
-                size_t klen = out->public_key.W_len;
+    memcpy(out->operation.proposal.protocol_hash,
+           proposal_data->hash,
+           sizeof(out->operation.proposal.protocol_hash));
+    return STEP_END_OF_MESSAGE;
+}
+
+STEP_HANDLER(step_ballot) {
+    struct ballot_contents const *const ballot_data = FIELD(struct ballot_contents);
+
+    out->operation.ballot.voting_period = WIRE_READ(ballot_data, period);
+    memcpy(out->operation.ballot.protocol_hash,
+           ballot_data->proposal,
+           sizeof(out->operation.ballot.protocol_hash));
+
+    const int8_t ballot_vote = ballot_data->ballot;
+    switch (ballot_vote) {
+        case 0:
+            out->operation.ballot.vote = BALLOT_VOTE_YEA;
+            break;
+        case 1:
+            out->operation.ballot.vote = BALLOT_VOTE_NAY;
+            break;
+        case 2:
+            out->operation.ballot.vote = BALLOT_VOTE_PASS;
+            break;
+        default:
+            PARSE_ERROR();
+    }
+    return STEP_END_OF_MESSAGE;
+}
 
-                CALL_SUBPARSER(parse_next_type, byte, &(state->subparser_state.nexttype), klen);
+STEP_HANDLER(step_delegate_present) {
+    if (FIELD_BYTE) return STEP_DELEGATE;
 
-                if (memcmp(out->public_key.W, &(state->subparser_state.nexttype.body.raw), klen) !=
-                    0)
-                    PARSE_ERROR();
+    // Encode "not present"
+    memset(&out->operation.destination, 0, sizeof(out->operation.destination));
 
-                out->has_reveal = true;
+    if (!add_to_batch(out)) PARSE_ERROR();
+    return STEP_TAG;  // These go back to the top to catch any reveals.
+}
 
-                JMP_TO_TOP;
-            }
+STEP_HANDLER(step_delegate) {
+    struct delegation_contents const *const dlg = FIELD(struct delegation_contents);
+    if (!parse_implicit(&out->operation.destination, &dlg->signature_type, dlg->hash)) {
+        PARSE_ERROR();
+    }
+
+    if (!add_to_batch(out)) PARSE_ERROR();
+    return STEP_TAG;  // These go back to the top to catch any reveals.
+}
+
+STEP_HANDLER(step_balance) {
+    out->operation.amount = FIELD_Z;
+    return STEP_NEXT;
+}
+
+STEP_HANDLER(step_origination_delegate_present) {
+    return FIELD_BYTE ? STEP_ORIGINATION_DELEGATE : STEP_CODE;
+}
+
+STEP_HANDLER(step_origination_delegate) {
+    struct delegation_contents const *const dlg = FIELD(struct delegation_contents);
+    if (!parse_implicit(&out->operation.delegate, &dlg->signature_type, dlg->hash)) PARSE_ERROR();
+    return STEP_NEXT;
+}
+
+// The code and the initial storage can't be displayed; they are only hashed, and the prompt shows
+// their size next to the hash.
+STEP_HANDLER(step_code) {
+    out->operation.skipped_length = FIELD_LENGTH;
+    SKIP_OPAQUE(FIELD_LENGTH);
+    return STEP_NEXT;
+}
+
+STEP_HANDLER(step_storage) {
+    uint32_t const storage_length = FIELD_LENGTH;
+    if (out->operation.skipped_length + storage_length < storage_length) PARSE_ERROR();
+    out->operation.skipped_length += storage_length;
+    SKIP_OPAQUE(storage_length);
+    return STEP_END_OF_MESSAGE;
+}
+
+STEP_HANDLER(step_amount) {
+    out->operation.amount = FIELD_Z;
+    return STEP_NEXT;
+}
 
-        case STEP_AFTER_MANAGER_FIELDS:  // Anything but a reveal
+STEP_HANDLER(step_destination) {
+    if (!parse_contract(&out->operation.destination, FIELD(struct contract))) PARSE_ERROR();
+    return STEP_NEXT;
+}
+
+STEP_HANDLER(step_has_parameters) {
+    uint8_t const has_params = FIELD_BYTE;
+
+    if (has_params == MICHELSON_PARAMS_NONE) {
+        if (!add_to_batch(out)) PARSE_ERROR();
+        return STEP_TAG;
+    }
+
+    if (has_params != MICHELSON_PARAMS_SOME) PARSE_ERROR();
+
+    // Contract calls cannot be part of a batch.
+    if (out->batch.all.operation_count != 0) PARSE_ERROR();
+    return STEP_NEXT;
+}
 
-            if (out->operation.tag != OPERATION_TAG_NONE) {
-                // We are only currently allowing one non-reveal operation
+STEP_HANDLER(step_entrypoint) {
+    const enum entrypoint_tag entrypoint = FIELD_BYTE;
+
+    // Anything that’s not “do” is not a manager.tz contract: it is signed as a plain contract
+    // call, without parsing the parameters.
+    if (entrypoint != ENTRYPOINT_DO) {
+        if (state->tag != OPERATION_TAG_BABYLON_TRANSACTION) PARSE_ERROR();
+        out->operation.is_contract_call = true;
+        memset(out->operation.entrypoint, 0, sizeof(out->operation.entrypoint));
+
+        switch (entrypoint) {
+            case ENTRYPOINT_DEFAULT:
+                STRCPY(out->operation.entrypoint, "default");
+                break;
+            case ENTRYPOINT_ROOT:
+                STRCPY(out->operation.entrypoint, "root");
+                break;
+            case ENTRYPOINT_SET_DELEGATE:
+                STRCPY(out->operation.entrypoint, "set_delegate");
+                break;
+            case ENTRYPOINT_REMOVE_DELEGATE:
+                STRCPY(out->operation.entrypoint, "remove_delegate");
+                break;
+            case ENTRYPOINT_NAMED:
+                return STEP_ENTRYPOINT_NAME_LENGTH;
+            default:
                 PARSE_ERROR();
-            }
+        }
+        return STEP_PARAMETERS;
+    }
 
-            // This is the one allowable non-reveal operation per set
+    // From this point on we are _only_ parsing manager.tz operatinos, so we show the outer
+    // destination (the KT1) as the source of the transaction.
+    out->operation.is_manager_tz_operation = true;
+    memcpy(&out->operation.implicit_account, &out->operation.source, sizeof(parsed_contract_t));
+    memcpy(&out->operation.source, &out->operation.destination, sizeof(parsed_contract_t));
 
-            out->operation.tag = (uint8_t) state->tag;
+    // manager.tz operations cannot actually transfer any amount.
+    if (out->operation.amount > 0) PARSE_ERROR();
+    return STEP_NEXT;
+}
 
-            // If the source is an implicit contract,...
-            if (out->operation.source.originated == 0) {
-                // ... it had better match our key, otherwise why are we signing it?
-                if (COMPARE(&out->operation.source, &out->signing) != 0) PARSE_ERROR();
-            }
-            // OK, it passes muster.
+STEP_HANDLER(step_manager_tz_length) {
+    uint32_t const length = FIELD_LENGTH;
+    if (length == 0) PARSE_ERROR();
+
+    micheline_init(&state->subparser_state.micheline, length);
+    state->manager_tz_candidates = (1 << NUM_MANAGER_TZ_PATTERNS) - 1;
+    state->manager_tz_position = 0;
+    return STEP_NEXT;
+}
 
-            // This should by default be blanked out
-            out->operation.delegate.signature_type = SIGNATURE_TYPE_UNSET;
-            out->operation.delegate.originated = 0;
+STEP_HANDLER(step_manager_tz_parameters) {
+    if (!manager_tz_complete(state, out)) PARSE_ERROR();
+    return STEP_END_OF_MESSAGE;
+}
+
+STEP_HANDLER(step_entrypoint_name_length) {
+    state->argument_length = FIELD_BYTE;
+    if (state->argument_length == 0 || state->argument_length > MAX_ENTRYPOINT_LENGTH) {
+        PARSE_ERROR();
+    }
+    return STEP_NEXT;
+}
+
+STEP_HANDLER(step_entrypoint_name) {
+    size_t const name_length = strlen(out->operation.entrypoint);
+
+    // Only printable characters, so that the name can be displayed.
+    if (FIELD_BYTE < 0x21 || FIELD_BYTE > 0x7e) PARSE_ERROR();
+    out->operation.entrypoint[name_length] = FIELD_BYTE;
+
+    // Stay on this step until the whole name is read.
+    if (name_length + 1 < state->argument_length) return STEP_ENTRYPOINT_NAME;
+    return STEP_PARAMETERS;
+}
+
+// The parameters can't be displayed; they are only hashed, and the prompt shows their size next to
+// the hash.
+STEP_HANDLER(step_parameters) {
+    out->operation.skipped_length = FIELD_LENGTH;
+    SKIP_OPAQUE(FIELD_LENGTH);
+    return STEP_END_OF_MESSAGE;
+}
 
-            // Deliberate epsilon-transition.
-            state->op_step = STEP_OP_TYPE_DISPATCH;
+static int16_t apply_step(struct parse_state *const state,
+                          struct parsed_operation_group *const out,
+                          is_operation_allowed_t is_operation_allowed) {
+    switch (state->op_step) {
+#define STEP_CASE(name, handler, reader, size)            \
+    case STEP_##name:                                     \
+        return handler(state, out, is_operation_allowed);
+        OPERATION_STEPS(STEP_CASE)
+#undef STEP_CASE
         default:
+            PARSE_ERROR();
+    }
+}
 
-            switch (state->tag) {
-                case OPERATION_TAG_PROPOSAL:
-                    switch (state->op_step) {
-                        case STEP_OP_TYPE_DISPATCH: {
-                            const struct proposal_contents *proposal_data =
-                                NEXT_TYPE(struct proposal_contents);
-
-                            const size_t payload_size =
-                                READ_UNALIGNED_BIG_ENDIAN(int32_t, &proposal_data->num_bytes);
-                            if (payload_size != PROTOCOL_HASH_SIZE)
-                                PARSE_ERROR();  // We only accept exactly 1 proposal hash.
-
-                            out->operation.proposal.voting_period =
-                                READ_UNALIGNED_BIG_ENDIAN(int32_t, &proposal_data->period);
-
-                            memcpy(out->operation.proposal.protocol_hash,
-                                   proposal_data->hash,
-                                   sizeof(out->operation.proposal.protocol_hash));
-                        }
-
-                            JMP_EOM;
-                    }
-                    break;
-                case OPERATION_TAG_BALLOT:
-                    switch (state->op_step) {
-                        case STEP_OP_TYPE_DISPATCH: {
-                            const struct ballot_contents *ballot_data =
-                                NEXT_TYPE(struct ballot_contents);
-
-                            out->operation.ballot.voting_period =
-                                READ_UNALIGNED_BIG_ENDIAN(int32_t, &ballot_data->period);
-                            memcpy(out->operation.ballot.protocol_hash,
-                                   ballot_data->proposal,
-                                   sizeof(out->operation.ballot.protocol_hash));
-
-                            const int8_t ballot_vote =
-                                READ_UNALIGNED_BIG_ENDIAN(int8_t, &ballot_data->ballot);
-                            switch (ballot_vote) {
-                                case 0:
-                                    out->operation.ballot.vote = BALLOT_VOTE_YEA;
-                                    break;
-                                case 1:
-                                    out->operation.ballot.vote = BALLOT_VOTE_NAY;
-                                    break;
-                                case 2:
-                                    out->operation.ballot.vote = BALLOT_VOTE_PASS;
-                                    break;
-                                default:
-                                    PARSE_ERROR();
-                            }
-                            JMP_EOM;
-                        }
-                    }
-
-                case OPERATION_TAG_ATHENS_DELEGATION:
-                case OPERATION_TAG_BABYLON_DELEGATION:
-                    switch (state->op_step) {
-                        case STEP_OP_TYPE_DISPATCH: {
-                            uint8_t delegate_present = NEXT_BYTE;
-
-                            OP_JMPIF(STEP_HAS_DELEGATE, delegate_present)
-                        }
-                            // Else branch: Encode "not present"
-                            out->operation.destination.originated = 0;
-                            out->operation.destination.signature_type = SIGNATURE_TYPE_UNSET;
-
-                            JMP_TO_TOP;  // These go back to the top to catch any reveals.
-
-                        case STEP_HAS_DELEGATE: {
-                            const struct delegation_contents *dlg =
-                                NEXT_TYPE(struct delegation_contents);
-                            parse_implicit(&out->operation.destination,
-                                           &dlg->signature_type,
-                                           dlg->hash);
-                        }
-                            JMP_TO_TOP;  // These go back to the top to catch any reveals.
-                    }
-                case OPERATION_TAG_ATHENS_ORIGINATION:
-                case OPERATION_TAG_BABYLON_ORIGINATION:
-                    PARSE_ERROR();  // We can't parse the script yet, and all babylon originations
-                                    // have a script; we have to just reject originations.
-
-                case OPERATION_TAG_ATHENS_TRANSACTION:
-                case OPERATION_TAG_BABYLON_TRANSACTION:
-                    switch (state->op_step) {
-                        case STEP_OP_TYPE_DISPATCH:
-
-                            out->operation.amount = PARSE_Z;
-
-                            OP_STEP {
-                                const struct contract *destination = NEXT_TYPE(struct contract);
-                                parse_contract(&out->operation.destination, destination);
-                            }
-
-                            OP_STEP {
-                                char has_params = NEXT_BYTE;
-
-                                if (has_params == MICHELSON_PARAMS_NONE) {
-                                    JMP_TO_TOP;
-                                }
-
-                                if (has_params != MICHELSON_PARAMS_SOME) {
-                                    PARSE_ERROR();
-                                }
-
-                                // From this point on we are _only_ parsing manager.tz operatinos,
-                                // so we show the outer destination (the KT1) as the source of the
-                                // transaction.
-                                out->operation.is_manager_tz_operation = true;
-                                memcpy(&out->operation.implicit_account,
-                                       &out->operation.source,
-                                       sizeof(parsed_contract_t));
-                                memcpy(&out->operation.source,
-                                       &out->operation.destination,
-                                       sizeof(parsed_contract_t));
-
-                                // manager.tz operations cannot actually transfer any amount.
-                                if (out->operation.amount > 0) {
-                                    PARSE_ERROR();
-                                }
-                            }
-
-                            OP_STEP {
-                                const enum entrypoint_tag entrypoint = NEXT_BYTE;
-
-                                // Don't bother parsing the name, we'll reject if it's there either
-                                // way.
-
-                                // Anything that’s not “do” is not a
-                                // manager.tz contract.
-                                if (entrypoint != ENTRYPOINT_DO) {
-                                    PARSE_ERROR();
-                                }
-                            }
-
-                            OP_STEP {
-                                state->argument_length = MICHELSON_READ_LENGTH;
-                            }
-
-                            OP_STEP
-
-                            // Error on anything but a michelson sequence.
-                            OP_STEP_REQUIRE_BYTE(MICHELSON_TYPE_SEQUENCE);
-
-                            {
-                                const uint32_t sequence_length = MICHELSON_READ_LENGTH;
-
-                                // Only allow single sequence (5 is needed
-                                // in argument length for above two
-                                // bytes). Also bail out on really big
-                                // Michelson that we don’t support.
-                                if (sequence_length + sizeof(uint8_t) + sizeof(uint32_t) !=
-                                        state->argument_length ||
-                                    state->argument_length > MAX_MICHELSON_SEQUENCE_LENGTH) {
-                                    PARSE_ERROR();
-                                }
-                            }
-
-                            OP_STEP
-
-                            // All manager.tz operations should begin
-                            // with this. Otherwise, bail out.
-                            OP_STEP_REQUIRE_SHORT(MICHELSON_DROP)
-                            OP_STEP_REQUIRE_SHORT(MICHELSON_NIL)
-                            OP_STEP_REQUIRE_SHORT(MICHELSON_OPERATION)
-
-                            {
-                                state->michelson_op = MICHELSON_READ_SHORT;
-
-                                // First real michelson op.
-                                switch (state->michelson_op) {
-                                    case MICHELSON_PUSH:
-                                        JMP(STEP_MICHELSON_FIRST_IS_PUSH);
-                                    case MICHELSON_NONE:  // withdraw delegate
-                                        JMP(STEP_MICHELSON_FIRST_IS_NONE);
-                                    default:
-                                        PARSE_ERROR();
-                                }
-                            }
-
-                        case STEP_MICHELSON_FIRST_IS_PUSH: {
-                            state->michelson_op = MICHELSON_READ_SHORT;
-
-                            // First real michelson op.
-                            switch (state->michelson_op) {
-                                case MICHELSON_KEY_HASH:
-                                    JMP(STEP_MICHELSON_SECOND_IS_KEY_HASH);
-                                case MICHELSON_ADDRESS:  // transfer contract to contract
-                                    JMP(STEP_MICHELSON_CONTRACT_TO_CONTRACT);
-                                default:
-                                    PARSE_ERROR();
-                            }
-                        }
-
-                        case STEP_MICHELSON_SECOND_IS_KEY_HASH:
-
-                            MICHELSON_READ_ADDRESS(&out->operation.destination, state->base58_pkh1);
-
-                            OP_STEP {
-                                state->michelson_op = MICHELSON_READ_SHORT;
-
-                                switch (state->michelson_op) {
-                                    case MICHELSON_SOME:  // Set delegate
-                                        JMP(STEP_MICHELSON_SET_DELEGATE_CHAIN);
-                                    case MICHELSON_IMPLICIT_ACCOUNT:  // transfer contract to
-                                                                      // implicit
-                                        JMP(STEP_MICHELSON_CONTRACT_TO_IMPLICIT_CHAIN);
-                                    default:
-                                        PARSE_ERROR();
-                                }
-                            }
-
-                        case STEP_MICHELSON_SET_DELEGATE_CHAIN:
-
-                        {
-                            uint16_t val = MICHELSON_READ_SHORT;
-                            if (val != MICHELSON_SET_DELEGATE) PARSE_ERROR();
-
-                            out->operation.tag = OPERATION_TAG_BABYLON_DELEGATION;
-                            out->operation.destination.originated = true;
-                            JMP(STEP_MICHELSON_CONTRACT_END);
-                        }
-
-                        case STEP_MICHELSON_CONTRACT_TO_IMPLICIT_CHAIN:
-                            // Matching: PUSH key_hash <adr> ; IMPLICIT_ACCOUNT ; PUSH mutez <val> ;
-                            // UNIT ; TRANSFER_TOKENS
-
-                            OP_STEP_REQUIRE_SHORT(MICHELSON_PUSH)
-                            OP_STEP_REQUIRE_SHORT(MICHELSON_MUTEZ)
-
-                            {
-                                uint8_t contractOrImplicit = NEXT_BYTE;
-                                if (contractOrImplicit != 0) PARSE_ERROR();  // what is this?
-                            }
-
-                            OP_STEP
-
-                            out->operation.amount = PARSE_Z_MICHELSON;
-
-                            OP_STEP
-
-                            OP_STEP_REQUIRE_SHORT(MICHELSON_UNIT)
-
-                            {
-                                uint16_t val = MICHELSON_READ_SHORT;
-                                if (val != MICHELSON_TRANSFER_TOKENS) PARSE_ERROR();
-                                out->operation.tag = OPERATION_TAG_BABYLON_TRANSACTION;
-
-                                JMP(STEP_MICHELSON_CONTRACT_END);
-                            }
-
-                        case STEP_MICHELSON_CONTRACT_TO_CONTRACT:
-
-                        {
-                            // Matching: PUSH address <adr> ; CONTRACT <par> ; ASSERT_SOME ; PUSH
-                            // mutez <val> ; UNIT ; TRANSFER_TOKENS
-                            MICHELSON_READ_ADDRESS(&out->operation.destination, state->base58_pkh2);
-                        }
-
-                            OP_STEP
-
-                            state->contract_code = MICHELSON_READ_SHORT;
-
-                            OP_STEP
-
-                            {
-                                const enum michelson_code type = MICHELSON_READ_SHORT;
-
-                                // Can’t display any parameters, need
-                                // to throw anything but unit out for now.
-                                // TODO: display michelson arguments
-                                if (type != MICHELSON_CONTRACT_UNIT) {
-                                    PARSE_ERROR();
-                                }
-
-                                switch (state->contract_code) {
-                                    case MICHELSON_CONTRACT_WITH_ENTRYPOINT: {
-                                        JMP(STEP_MICHELSON_CHECKING_CONTRACT_ENTRYPOINT);
-                                    }
-                                    case MICHELSON_CONTRACT: {
-                                        JMP(STEP_MICHELSON_CONTRACT_TO_CONTRACT_CHAIN_2);
-                                    }
-                                    default:
-                                        PARSE_ERROR();
-                                }
-                            }
-
-                        case STEP_MICHELSON_CHECKING_CONTRACT_ENTRYPOINT: {
-                            // No way to display
-                            // entrypoint now, so need to
-                            // bail out on anything but
-                            // default.
-                            // TODO: display entrypoints
-                            uint8_t entrypoint_byte = NEXT_BYTE;
-                            if (entrypoint_byte != ENTRYPOINT_DEFAULT) {
-                                PARSE_ERROR();
-                            }
-                        }
-                            JMP(STEP_MICHELSON_CONTRACT_TO_CONTRACT_CHAIN_2);
-
-                        case STEP_MICHELSON_CONTRACT_TO_CONTRACT_CHAIN_2:
-
-                            OP_STEP_REQUIRE_BYTE(MICHELSON_TYPE_SEQUENCE);
-
-                            OP_STEP_REQUIRE_LENGTH(0x15);
-                            OP_STEP_REQUIRE_SHORT(MICHELSON_IF_NONE);
-                            OP_STEP_REQUIRE_BYTE(MICHELSON_TYPE_SEQUENCE);
-                            OP_STEP_REQUIRE_LENGTH(9);
-                            OP_STEP_REQUIRE_BYTE(MICHELSON_TYPE_SEQUENCE);
-                            OP_STEP_REQUIRE_LENGTH(4);
-                            OP_STEP_REQUIRE_SHORT(MICHELSON_UNIT);
-                            OP_STEP_REQUIRE_SHORT(MICHELSON_FAILWITH);
-                            OP_STEP_REQUIRE_BYTE(MICHELSON_TYPE_SEQUENCE);
-                            OP_STEP_REQUIRE_LENGTH(0);
-                            OP_STEP_REQUIRE_SHORT(MICHELSON_PUSH);
-                            OP_STEP_REQUIRE_SHORT(MICHELSON_MUTEZ);
-                            OP_STEP_REQUIRE_BYTE(0);
+bool parse_operations_final(struct parse_state *const state,
+                            struct parsed_operation_group *const out) {
+    if (out->operation.tag == OPERATION_TAG_NONE && !out->has_reveal) {
+        return false;
+    }
+    if (state->skip_length != 0) return false;  // Opaque data was cut short
+    return state->op_step == STEP_END_OF_MESSAGE || state->op_step == STEP_TAG;
+}
+
+bool parse_operations_fields_final(struct parse_state const *const state) {
+    return state->op_step == STEP_END_OF_MESSAGE;
+}
 
-                            { out->operation.amount = PARSE_Z_MICHELSON; }
-
-                            OP_STEP
+// Steps over as much of the opaque data announced in `state->skip_length` as `available` allows.
+// The caller hashes these bytes like any others; they just never go through `parse_byte`.
+static inline size_t skip_opaque_bytes(struct parse_state *const state, size_t const available) {
+    size_t const skipped = CUSTOM_MIN((size_t) state->skip_length, available);
+    state->skip_length -= skipped;
+    return skipped;
+}
 
-                            OP_STEP_REQUIRE_SHORT(MICHELSON_UNIT);
-
-                            {
-                                uint16_t val = MICHELSON_READ_SHORT;
-                                if (val != MICHELSON_TRANSFER_TOKENS) PARSE_ERROR();
-                                out->operation.tag = OPERATION_TAG_BABYLON_TRANSACTION;
-                                JMP(STEP_MICHELSON_CONTRACT_END);
-                            }
-
-                        case STEP_MICHELSON_FIRST_IS_NONE:  // withdraw delegate
-
-                            OP_STEP_REQUIRE_SHORT(MICHELSON_KEY_HASH);
+enum field_status {
+    FIELD_INCOMPLETE,
+    FIELD_COMPLETE,
+    FIELD_INVALID,
+};
+
+// Adds `byte` to the field being read.
+static inline enum field_status read_field(uint8_t const byte,
+                                           struct parse_state *const state,
+                                           struct parsed_operation_group *const out) {
+    struct step_field const *const field = &step_fields[state->op_step];
+    struct nexttype_subparser_state *const nexttype = &state->subparser_state.nexttype;
+
+    switch (field->reader) {
+        case READ_BYTE:
+            nexttype->body.raw[0] = byte;
+            return FIELD_COMPLETE;
+
+        case READ_Z: {
+            struct int_subparser_state *const integer = &state->subparser_state.integer;
+            uint64_t const bits = byte & 0x7F;
+            if (integer->shift >= 64 || (bits << integer->shift) >> integer->shift != bits) {
+                return FIELD_INVALID;  // Does not fit in 64 bits
+            }
+            integer->value |= bits << integer->shift;
+            integer->shift += 7;
+            return byte & 0x80 ? FIELD_INCOMPLETE : FIELD_COMPLETE;
+        }
 
-                            {
-                                uint16_t val = MICHELSON_READ_SHORT;
-                                if (val != MICHELSON_SET_DELEGATE) PARSE_ERROR();
-
-                                out->operation.tag = OPERATION_TAG_BABYLON_DELEGATION;
-                                out->operation.destination.originated = 0;
-                                out->operation.destination.signature_type = SIGNATURE_TYPE_UNSET;
-                            }
-
-                            JMP(STEP_MICHELSON_CONTRACT_END);
-
-                        case STEP_MICHELSON_CONTRACT_END:
-
-                        {
-                            uint16_t val = MICHELSON_READ_SHORT;
-                            if (val != MICHELSON_CONS) PARSE_ERROR();
-                        }
-
-                            JMP_EOM;
-
-                        default:
-                            PARSE_ERROR();
-                    }
-                default:  // Any other tag; probably not possible here.
-                    PARSE_ERROR();
+        case READ_FIXED:
+            nexttype->body.raw[nexttype->fill_idx++] = byte;
+            return nexttype->fill_idx == field->size ? FIELD_COMPLETE : FIELD_INCOMPLETE;
+
+        case READ_LENGTH:
+            nexttype->body.raw[nexttype->fill_idx++] = byte;
+            if (nexttype->fill_idx < sizeof(uint32_t)) return FIELD_INCOMPLETE;
+            nexttype->body.i32 = READ_UNALIGNED_BIG_ENDIAN(uint32_t, &nexttype->body.raw);
+            return FIELD_COMPLETE;
+
+        case READ_PUBLIC_KEY:
+            if (nexttype->fill_idx >= sizeof(nexttype->body.key)) return FIELD_INVALID;
+            nexttype->body.raw[nexttype->fill_idx++] = byte;
+            return nexttype->fill_idx == out->public_key.W_len ? FIELD_COMPLETE : FIELD_INCOMPLETE;
+
+        default: {  // READ_MICHELINE
+            struct manager_tz_match_context context = {state, out};
+            struct micheline_decoder *const decoder = &state->subparser_state.micheline;
+            if (!micheline_feed(decoder, byte, &match_manager_tz_event, &context)) {
+                return FIELD_INVALID;
             }
+            return micheline_done(decoder) ? FIELD_COMPLETE : FIELD_INCOMPLETE;
+        }
     }
-
-    PARSE_ERROR();  // Probably not reachable, but removes a warning.
 }
 
-#define G global.apdu.u.sign
-#ifdef BAKING_APP
+// Returns false on a parse error, after which every byte is refused.
+static inline bool parse_byte(uint8_t const byte,
+                              struct parse_state *const state,
+                              struct parsed_operation_group *const out,
+                              is_operation_allowed_t is_operation_allowed) {
+    // Past the end of the message, or after an error
+    if (state->op_step < 0) {
+        state->op_step = STEP_HARD_FAIL;
+        return false;
+    }
 
-static void parse_operations_throws_parse_error(struct parsed_operation_group *const out,
-                                                void const *const data,
-                                                size_t length,
-                                                derivation_type_t derivation_type,
-                                                bip32_path_t const *const bip32_path,
-                                                is_operation_allowed_t is_operation_allowed) {
-    size_t ix = 0;
+    switch (read_field(byte, state, out)) {
+        case FIELD_INCOMPLETE:
+            return true;
+        case FIELD_COMPLETE:
+            break;
+        default:
+            PRINTF("Invalid field at step %d\n", state->op_step);
+            trace(TRACE_OPERATION_ERROR, state->op_step, __LINE__);
+            state->op_step = STEP_HARD_FAIL;
+            return false;
+    }
 
-    parse_operations_init(out, derivation_type, bip32_path, &G.parse_state);
+    int16_t const next = apply_step(state, out, is_operation_allowed);
+    if (next == STEP_HARD_FAIL) {
+        state->op_step = STEP_HARD_FAIL;
+        return false;
+    }
+    state->op_step = next == STEP_NEXT ? state->op_step + 1 : next;
+    start_field(state);
+    return true;
+}
 
+// Parses the bytes of one packet, stepping over opaque data.
+static bool parse_bytes(uint8_t const *const data,
+                        size_t const length,
+                        struct parse_state *const state,
+                        struct parsed_operation_group *const out,
+                        is_operation_allowed_t is_operation_allowed) {
+    size_t ix = 0;
     while (ix < length) {
-        uint8_t byte = ((uint8_t *) data)[ix];
-        parse_byte(byte, &G.parse_state, out, is_operation_allowed);
-        PRINTF("Byte: %x - Next op_step state: %d\n", byte, G.parse_state.op_step);
+        if (state->skip_length != 0) {
+            ix += skip_opaque_bytes(state, length - ix);
+            continue;
+        }
+        if (!parse_byte(data[ix], state, out, is_operation_allowed)) return false;
+        PRINTF("Byte: %x - Next op_step state: %d\n", data[ix], state->op_step);
         ix++;
     }
-
-    if (!parse_operations_final(&G.parse_state, out)) PARSE_ERROR();
+    return true;
 }
 
+#define G global.apdu.u.sign
+#ifdef BAKING_APP
+
 bool parse_operations(struct parsed_operation_group *const out,
                       uint8_t const *const data,
                       size_t length,
                       derivation_type_t derivation_type,
                       bip32_path_t const *const bip32_path,
                       is_operation_allowed_t is_operation_allowed) {
-    BEGIN_TRY {
-        TRY {
-            parse_operations_throws_parse_error(out,
-                                                data,
-                                                length,
-                                                derivation_type,
-                                                bip32_path,
-                                                is_operation_allowed);
-        }
-        CATCH(EXC_PARSE_ERROR) {
-            return false;
-        }
-        CATCH_OTHER(e) {
-            THROW(e);
-        }
-        FINALLY {
-        }
-    }
-    END_TRY;
-    return true;
+    parse_operations_init(out, derivation_type, bip32_path, &G.parse_state);
+    if (!parse_bytes(data, length, &G.parse_state, out, is_operation_allowed)) return false;
+    return parse_operations_final(&G.parse_state, out);
 }
 
-#else
+#endif
+
+#ifdef HAVE_WALLET
 
 bool parse_operations_packet(struct parsed_operation_group *const out,
                              uint8_t const *const data,
                              size_t length,
                              is_operation_allowed_t is_operation_allowed) {
-    BEGIN_TRY {
-        TRY {
-            size_t ix = 0;
-            while (ix < length) {
-                uint8_t byte = ((uint8_t *) data)[ix];
-                parse_byte(byte, &G.parse_state, out, is_operation_allowed);
-                PRINTF("Byte: %x - Next op_step state: %d\n", byte, G.parse_state.op_step);
-                ix++;
-            }
-        }
-        CATCH(EXC_PARSE_ERROR) {
-            return false;
-        }
-        CATCH_OTHER(e) {
-            THROW(e);
-        }
-        FINALLY {
-        }
-    }
-    END_TRY;
-    return true;
+    return parse_bytes(data, length, &G.parse_state, out, is_operation_allowed);
 }
 
 #endif
@@ -5,6 +5,7 @@
 #include <stdint.h>
 
 #include "keys.h"
+#include "micheline.h"
 #include "protocol.h"
 
 #include "cx.h"
@@ -45,7 +46,7 @@ struct delegation_contents {
 
 struct proposal_contents {
     int32_t period;
-    size_t num_bytes;
+    uint32_t num_bytes;
     uint8_t hash[PROTOCOL_HASH_SIZE];
 } __attribute__((packed));
 
@@ -59,14 +60,14 @@ typedef struct {
     uint8_t v[HASH_SIZE];
 } __attribute__((packed)) hash_t;
 
+// Reader of the field of the current parser step; which member is in use depends on the step.
+
 struct int_subparser_state {
-    uint32_t lineno;  // Has to be in _all_ members of the subparser union.
-    uint64_t value;   // Still need to fix this.
+    uint64_t value;  // Still need to fix this.
     uint8_t shift;
 };
 
 struct nexttype_subparser_state {
-    uint32_t lineno;
     union {
         raw_tezos_header_signature_type_t sigtype;
 
@@ -85,45 +86,33 @@ struct nexttype_subparser_state {
         uint32_t i32;
         uint64_t i64;
 
-        uint8_t raw[1];
         uint8_t key[64];  // FIXME: check key length for non-tz1.
-        uint8_t text_pkh[HASH_SIZE_B58];
+        uint8_t raw[64];  // As large as `key`: readers fill the members above a byte at a time
     } body;
     uint32_t fill_idx;
 };
 
-struct michelson_address_subparser_state {
-    uint32_t lineno;
-    uint8_t address_step;
-    uint8_t micheline_type;
-    uint32_t addr_length;
-    hash_t key_hash;
-    parsed_contract_t result;  // Not neccessarily optimal, but easy.
-    struct nexttype_subparser_state subsub_state;
-    raw_tezos_header_signature_type_t signature_type;
-};
-
 union subparser_state {
     struct int_subparser_state integer;
     struct nexttype_subparser_state nexttype;
-    struct michelson_address_subparser_state michelson_address;
+    struct micheline_decoder micheline;
 };
 
 struct parse_state {
-    int16_t op_step;
+    int16_t op_step;  // The step reading the current field, or < 0 once there is nothing to read
     union subparser_state subparser_state;
     enum operation_tag tag;
     uint32_t argument_length;
-    uint16_t michelson_op;
-    uint16_t contract_code;
+    uint32_t skip_length;  // Opaque bytes that are hashed but not parsed before the next step
 
-    // Places to stash textual base58-encoded PKHes.
-    char base58_pkh1[HASH_SIZE_B58];
-    char base58_pkh2[HASH_SIZE_B58];
+    // Matching manager.tz parameters against the known patterns
+    uint8_t manager_tz_candidates;  // Bit set of the patterns that still match
+    uint8_t manager_tz_position;    // Events matched so far
 };
 
-// Allows arbitrarily many "REVEAL" operations but only one operation of any other type,
-// which is the one it puts into the group.
+// Allows arbitrarily many "REVEAL" operations, and either one operation of any other type or a
+// batch of plain transactions and delegations. The last of these is put into `operation` and
+// transactions and delegations are summarized in `batch`.
 bool parse_operations(struct parsed_operation_group *const out,
                       uint8_t const *const data,
                       size_t length,
@@ -139,6 +128,13 @@ void parse_operations_init(struct parsed_operation_group *const out,
 bool parse_operations_final(struct parse_state *const state,
                             struct parsed_operation_group *const out);
 
+// True once nothing that the review screens show can change: the last operation was read up to its
+// opaque data (contract call parameters, origination script), after which nothing may follow.
+// `parse_operations_final` still fails if that data is cut short.
+bool parse_operations_fields_final(struct parse_state const *const state);
+
+// Parses the next packet of the operation group. Returns false on a parse error, after which the
+// group can't be valid any more. Neither of these throws on a parse error.
 bool parse_operations_packet(struct parsed_operation_group *const out,
                              uint8_t const *const data,
                              size_t length,
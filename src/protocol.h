@@ -7,6 +7,7 @@
 #include "os.h"
 #include "cx.h"
 #include "types.h"
+#include "wire.h"
 
 #define MAGIC_BYTE_INVALID    0x00
 #define MAGIC_BYTE_BLOCK      0x01
@@ -15,28 +16,11 @@
 #define MAGIC_BYTE_UNSAFE_OP2 0x04
 #define MAGIC_BYTE_UNSAFE_OP3 0x05
 
+// Blocks and endorsements: the messages signed under the high watermark of the baking app.
+static inline bool is_baking_magic_byte(uint8_t const magic_byte) {
+    return magic_byte == MAGIC_BYTE_BLOCK || magic_byte == MAGIC_BYTE_BAKING_OP;
+}
+
 static inline uint8_t get_magic_byte(uint8_t const *const data, size_t const length) {
     return (data == NULL || length == 0) ? MAGIC_BYTE_INVALID : *data;
 }
-
-#define READ_UNALIGNED_BIG_ENDIAN(type, in)             \
-    ({                                                  \
-        uint8_t const *bytes = (uint8_t const *) in;    \
-        uint8_t out_bytes[sizeof(type)];                \
-        type res;                                       \
-                                                        \
-        for (size_t i = 0; i < sizeof(type); i++) {     \
-            out_bytes[i] = bytes[sizeof(type) - i - 1]; \
-        }                                               \
-        memcpy(&res, out_bytes, sizeof(type));          \
-                                                        \
-        res;                                            \
-    })
-
-// Same as READ_UNALIGNED_BIG_ENDIAN but helps keep track of how many bytes
-// have been read by adding sizeof(type) to the given counter.
-#define CONSUME_UNALIGNED_BIG_ENDIAN(counter, type, addr) \
-    ({                                                    \
-        counter += sizeof(type);                          \
-        READ_UNALIGNED_BIG_ENDIAN(type, addr);            \
-    })
@@ -15,17 +15,21 @@ int handle_check_address(const check_address_parameters_t* params) {
 
     bip32_path_t bip32_path = {0};
 
-    read_bip32_path(&bip32_path, params->address_parameters, params->address_parameters_length);
+    struct wire_cursor address_parameters =
+        wire_cursor(params->address_parameters, params->address_parameters_length);
+    read_bip32_path(&bip32_path, &address_parameters);
     derivation_type_t derivation_type = DERIVATION_TYPE_ED25519;
-    cx_ecfp_public_key_t public_key = {0};
-    int error = generate_public_key(&public_key, derivation_type, &bip32_path);
+    cx_ecfp_public_key_t *const public_key = SCRATCH_BORROW(cx_ecfp_public_key_t);
+    int error = generate_public_key(public_key, derivation_type, &bip32_path);
     if (error) {
+        SCRATCH_RETURN(public_key);
         PRINTF("Error generating public_key\n");
         return 0;
     }
 
     char address[57];
-    pubkey_to_pkh_string(address, sizeof(address), derivation_type, &public_key);
+    pubkey_to_pkh_string(address, sizeof(address), derivation_type, public_key);
+    SCRATCH_RETURN(public_key);
 
     if (strcmp(address, params->address_to_check) != 0) {
         PRINTF("Addresses do not match\n");
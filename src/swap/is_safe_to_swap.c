@@ -6,16 +6,26 @@
 
 bool is_safe_to_swap() {
     struct parsed_operation_group *op = &global.apdu.u.sign.maybe_ops.v;
-    char tmp_dest[57] = {0};
-    parsed_contract_to_string(tmp_dest, sizeof(tmp_dest), &op->operation.destination);
+    parsed_contract_t destination;
+    bool const destination_valid =
+        base58_to_parsed_contract(&destination,
+                                  swap_values.destination,
+                                  strnlen(swap_values.destination,
+                                          sizeof(swap_values.destination)));
 
-    if (op->signing.originated != 0) {
+    if (op->signing.kind == CONTRACT_ORIGINATED) {
         PRINTF("Should not be originated\n");
         return false;
+    } else if (op->batch.all.operation_count > 1) {
+        PRINTF("Should be a single operation\n");
+        return false;
     } else if (op->operation.tag != OPERATION_TAG_BABYLON_TRANSACTION) {
         PRINTF("Should be of type babylon transaction\n");
         return false;
-    } else if (op->signing.signature_type != SIGNATURE_TYPE_ED25519) {
+    } else if (op->operation.is_contract_call) {
+        PRINTF("Should not be a contract call\n");
+        return false;
+    } else if (op->signing.kind != CONTRACT_IMPLICIT_ED25519) {
         PRINTF("Signature type is not ED25519\n");
         return false;
     } else if (op->total_storage_limit >= 257) {
@@ -27,7 +37,8 @@ bool is_safe_to_swap() {
     } else if (op->operation.amount != swap_values.amount) {
         PRINTF("Amounts differ\n");
         return false;
-    } else if (strncmp((const char *) &tmp_dest, swap_values.destination, sizeof(tmp_dest))) {
+    } else if (!destination_valid ||
+               memcmp(&destination, &op->operation.destination, sizeof(destination)) != 0) {
         PRINTF("Addresses differ\n");
         return false;
     }
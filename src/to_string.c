@@ -4,6 +4,8 @@
 #include "base58.h"
 #include "keys.h"
 #include "delegates.h"
+#include "globals.h"
+#include "memory.h"
 
 #include <string.h>
 
@@ -23,18 +25,11 @@ static size_t microtez_to_string(char *dest, uint64_t number);
 void parsed_contract_to_string(char *const buff,
                                size_t const buff_size,
                                parsed_contract_t const *const contract) {
-    // If hash_ptr exists, show it to us now. Otherwise, we unpack the
-    // packed hash.
-    if (contract->hash_ptr != NULL) {
-        if (buff_size < HASH_SIZE_B58) THROW(EXC_WRONG_LENGTH);
-        memcpy(buff, contract->hash_ptr, HASH_SIZE_B58);
-    } else if (contract->originated == 0 && contract->signature_type == SIGNATURE_TYPE_UNSET) {
+    if (contract->kind == CONTRACT_NONE) {
         if (buff_size < sizeof(NO_CONTRACT_STRING)) THROW(EXC_WRONG_LENGTH);
         strcpy(buff, NO_CONTRACT_STRING);
     } else {
-        signature_type_t const signature_type =
-            contract->originated != 0 ? SIGNATURE_TYPE_UNSET : contract->signature_type;
-        pkh_to_string(buff, buff_size, signature_type, contract->hash);
+        pkh_to_string(buff, buff_size, contract_signature_type(contract), contract->hash);
     }
 }
 
@@ -46,7 +41,7 @@ void lookup_parsed_contract_name(char *const buff,
     for (uint16_t i = 0; i < sizeof(named_delegates) / sizeof(named_delegate_t); i++) {
         if (memcmp(named_delegates[i].bakerAccount, buff, HASH_SIZE_B58) == 0) {
             // Found a matching baker, display it.
-            const char *name = (const char *) pic((unsigned int) named_delegates[i].bakerName);
+            const char *name = (const char *) PIC(named_delegates[i].bakerName);
             if (buff_size <= strlen(name)) THROW(EXC_WRONG_LENGTH);
             strcpy(buff, name);
             return;
@@ -65,7 +60,14 @@ void pubkey_to_pkh_string(char *const out,
     check_null(public_key);
 
     uint8_t hash[HASH_SIZE];
-    public_key_hash(hash, sizeof(hash), NULL, derivation_type, public_key);
+    cx_ecfp_public_key_t compressed;
+    cx_blake2b_t hash_state;
+    public_key_hash_with(hash,
+                         sizeof(hash),
+                         &compressed,
+                         &hash_state,
+                         derivation_type,
+                         public_key);
     pkh_to_string(out, out_size, derivation_type_to_signature_type(derivation_type), hash);
 }
 
@@ -75,7 +77,7 @@ void bip32_path_with_curve_to_pkh_string(char *const out,
     check_null(out);
     check_null(key);
 
-    cx_ecfp_public_key_t pubkey = {0};
+    cx_ecfp_public_key_t pubkey;
     generate_public_key(&pubkey, key->derivation_type, &key->bip32_path);
     pubkey_to_pkh_string(out, out_size, key->derivation_type, &pubkey);
 }
@@ -106,6 +108,21 @@ void buffer_to_base58(char *const out, size_t const out_size, buffer_t const *co
     bin_to_base58(out, out_size, src->bytes, src->length);
 }
 
+// Base58 prefixes of contract hashes, by `enum contract_kind`.
+static const uint8_t contract_prefixes[][3] = {
+    [CONTRACT_IMPLICIT_SECP256K1] = {6, 161, 161},  // tz2
+    [CONTRACT_IMPLICIT_SECP256R1] = {6, 161, 164},  // tz3
+    [CONTRACT_IMPLICIT_ED25519] = {6, 161, 159},    // tz1
+    [CONTRACT_ORIGINATED] = {2, 90, 121},           // KT1
+};
+
+// What the base58 form of a contract encodes.
+struct base58_contract {
+    uint8_t prefix[3];
+    uint8_t hash[HASH_SIZE];
+    uint8_t checksum[TEZOS_HASH_CHECKSUM_SIZE];
+} __attribute__((packed));
+
 void pkh_to_string(char *const buff,
                    size_t const buff_size,
                    signature_type_t const signature_type,
@@ -114,40 +131,13 @@ void pkh_to_string(char *const buff,
     check_null(hash);
     if (buff_size < PKH_STRING_SIZE) THROW(EXC_WRONG_LENGTH);
 
-    // Data to encode
-    struct __attribute__((packed)) {
-        uint8_t prefix[3];
-        uint8_t hash[HASH_SIZE];
-        uint8_t checksum[TEZOS_HASH_CHECKSUM_SIZE];
-    } data;
-
-    // prefix
-    switch (signature_type) {
-        case SIGNATURE_TYPE_UNSET:
-            data.prefix[0] = 2;
-            data.prefix[1] = 90;
-            data.prefix[2] = 121;
-            break;
-        case SIGNATURE_TYPE_ED25519:
-            data.prefix[0] = 6;
-            data.prefix[1] = 161;
-            data.prefix[2] = 159;
-            break;
-        case SIGNATURE_TYPE_SECP256K1:
-            data.prefix[0] = 6;
-            data.prefix[1] = 161;
-            data.prefix[2] = 161;
-            break;
-        case SIGNATURE_TYPE_SECP256R1:
-            data.prefix[0] = 6;
-            data.prefix[1] = 161;
-            data.prefix[2] = 164;
-            break;
-        default:
-            THROW(EXC_WRONG_PARAM);  // Should not reach
-    }
+    // An implicit contract if there is a signature type, an originated one otherwise.
+    uint8_t const kind =
+        signature_type == SIGNATURE_TYPE_UNSET ? CONTRACT_ORIGINATED : signature_type;
+    if (kind >= NUM_ELEMENTS(contract_prefixes)) THROW(EXC_WRONG_PARAM);  // Should not reach
 
-    // hash
+    struct base58_contract data;
+    memcpy(data.prefix, contract_prefixes[kind], sizeof(data.prefix));
     memcpy(data.hash, hash, sizeof(data.hash));
     compute_hash_checksum(data.checksum, &data, sizeof(data) - sizeof(data.checksum));
 
@@ -155,6 +145,32 @@ void pkh_to_string(char *const buff,
     if (!b58enc(buff, &out_size, &data, sizeof(data))) THROW(EXC_WRONG_LENGTH);
 }
 
+bool base58_to_parsed_contract(parsed_contract_t *const out,
+                               char const *const in,
+                               size_t const in_size) {
+    check_null(out);
+    check_null(in);
+    // Every prefix starts with a non-zero byte, so a string of this length can't have leading
+    // '1's, and each contract has a single encoding.
+    if (in_size != HASH_SIZE_B58) return false;
+
+    struct base58_contract data;
+    if (!b58dec(&data, sizeof(data), in, in_size)) return false;
+
+    uint8_t checksum[TEZOS_HASH_CHECKSUM_SIZE];
+    compute_hash_checksum(checksum, &data, sizeof(data) - sizeof(data.checksum));
+    if (memcmp(checksum, data.checksum, sizeof(checksum)) != 0) return false;
+
+    for (uint8_t kind = CONTRACT_NONE + 1; kind < NUM_ELEMENTS(contract_prefixes); kind++) {
+        if (memcmp(data.prefix, contract_prefixes[kind], sizeof(data.prefix)) == 0) {
+            out->kind = kind;
+            memcpy(out->hash, data.hash, sizeof(out->hash));
+            return true;
+        }
+    }
+    return false;
+}
+
 void protocol_hash_to_string(char *buff,
                              const size_t buff_size,
                              const uint8_t hash[PROTOCOL_HASH_SIZE]) {
@@ -264,6 +280,37 @@ void microtez_to_string_indirect(char *const dest,
     microtez_to_string(dest, *number);
 }
 
+#define OPS_SUFFIX " ops)"
+
+void batch_total_to_string(char *const dest,
+                           size_t const buff_size,
+                           struct batch_total const *const total) {
+    check_null(dest);
+    check_null(total);
+    // amount + " (" + count + " ops)" + terminating null
+    if (buff_size < 2 * MAX_INT_DIGITS + sizeof(" (") + sizeof(OPS_SUFFIX))
+        THROW(EXC_WRONG_LENGTH);
+    size_t off = microtez_to_string(dest, total->amount);
+    if (total->operation_count > 1) {
+        dest[off++] = ' ';
+        dest[off++] = '(';
+        off += number_to_string(dest + off, total->operation_count);
+        strcpy(dest + off, OPS_SUFFIX);
+    }
+}
+
+#define BYTES_SUFFIX " bytes"
+
+void byte_count_to_string_indirect32(char *const dest,
+                                     size_t const buff_size,
+                                     uint32_t const *const count) {
+    check_null(dest);
+    check_null(count);
+    if (buff_size < MAX_INT_DIGITS + sizeof(BYTES_SUFFIX)) THROW(EXC_WRONG_LENGTH);
+    size_t const off = number_to_string(dest, *count);
+    strcpy(dest + off, BYTES_SUFFIX);
+}
+
 // Like `microtez_to_strind_indirect` but returns an error code
 int microtez_to_string_indirect_no_throw(char *const dest,
                                          size_t const buff_size,
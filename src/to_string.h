@@ -22,6 +22,11 @@ void protocol_hash_to_string(char *const buff,
 void parsed_contract_to_string(char *const buff,
                                size_t const buff_size,
                                parsed_contract_t const *const contract);
+// Reads the base58 form of a contract (tz1..., KT1...). Returns false if it isn't one, or its
+// checksum does not match.
+bool base58_to_parsed_contract(parsed_contract_t *const out,
+                               char const *const in,
+                               size_t const in_size);
 void lookup_parsed_contract_name(char *const buff,
                                  size_t const buff_size,
                                  parsed_contract_t const *const contract);
@@ -44,6 +49,16 @@ void microtez_to_string_indirect(char *const dest,
                                  size_t const buff_size,
                                  uint64_t const *const number);
 
+// Formats an amount followed by the number of operations it adds up, e.g. "12.5 (3 ops)".
+void batch_total_to_string(char *const dest,
+                           size_t const buff_size,
+                           struct batch_total const *const total);
+
+// Formats a size such as "1234 bytes".
+void byte_count_to_string_indirect32(char *const dest,
+                                     size_t const buff_size,
+                                     uint32_t const *const count);
+
 int microtez_to_string_indirect_no_throw(char *const dest,
                                          size_t const buff_size,
                                          uint64_t const *const number);
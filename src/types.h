@@ -1,12 +1,42 @@
 #pragma once
 
 #include "exception.h"
+#include "michelson.h"
 #include "os.h"
 #include "os_io_seproxyhal.h"
 
 #include <stdbool.h>
 #include <string.h>
 
+// The wallet app (no BAKING_APP) prompts for everything it signs. The baking app (BAKING_APP)
+// signs blocks and endorsements without a prompt, guarded by its high watermark. The combined app
+// (BAKING_APP and COMBINED_APP) is the baking app with the wallet's signing added alongside.
+#if !defined(BAKING_APP) || defined(COMBINED_APP)
+#define HAVE_WALLET
+#endif
+
+// Build profiles (PROFILE in the Makefile). PROFILE_MODERN leaves out the operation encodings of
+// protocols before Babylon; without it, everything is compiled in.
+#ifndef PROFILE_MODERN
+#define HAVE_ATHENS_OPERATIONS
+#endif
+
+// Curves keys can be derived and used with (CURVES in the Makefile). A build that picks none, like
+// the host build, gets them all.
+#if !defined(HAVE_CURVE_ED25519) && !defined(HAVE_CURVE_SECP256K1) && \
+    !defined(HAVE_CURVE_SECP256R1) && !defined(HAVE_CURVE_BIP32_ED25519)
+#define HAVE_CURVE_ED25519
+#define HAVE_CURVE_SECP256K1
+#define HAVE_CURVE_SECP256R1
+#define HAVE_CURVE_BIP32_ED25519
+#endif
+#if defined(HAVE_CURVE_ED25519) || defined(HAVE_CURVE_BIP32_ED25519)
+#define HAVE_EDDSA
+#endif
+#if defined(HAVE_CURVE_SECP256K1) || defined(HAVE_CURVE_SECP256R1)
+#define HAVE_ECDSA
+#endif
+
 // Type-safe versions of true/false
 #undef true
 #define true ((bool) 1)
@@ -121,22 +151,57 @@ typedef struct {
     bool had_endorsement;
 } high_watermark_t;
 
+typedef struct {
+    high_watermark_t main;
+    high_watermark_t test;
+} high_watermarks_t;
+
+// Records of the last signatures of the baking app in NVRAM, a power of two and at least two (see
+// write_high_water_mark). INS_QUERY_AUDIT_LOG returns all but the oldest.
+#ifndef AUDIT_RECORDS
+#define AUDIT_RECORDS 32
+#endif
+
+_Static_assert((AUDIT_RECORDS & (AUDIT_RECORDS - 1)) == 0 && AUDIT_RECORDS > 1,
+               "AUDIT_RECORDS must be a power of two, at least 2");
+
+#define AUDIT_HASH_SIZE   8
+#define AUDIT_ENDORSEMENT 0x80000000u  // Set in the level of the records of endorsements
+
+// Written whole by a single nvm_write, the only one of a signature (see write_high_water_mark).
+struct audit_record {
+    high_watermarks_t hwm;          // The watermarks once the signature was allowed
+    chain_id_t chain_id;
+    level_t level;                  // With AUDIT_ENDORSEMENT for an endorsement
+    uint8_t hash[AUDIT_HASH_SIZE];  // The first bytes of the hash that was signed
+    // 1 for the first record since NVRAM was blank. Written last: a write cut short leaves a number
+    // below that of the record before it (see recover_high_water_marks).
+    uint32_t number;
+};
+
+// What UPDATE_NVRAM stages and writes.
 typedef struct {
     chain_id_t main_chain_id;
-    struct {
-        high_watermark_t main;
-        high_watermark_t test;
-    } hwm;
+    high_watermarks_t hwm;  // Raised by the audit records numbered above `audit_base`
     bip32_path_with_curve_t baking_key;
+    // The same as `hwm`, which is always written before it: if power fails in the middle of a
+    // write, at most one of the two is torn (see recover_high_water_marks).
+    high_watermarks_t hwm_copy;
+    uint32_t audit_base;  // The number of the newest audit record when `hwm` was written
 } nvram_data;
 
+struct nvram {
+    nvram_data data;
+    struct audit_record audit[AUDIT_RECORDS];  // Record `number` is at (number - 1) % AUDIT_RECORDS
+};
+
 #define SIGN_HASH_SIZE 32  // TODO: Rename or use a different constant.
 
 #define PKH_STRING_SIZE 40  // includes null byte // TODO: use sizeof for this.
 #define PROTOCOL_HASH_BASE58_STRING_SIZE \
     sizeof("ProtoBetaBetaBetaBetaBetaBetaBetaBetaBet11111a5ug96")
 
-#define MAX_SCREEN_STACK_SIZE 7  // Maximum number of screens in a flow.
+#define MAX_SCREEN_STACK_SIZE 16  // Maximum number of screens in a flow.
 #define PROMPT_WIDTH          16
 #define VALUE_WIDTH           PROTOCOL_HASH_BASE58_STRING_SIZE
 
@@ -169,16 +234,34 @@ typedef struct {
     level_t level;
 } parsed_baking_data_t;
 
-typedef struct parsed_contract {
-    uint8_t originated;  // a lightweight bool
-    signature_type_t
-        signature_type;  // 0 in originated case
-                         // An implicit contract with signature_type of 0 means not present
+// What the hash of a `parsed_contract` identifies. Implicit contracts share the values of
+// `signature_type_t`.
+enum contract_kind {
+    CONTRACT_NONE = SIGNATURE_TYPE_UNSET,  // No contract, e.g. no delegate; the hash is zero
+    CONTRACT_IMPLICIT_SECP256K1 = SIGNATURE_TYPE_SECP256K1,
+    CONTRACT_IMPLICIT_SECP256R1 = SIGNATURE_TYPE_SECP256R1,
+    CONTRACT_IMPLICIT_ED25519 = SIGNATURE_TYPE_ED25519,
+    CONTRACT_ORIGINATED,
+};
 
+// A contract in 21 bytes, without padding, so that it is copied and compared (see COMPARE) as a
+// whole.
+typedef struct parsed_contract {
+    uint8_t kind;  // enum contract_kind
     uint8_t hash[HASH_SIZE];
+} __attribute__((packed)) parsed_contract_t;
+
+_Static_assert(sizeof(parsed_contract_t) == 1 + HASH_SIZE, "parsed_contract_t is not packed");
+
+static inline bool contract_is_implicit(parsed_contract_t const *const contract) {
+    return contract->kind != CONTRACT_NONE && contract->kind != CONTRACT_ORIGINATED;
+}
 
-    char *hash_ptr;
-} parsed_contract_t;
+// The signature type of an implicit contract, SIGNATURE_TYPE_UNSET for any other.
+static inline signature_type_t contract_signature_type(parsed_contract_t const *const contract) {
+    return contract_is_implicit(contract) ? (signature_type_t) contract->kind
+                                          : SIGNATURE_TYPE_UNSET;
+}
 
 struct parsed_proposal {
     uint32_t voting_period;
@@ -212,6 +295,20 @@ enum operation_tag {
     OPERATION_TAG_BABYLON_DELEGATION = 110,
 };
 
+static inline bool is_reveal_tag(enum operation_tag const tag) {
+#ifdef HAVE_ATHENS_OPERATIONS
+    if (tag == OPERATION_TAG_ATHENS_REVEAL) return true;
+#endif
+    return tag == OPERATION_TAG_BABYLON_REVEAL;
+}
+
+static inline bool is_delegation_tag(enum operation_tag const tag) {
+#ifdef HAVE_ATHENS_OPERATIONS
+    if (tag == OPERATION_TAG_ATHENS_DELEGATION) return true;
+#endif
+    return tag == OPERATION_TAG_BABYLON_DELEGATION;
+}
+
 // TODO: Make this an enum.
 // Flags for parsed_operation.flag
 #define ORIGINATION_FLAG_SPENDABLE   1
@@ -225,32 +322,56 @@ struct parsed_operation {
         struct parsed_contract delegate;  // For originations only
         struct parsed_proposal proposal;  // For proposals only
         struct parsed_ballot ballot;      // For ballots only
+        char entrypoint[MAX_ENTRYPOINT_LENGTH + 1];  // For contract calls only
     };
 
     bool is_manager_tz_operation;
     struct parsed_contract implicit_account;  // For manager.tz transactions
 
+    bool is_contract_call;    // Transaction to an entrypoint other than manager.tz's "do"
+    uint32_t skipped_length;  // Bytes of parameters or script that were hashed but not parsed
+
     uint64_t amount;  // 0 where inappropriate
     uint32_t flags;   // Interpretation depends on operation type
 };
 
+// Maximum number of distinct destinations listed individually when reviewing a batch. Operations
+// to further destinations are only counted.
+#define MAX_BATCH_DESTINATIONS 4
+
+struct batch_total {
+    uint64_t amount;
+    uint16_t operation_count;
+};
+
+struct batch_destination {
+    struct batch_total total;  // Operations to `destination`
+    struct parsed_contract destination;
+    bool is_delegation;
+};
+
+// Summary of the transactions and delegations of an operation group, built as they are parsed.
+struct parsed_batch {
+    struct batch_total all;     // Reveals are not counted
+    uint8_t destination_count;  // Used entries in `destinations`
+    struct batch_destination destinations[MAX_BATCH_DESTINATIONS];
+    struct batch_total others;  // Operations whose destination did not fit in `destinations`
+    uint64_t largest_amount;    // Largest amount of a single operation
+    uint16_t delegation_count;
+};
+
 struct parsed_operation_group {
     cx_ecfp_public_key_t public_key;  // compressed
     uint64_t total_fee;
     uint64_t total_storage_limit;
     bool has_reveal;
     struct parsed_contract signing;
-    struct parsed_operation operation;
+    struct parsed_operation operation;  // The last non-reveal operation
+    struct parsed_batch batch;
 };
 
 // Maximum number of APDU instructions
-#define INS_MAX 0x0F
-
-#define APDU_INS(x)                                                        \
-    ({                                                                     \
-        _Static_assert(x <= INS_MAX, "APDU instruction is out of bounds"); \
-        x;                                                                 \
-    })
+#define INS_MAX 0x1F
 
 #define STRCPY(buff, x)                                                         \
     ({                                                                          \
@@ -18,6 +18,16 @@ __attribute__((noreturn)) void ux_confirm_screen(ui_callback_t ok_c, ui_callback
 
 void ux_idle_screen(ui_callback_t ok_c, ui_callback_t cxl_c);
 
+/* Shows the screens pushed so far while the data they describe is still being received. The user
+ * can browse them and reject, but Accept does nothing until `ux_review_ready()`. Returns, so that
+ * more APDUs can be handled meanwhile. */
+void ux_review_screen(ui_callback_t cxl_c);
+/* Enables Accept on the review started by `ux_review_screen()`, where the user is, and waits for
+ * the answer like `ux_confirm_screen()`. */
+__attribute__((noreturn)) void ux_review_ready(ui_callback_t ok_c, ui_callback_t cxl_c);
+/* Goes back to the idle screen if a review started by `ux_review_screen()` is not ready yet. */
+void ux_review_abandon(void);
+
 /* Initializes the formatter stack. Should be called once before calling `push_ui_callback()`. */
 void init_screen_stack();
 /* User MUST call `init_screen_stack()` before calling this function for the first time. */
@@ -36,6 +36,10 @@ void init_screen_stack() {
     global.dynamic_display.current_state = STATIC_SCREEN;
 }
 
+void ux_review_abandon(void) {
+    if (global.dynamic_display.receiving) ui_initial_screen();
+}
+
 void require_pin(void) {
     bolos_ux_params_t params;
     memset(&params, 0, sizeof(params));
@@ -2,6 +2,7 @@
 
 #include "ui.h"
 
+#include "apdu_status.h"
 #include "baking_auth.h"
 #include "exception.h"
 #include "globals.h"
@@ -55,6 +56,7 @@ unsigned char io_event(__attribute__((unused)) unsigned char channel) {
             break;
 
         case SEPROXYHAL_TAG_TICKER_EVENT:
+            global.status.ticks++;
 #ifdef BAKING_APP
             // Disable ticker event handling to prevent screen saver from starting.
 #else
@@ -73,6 +75,14 @@ unsigned char io_event(__attribute__((unused)) unsigned char channel) {
     return 1;
 }
 
+// The SDK sets the ticker up to fire every 100 ms, but only delivers it while the app waits for
+// events: time spent computing is only counted once the app next waits.
+#define TICKER_PERIOD_MS 100
+
+uint32_t status_clock(void) {
+    return global.status.ticks * TICKER_PERIOD_MS;
+}
+
 UX_STEP_INIT(ux_init_upper_border, NULL, NULL, { display_next_state(true); });
 UX_STEP_NOCB(ux_variable_display,
              bnnn_paging,
@@ -108,6 +118,10 @@ UX_FLOW(ux_idle_flow,
         FLOW_LOOP);
 
 static void prompt_response(bool const accepted) {
+    // Accept stays on screen until the whole message has been received.
+    if (accepted && global.dynamic_display.receiving) return;
+
+    status_prompt_answered(accepted);
     ui_initial_screen();
     if (accepted) {
         global.dynamic_display.ok_callback();
@@ -244,7 +258,7 @@ void ui_initial_screen(void) {
 #ifdef BAKING_APP
     calculate_baking_idle_screens_data();
 #else
-    push_ui_callback("Tezos Wallet", copy_string, VERSION);
+    calculate_wallet_idle_screens_data();
 #endif
 
     ux_idle_screen(NULL, NULL);
@@ -257,14 +271,35 @@ void ux_prepare_display(ui_callback_t ok_c, ui_callback_t cxl_c) {
 
     if (ok_c) global.dynamic_display.ok_callback = ok_c;
     if (cxl_c) global.dynamic_display.cxl_callback = cxl_c;
+    global.dynamic_display.receiving = false;
 }
 
 void ux_confirm_screen(ui_callback_t ok_c, ui_callback_t cxl_c) {
     ux_prepare_display(ok_c, cxl_c);
+    status_prompt_shown();
     ux_flow_init(0, ux_confirm_flow, NULL);
     THROW(ASYNC_EXCEPTION);
 }
 
+void ux_review_screen(ui_callback_t cxl_c) {
+    ux_prepare_display(NULL, cxl_c);
+    status_prompt_shown();
+    global.dynamic_display.receiving = true;
+    ux_flow_init(0, ux_confirm_flow, NULL);
+}
+
+void ux_review_ready(ui_callback_t ok_c, ui_callback_t cxl_c) {
+    G_display.ok_callback = ok_c;
+    G_display.cxl_callback = cxl_c;
+    G_display.receiving = false;
+    if (G_display.current_state == DYNAMIC_SCREEN) {
+        // The screen shown may depend on what was just received.
+        set_screen_data();
+        ux_flow_relayout();
+    }
+    THROW(ASYNC_EXCEPTION);
+}
+
 void ux_idle_screen(ui_callback_t ok_c, ui_callback_t cxl_c) {
     ux_prepare_display(ok_c, cxl_c);
     ux_flow_init(0, ux_idle_flow, NULL);
@@ -0,0 +1,100 @@
+// Reading the packed, big-endian wire structs of the APDU protocol in place.
+//
+// WIRE_READ reads a field of such a struct through its declared type, with one load and one byte
+// swap. A `wire_cursor` hands out the structs themselves, without copying them, from a bounded
+// buffer (usually the payload of the current APDU, see `apdu_payload`), and THROWs if a handler
+// reads past its end. Only APDU handlers use cursors; the operation parser must not throw.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "exception.h"
+
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define WIRE_BSWAP(bits, value) __builtin_bswap##bits(value)
+#else
+#define WIRE_BSWAP(bits, value) (value)
+#endif
+
+// `in` need not be aligned: memcpy of a fixed size compiles to a single load where that is legal.
+
+static inline uint16_t wire_read_be16(void const *const in) {
+    uint16_t value;
+    memcpy(&value, in, sizeof(value));
+    return WIRE_BSWAP(16, value);
+}
+
+static inline uint32_t wire_read_be32(void const *const in) {
+    uint32_t value;
+    memcpy(&value, in, sizeof(value));
+    return WIRE_BSWAP(32, value);
+}
+
+static inline uint64_t wire_read_be64(void const *const in) {
+    uint64_t value;
+    memcpy(&value, in, sizeof(value));
+    return WIRE_BSWAP(64, value);
+}
+
+static inline void wire_write_be16(uint8_t *const out, uint16_t const value) {
+    uint16_t const swapped = WIRE_BSWAP(16, value);
+    memcpy(out, &swapped, sizeof(swapped));
+}
+
+static inline void wire_write_be32(uint8_t *const out, uint32_t const value) {
+    uint32_t const swapped = WIRE_BSWAP(32, value);
+    memcpy(out, &swapped, sizeof(swapped));
+}
+
+// Reads a big-endian `type` of 1, 2, 4 or 8 bytes from `in`. The size is known at compile time,
+// so this is a single call to one of the readers above.
+#define READ_UNALIGNED_BIG_ENDIAN(type, in)                                                  \
+    ({                                                                                       \
+        _Static_assert(sizeof(type) == 1 || sizeof(type) == 2 || sizeof(type) == 4 ||        \
+                           sizeof(type) == 8,                                                \
+                       "No big-endian reader for this size");                                \
+        void const *const wire_in_ = (in);                                                   \
+        (type)(sizeof(type) == 1   ? *(uint8_t const *) wire_in_                             \
+               : sizeof(type) == 2 ? wire_read_be16(wire_in_)                                \
+               : sizeof(type) == 4 ? wire_read_be32(wire_in_)                                \
+                                   : wire_read_be64(wire_in_));                              \
+    })
+
+// Reads `field` of the wire struct `wire` points to, as the type it is declared with.
+#define WIRE_READ(wire, field) READ_UNALIGNED_BIG_ENDIAN(__typeof__((wire)->field), &(wire)->field)
+
+struct wire_cursor {
+    uint8_t const *data;
+    size_t size;
+    size_t offset;  // Bytes handed out so far
+};
+
+static inline struct wire_cursor wire_cursor(uint8_t const *const data, size_t const size) {
+    return (struct wire_cursor){.data = data, .size = size, .offset = 0};
+}
+
+static inline size_t wire_remaining(struct wire_cursor const *const cursor) {
+    return cursor->size - cursor->offset;
+}
+
+// Returns the next `size` bytes and moves past them; THROWs if fewer are left.
+static inline void const *wire_take(struct wire_cursor *const cursor, size_t const size) {
+    if (size > wire_remaining(cursor)) THROW(EXC_WRONG_LENGTH_FOR_INS);
+    void const *const out = cursor->data + cursor->offset;
+    cursor->offset += size;
+    return out;
+}
+
+// THROWs if anything is left.
+static inline void wire_expect_end(struct wire_cursor const *const cursor) {
+    if (wire_remaining(cursor) != 0) THROW(EXC_WRONG_LENGTH);
+}
+
+// The next wire struct of `type`, in place.
+#define WIRE_TAKE(cursor, type) ((type const *) wire_take(cursor, sizeof(type)))
+
+// The next big-endian `type`, by value.
+#define WIRE_CONSUME(cursor, type) READ_UNALIGNED_BIG_ENDIAN(type, wire_take(cursor, sizeof(type)))
@@ -0,0 +1,37 @@
+#!/usr/bin/env bash
+set -Eeuo pipefail
+
+DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+cd "$DIR"
+
+# NOTE: THIS TEST MUST BE RUN IN THE WALLET APP
+# Groups of several transactions and delegations are reviewed as a batch.
+
+# The transaction of transaction.sh (1 tz, fee 0.001283) followed by a transfer of 2 tz to the same
+# destination.
+TWO_TRANSFERS="0317777d8de5596705f1cb35b0247b9605a7c93a7ed5c0caa454d4f4ff39eb411d6c00cf49f66b9ea137e11818f2a78b4b6fc9895b4e50830ae58003c35000c0843d0000eac6c762212c4110f221ec8fcb05ce83db958457006c00cf49f66b9ea137e11818f2a78b4b6fc9895b4e50830ae68003c3500080897a0000eac6c762212c4110f221ec8fcb05ce83db95845700"
+TWO_TRANSFERS_LENGTH="91"
+
+# The same transaction followed by a delegation to its destination.
+TRANSFER_AND_DELEGATION="0317777d8de5596705f1cb35b0247b9605a7c93a7ed5c0caa454d4f4ff39eb411d6c00cf49f66b9ea137e11818f2a78b4b6fc9895b4e50830ae58003c35000c0843d0000eac6c762212c4110f221ec8fcb05ce83db958457006e00cf49f66b9ea137e11818f2a78b4b6fc9895b4e50830ae78003c35000ff00eac6c762212c4110f221ec8fcb05ce83db958457"
+TRANSFER_AND_DELEGATION_LENGTH="8d"
+
+{
+  echo; echo "Two transfers to the same destination (ACCEPT THIS)"
+  echo "MUST BE: Confirm Batch 3 (2 ops), Fee 0.002566, Amount 3 (2 ops), one Destination"
+
+  {
+    echo 8004000311048000002c800006c18000000080000000
+    echo 80048100${TWO_TRANSFERS_LENGTH}${TWO_TRANSFERS}
+  } | ../apdu.sh
+}
+
+{
+  echo; echo "A transfer and a delegation (ACCEPT THIS)"
+  echo "MUST BE: Confirm Batch 1 (2 ops), Amount 1, Destination, then Delegate and Delegate Name"
+
+  {
+    echo 8004000311048000002c800006c18000000080000000
+    echo 80048100${TRANSFER_AND_DELEGATION_LENGTH}${TRANSFER_AND_DELEGATION}
+  } | ../apdu.sh
+}
@@ -0,0 +1,59 @@
+#!/usr/bin/env bash
+set -Eeuo pipefail
+
+DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+cd "$DIR"
+
+# NOTE: THIS TEST MUST BE RUN IN THE WALLET APP
+# Short read-only requests sent in the middle of a signing session must not disturb it.
+
+# tezos-client transfer 1 from <my-ledger> to <other tz1 account> --burn-cap 0.257
+# Split in two packets at an arbitrary point.
+PART_1="0317777d8de5596705f1cb35b0247b9605a7c93a7ed5c0caa454d4f4ff39eb411d6c00cf49f66b9ea137e1"
+PART_1_LENGTH="2b"
+PART_2="1818f2a78b4b6fc9895b4e50830ae58003c35000c0843d0000eac6c762212c4110f221ec8fcb05ce83db95845700"
+PART_2_LENGTH="2e"
+
+VERSION_MSG="8000000000"
+GIT_MSG="8009000000"
+# INS_GET_PUBLIC_KEY for a different path than the one being signed with
+PUBKEY_MSG="8002000011048000002c800006c18000000180000000"
+
+{
+  echo; echo "Version, commit and public key requests between packets (ACCEPT THIS)"
+  echo "MUST BE: Confirm Transaction, signed by 44'/1729'/0'/0'"
+
+  {
+    echo 8004000311048000002c800006c18000000080000000
+    echo $VERSION_MSG
+    echo 80040100${PART_1_LENGTH}${PART_1}
+    echo $PUBKEY_MSG
+    echo $GIT_MSG
+    echo 80048100${PART_2_LENGTH}${PART_2}
+  } | ../apdu.sh
+}
+
+{
+  echo; echo "A failing read-only request between packets does not end the session (ACCEPT THIS)"
+  echo "MUST BE: Confirm Transaction"
+
+  {
+    echo 8004000311048000002c800006c18000000080000000
+    echo 80040100${PART_1_LENGTH}${PART_1}
+    # Invalid derivation type
+    echo 8002000911048000002c800006c18000000080000000
+    echo 80048100${PART_2_LENGTH}${PART_2}
+  } | ../apdu.sh || true
+}
+
+{
+  echo; echo "A prompting request between packets ends the session"
+  echo "MUST BE: Provide Public Key (ACCEPT THIS), then the last packet fails with 917e"
+
+  {
+    echo 8004000311048000002c800006c18000000080000000
+    echo 80040100${PART_1_LENGTH}${PART_1}
+    echo 8003000011048000002c800006c18000000080000000
+    echo 80048100${PART_2_LENGTH}${PART_2}
+  } | ../apdu.sh || true
+}
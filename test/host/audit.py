@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+"""Bakes with the baking host build and reads back what it signed with tools/audit-log.py.
+
+Usage: audit.py <tezos-host-baking>
+"""
+
+import hashlib
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+from hostapp import (INS_AUTHORIZE_BAKING, INS_SIGN, P1_FIRST, P1_LAST_MARKER, P1_NEXT, PATH,
+                     apdu, expect, run, sign_apdus)
+
+INS_QUERY_AUDIT_LOG = 0x14
+AUDIT_RECORDS = 32
+KEPT = AUDIT_RECORDS - 1  # The slot after the newest record may be torn
+
+TOOL = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "tools",
+                    "audit-log.py")
+OK = b"\x90\x00"
+
+
+def block(chain, level):
+    return b"\x01" + chain.to_bytes(4, "big") + level.to_bytes(4, "big") + b"\x01" + bytes(32)
+
+
+def endorsement(chain, level):
+    return b"\x02" + chain.to_bytes(4, "big") + bytes(32) + b"\x00" + level.to_bytes(4, "big")
+
+
+def record(number, chain, level, message):
+    return {"record": number, "chain": "0x%08x" % chain, "level": level,
+            "kind": "endorsement" if message[0] == 2 else "block",
+            "hash": hashlib.blake2b(message, digest_size=32).digest()[:8].hex()}
+
+
+def audit_log(binary, env, since=None):
+    command = [TOOL, "--host", binary] + ([] if since is None else ["--since", str(since)])
+    output = subprocess.run(command, env=dict(os.environ, **env), capture_output=True, text=True,
+                            check=True).stdout
+    return [json.loads(line) for line in output.splitlines()]
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    binary = sys.argv[1]
+
+    with tempfile.TemporaryDirectory() as directory:
+        env = {"TEZOS_HOST_NVRAM": os.path.join(directory, "nvram")}
+        expect(audit_log(binary, env) == [], "records before anything was signed")
+
+        # Blocks and endorsements of two chains, with a stale block in between that is refused.
+        messages, expected = [], []
+        for level in range(1, 25):
+            chain = 0x7A06A770 if level % 5 else 0x3E0A5C6F
+            for message in (block(chain, level), endorsement(chain, level)):
+                messages.append(message)
+                expected.append(record(len(expected), chain, level, message))
+            if level == 12:
+                messages.append(block(chain, 3))
+        commands = [apdu(INS_AUTHORIZE_BAKING, 0, PATH)]
+        for message in messages:
+            commands += sign_apdus(INS_SIGN, message)
+        responses = run(binary, commands, env).responses
+        refused = [r for r in responses[2::2] if r[-2:] != OK]
+        expect(len(refused) == 1, "refused %d signatures, expected the stale block" % len(refused))
+
+        log = audit_log(binary, env)
+        lost = len(expected) - KEPT
+        expect(log[0] == {"lost": [0, lost - 1]}, "first line %r" % log[0])
+        expect(log[1:] == expected[lost:], "records %r, expected %r" % (log[1:], expected[lost:]))
+        print("ok: the last %d of %d signatures, %d lost" % (KEPT, len(expected), lost))
+
+        log = audit_log(binary, env, len(expected) - 3)
+        expect(log == expected[-3:], "records since %d: %r" % (len(expected) - 3, log))
+        expect(audit_log(binary, env, len(expected) + 5) == [], "records after the last one")
+        print("ok: paging from a record")
+
+        # Queried in the middle of a signature, which still goes through and is recorded.
+        message = block(0x7A06A770, 100)
+        commands = [apdu(INS_AUTHORIZE_BAKING, 0, PATH), apdu(INS_SIGN, P1_FIRST, PATH),
+                    apdu(INS_QUERY_AUDIT_LOG, 0, len(expected).to_bytes(4, "big")),
+                    apdu(INS_SIGN, P1_NEXT | P1_LAST_MARKER, message)]
+        responses = run(binary, commands, env).responses
+        expect(responses[2][:8] == len(expected).to_bytes(4, "big") * 2 and
+               responses[2][-2:] == OK, "query during a signature: %s" % responses[2].hex())
+        expect(responses[3][-2:] == OK, "signature after a query: %s" % responses[3].hex())
+        log = audit_log(binary, env, len(expected))
+        expect(log == [record(len(expected), 0x7A06A770, 100, message)], "last record %r" % log)
+        print("ok: queried during a signature")
+
+        responses = run(binary, [apdu(INS_QUERY_AUDIT_LOG, 0, bytes(3)),
+                                 apdu(INS_QUERY_AUDIT_LOG, 1, bytes(4))], env).responses
+        expect([r[-2:] for r in responses] == [b"\x91\x7e", b"\x6b\x00"],
+               "malformed queries: %r" % [r.hex() for r in responses])
+        print("ok: malformed queries refused")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+"""Signs operation groups batching several transactions and delegations with the host build and
+checks the review screens.
+
+Usage: batch.py <path to tezos-host-wallet>
+"""
+
+import sys
+
+from hostapp import INS_SIGN, dlg, expect, implicit, operation_group, public_key, run, sign_apdus, tx
+
+
+def screens_of(binary, operations):
+    """Returns the review screens shown when signing `operations`, as {title: [values]}."""
+    return review(binary, operation_group(public_key(binary), operations))
+
+
+def review(binary, message, **kwargs):
+    result = run(binary, sign_apdus(INS_SIGN, message, **kwargs))
+    expect(result.responses[-1][-2:] == b"\x90\x00", "signing was refused")
+    screens = {}
+    for line in result.screens.splitlines():
+        if line.startswith("[Review"):
+            screens = {}  # Only the last review counts; one started early may be shown again
+        elif line.startswith("  "):
+            title, _, value = line.strip().partition(": ")
+            screens.setdefault(title, []).append(value)
+    return screens
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    binary = sys.argv[1]
+
+    single = screens_of(binary, [tx(1000000, implicit(1))])
+    expect(single.get("Confirm") == ["Transaction"], "a single transaction is not a batch")
+
+    screens = screens_of(binary, [tx(1000000, implicit(1)),
+                                  tx(2500000, implicit(2)),
+                                  tx(500000, implicit(1)),
+                                  dlg(implicit(3))])
+    expect(screens.get("Confirm Batch") == ["4 (4 ops)"], "totals: %r" % screens)
+    expect(screens.get("Fee") == ["0.004"], "fees are summed")
+    expect(screens.get("Amount") == ["1.5 (2 ops)", "2.5"], "per-destination sums")
+    expect(len(screens.get("Destination", [])) == 2, "one screen per destination")
+    expect(len(screens.get("Delegate", [])) == 1, "delegations are listed")
+    print("ok: transactions and a delegation")
+
+    payouts = [tx(1000000 + n, implicit(n)) for n in range(1, 5)]
+    screens = screens_of(binary, payouts + [tx(1, implicit(1))])
+    expect(screens.get("Confirm Batch") == ["4.000011 (5 ops)"], "totals: %r" % screens)
+    expect(len(screens.get("Destination", [])) == 4, "every destination is listed")
+    screens = screens_of(binary, payouts + [tx(1, implicit(5))])
+    expect("Unrecognized" in screens and "Confirm Batch" not in screens,
+           "a fifth destination is only shown as a hash: %r" % screens)
+    screens = screens_of(binary, [tx(1000000 + n, implicit(n)) for n in range(1, 51)])
+    expect("Unrecognized" in screens, "50 payouts: %r" % screens)
+    print("ok: batches to more destinations than are listed are only shown as a hash")
+
+    screens = screens_of(binary, [tx(1, implicit(1)), tx(0, implicit(2), parameters=True)])
+    expect("Unrecognized" in screens, "contract calls cannot be batched")
+    print("ok: contract call in a batch")
+
+    screens = screens_of(binary, [tx(2 ** 64 - 1, implicit(1))])
+    expect(screens.get("Amount") == ["18446744073709.551615"], "largest amount: %r" % screens)
+    screens = screens_of(binary, [tx(2 ** 64 + 1, implicit(1))])
+    expect("Unrecognized" in screens, "an amount above 2^64 must not wrap: %r" % screens)
+    print("ok: amounts that do not fit in 64 bits are only shown as a hash")
+
+
+if __name__ == "__main__":
+    main()
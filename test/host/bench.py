@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""Counts the instructions the app executes for fixed APDU transcripts, per APDU and per function,
+and fails when a hot path takes more than its threshold in bench-thresholds.
+
+Usage: bench.py <build directory> [--update]
+
+Runs the bench builds of the host build (static, without inlining, so that every function shows)
+under tools/icount.c and writes, for each transcript, <build>/bench/<transcript>.folded: the call
+stacks of the measured APDUs in the format flame graph tools read (flamegraph.pl, speedscope).
+Only the app counts, with the C library functions it calls: the host shims standing in for the
+transport, the OS and the SDK's crypto are left out, as on the device they do not run in the app.
+Counts are of x86-64 instructions, so they only compare with counts from the same compiler and
+C library; --update writes the thresholds again from this tree, with some headroom.
+"""
+
+import os
+import re
+import subprocess
+import sys
+
+from hostapp import INS_AUTHORIZE_BAKING, INS_GET_PUBLIC_KEY, INS_SIGN, PATH, apdu, dlg, expect, \
+    implicit, operation_group, public_key, sign_apdus, tx
+
+INS_HMAC = 0x0E
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SRC = os.path.abspath(os.path.join(HERE, "..", "..", "src"))
+THRESHOLDS = os.path.join(HERE, "bench-thresholds")
+HEADROOM = 1.05  # Thresholds are the count of the tree that wrote them, this much more
+SLACK = 100      # and this many instructions more
+
+# Where the app starts on the stack; what is below is the host starting it.
+ROOT = "app_main"
+# The paths whose counts are held to a threshold.
+HOT = re.compile(r"^(handle_apdu(_\w+)?|parse_byte|perform_signature|write_high_water_mark)$")
+# Copies GCC makes of a function for some of its callers are counted as the function.
+CLONE = re.compile(r"\.(constprop|isra|part|cold)\.\d+")
+
+
+def block(level):
+    return b"\x01" + bytes(4) + level.to_bytes(4, "big") + b"\x01" + bytes(32)
+
+
+def endorsement(level):
+    return b"\x02" + bytes(4) + bytes(32) + b"\x00" + level.to_bytes(4, "big")
+
+
+def transcripts(build):
+    """Yields (name, binary, APDUs to set up, APDUs to measure)."""
+    wallet = os.path.join(build, "tezos-host-wallet-bench")
+    baking = os.path.join(build, "tezos-host-baking-bench")
+    key = public_key(wallet)
+    authorize = [apdu(INS_AUTHORIZE_BAKING, 0, PATH)]
+
+    yield "pubkey", wallet, [], [apdu(INS_GET_PUBLIC_KEY, 0, PATH)]
+    yield "transfer", wallet, [], list(sign_apdus(INS_SIGN, operation_group(
+        key, [tx(1000000, implicit(1))])))
+    yield "delegation", wallet, [], list(sign_apdus(INS_SIGN, operation_group(
+        key, [dlg(implicit(3))])))
+    yield "block", baking, authorize, list(sign_apdus(INS_SIGN, block(10)))
+    yield "endorsement", baking, authorize, list(sign_apdus(INS_SIGN, endorsement(10)))
+    yield "hmac", baking, [], [apdu(INS_HMAC, 0, PATH + bytes(32))]
+
+
+def origins(binary):
+    """Returns {function: "app" or "host"} for the functions of `binary` that have a source file:
+    those of src/ and those of the host shims. The others are the C library's."""
+    nm = subprocess.run(["nm", "-l", "--defined-only", binary], capture_output=True, text=True,
+                        check=True).stdout
+    functions = {}
+    for line in nm.splitlines():
+        fields = line.split()
+        if len(fields) == 4:
+            source = os.path.dirname(os.path.abspath(fields[3].rpartition(":")[0]))
+            functions[fields[2]] = "app" if source == SRC else "host"
+    return functions
+
+
+def is_app(frames, functions):
+    """Whether the innermost of `frames` runs as part of the app on the device: if it is the app's,
+    or the C library's on behalf of the app. Instructions of the host shims standing in for the
+    transport, the OS and the SDK's crypto are not the app's."""
+    for frame in reversed(frames):
+        if frame in functions:
+            return functions[frame] == "app"
+    return False
+
+
+def profile(build, binary, apdus):
+    """Returns {(APDU number, stack): instructions} for the app's part of `apdus`."""
+    output = os.path.join(build, "bench", "icount.out")
+    commands = "".join(command.hex() + "\n" for command in apdus)
+    result = subprocess.run([os.path.join(build, "icount"), "-s", "read_apdu", "-o", output,
+                             binary], input=commands, capture_output=True, text=True)
+    expect(result.returncode == 0, "%s failed: %s" % (binary, result.stderr))
+    responses = result.stdout.split()
+    expect(len(responses) == len(apdus) and all(r.endswith("9000") for r in responses),
+           "%s refused the transcript: %r" % (binary, responses))
+
+    functions = origins(binary)
+    stacks = {}
+    with open(output) as f:
+        for line in f:
+            part, stack, count = line.split()
+            frames = stack.split(";")
+            if ROOT not in frames or not is_app(frames, functions):
+                continue
+            frames = [CLONE.sub("", frame) for frame in frames[frames.index(ROOT):]]
+            key = (int(part), ";".join(frames))
+            stacks[key] = stacks.get(key, 0) + int(count)
+    return stacks
+
+
+def inclusive(stacks):
+    """Returns the instructions of each function and everything it calls."""
+    totals = {}
+    for stack, count in stacks.items():
+        for function in set(stack.split(";")):
+            totals[function] = totals.get(function, 0) + count
+    return totals
+
+
+def read_thresholds():
+    thresholds = {}
+    with open(THRESHOLDS) as f:
+        for line in f:
+            if line.strip() and not line.startswith("#"):
+                name, function, limit = line.split()
+                thresholds[name, function] = int(limit)
+    return thresholds
+
+
+def main():
+    if len(sys.argv) not in (2, 3) or sys.argv[2:] not in ([], ["--update"]):
+        sys.exit(__doc__)
+    build = sys.argv[1]
+    update = sys.argv[2:] == ["--update"]
+    os.makedirs(os.path.join(build, "bench"), exist_ok=True)
+    thresholds = {} if update else read_thresholds()
+
+    measured = {}
+    failures = []
+    for name, binary, setup, commands in transcripts(build):
+        profiled = profile(build, binary, setup + commands)
+        first = len(setup) + 1  # Part 0 is the app starting, then one part per APDU
+        stacks = {key: count for key, count in profiled.items() if key[0] >= first}
+
+        per_apdu = [sum(c for (part, _), c in stacks.items() if part == first + i)
+                    for i in range(len(commands))]
+        print("%s: %d instructions (%s per APDU)" %
+              (name, sum(per_apdu), ", ".join(map(str, per_apdu))))
+
+        folded = {}
+        for (_, stack), count in stacks.items():
+            folded[stack] = folded.get(stack, 0) + count
+        with open(os.path.join(build, "bench", name + ".folded"), "w") as f:
+            for stack, count in sorted(folded.items()):
+                f.write("%s %d\n" % (stack, count))
+
+        for function, count in sorted(inclusive(folded).items(), key=lambda item: -item[1]):
+            if not HOT.match(function):
+                continue
+            measured[name, function] = count
+            limit = thresholds.get((name, function))
+            verdict = "" if limit is None else " (threshold %d)" % limit
+            if limit is not None and count > limit:
+                verdict += " REGRESSED"
+                failures.append("%s: %s" % (name, function))
+            print("  %-30s %9d%s" % (function, count, verdict))
+
+    if update:
+        with open(THRESHOLDS, "w") as f:
+            f.write("# Most instructions each hot path may take in each transcript of bench.py:\n"
+                    "# the count of the tree that wrote this, plus %d%% and %d.\n"
+                    "# Written by bench.py --update.\n"
+                    % (round((HEADROOM - 1) * 100), SLACK))
+            for (name, function), count in measured.items():
+                f.write("%s %s %d\n" % (name, function, int(count * HEADROOM) + SLACK))
+        print("wrote %s" % THRESHOLDS)
+    expect(not failures, "over the threshold: %s" % ", ".join(failures))
+
+
+if __name__ == "__main__":
+    main()
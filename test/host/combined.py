@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+"""Bakes and pays out from the same key with the combined host build, and checks that wallet
+signing cannot get around the high watermark.
+
+Usage: combined.py <path to tezos-host-combined> <path to tezos-host-baking>
+"""
+
+import sys
+
+from hostapp import (INS_AUTHORIZE_BAKING, INS_SIGN, INS_SIGN_UNSAFE, PATH, apdu, expect, implicit,
+                     operation_group, public_key, run, sign_apdus, tx)
+
+OK = b"\x90\x00"
+EXC_WRONG_VALUES = b"\x6a\x80"
+EXC_SECURITY = b"\x69\x82"
+EXC_PARSE_ERROR = b"\x94\x05"
+
+OTHER_PATH = bytes.fromhex("048000002c800006c18000000180000000")  # 44'/1729'/1'/0'
+
+
+def block(level):
+    return b"\x01" + bytes(4) + level.to_bytes(4, "big") + b"\x01" + bytes(32)
+
+
+def sign_unsafe(path, digest):
+    return [apdu(INS_SIGN_UNSAFE, 0, path), apdu(INS_SIGN_UNSAFE, 0x81, digest)]
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    combined, baking = sys.argv[1:]
+    payout = operation_group(public_key(combined), [tx(1000000, implicit(1))])
+
+    steps = [
+        ("authorize baking", [apdu(INS_AUTHORIZE_BAKING, 0, PATH)], OK),
+        ("bake", sign_apdus(INS_SIGN, block(10)), OK),
+        ("pay out", sign_apdus(INS_SIGN, payout), OK),
+        ("bake at the same level", sign_apdus(INS_SIGN, block(10)), EXC_WRONG_VALUES),
+        ("bake at the next level", sign_apdus(INS_SIGN, block(11)), OK),
+        ("sign a hash with the baking key", sign_unsafe(PATH, bytes(32)), EXC_SECURITY),
+        ("sign a hash with another key", sign_unsafe(OTHER_PATH, bytes(32)), OK),
+    ]
+    steps = [(name, list(step), status) for name, step, status in steps]
+    result = run(combined, [command for _, step, _ in steps for command in step])
+
+    last = -1
+    for name, step, status in steps:
+        last += len(step)  # Only the last packet of a step is signed or refused
+        response = result.responses[last]
+        expect(response[-2:] == status, "%s: %s" % (name, response.hex()))
+    expect(result.screens.count("[Review Request]") == 3,
+           "authorizing, paying out and signing a hash are reviewed, baking is not")
+    print("ok: baking and payouts interleaved")
+
+    result = run(baking, [apdu(INS_AUTHORIZE_BAKING, 0, PATH)] + list(sign_apdus(INS_SIGN, payout)))
+    expect(result.responses[-1] == EXC_PARSE_ERROR, "the baking app alone does not sign payouts")
+    print("ok: the baking app is unchanged")
+
+
+if __name__ == "__main__":
+    main()
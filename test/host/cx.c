@@ -0,0 +1,462 @@
+// Host implementation of the SDK crypto API declared in `sdk/cx.h`.
+
+#include "cx.h"
+#include "os.h"
+
+#include <string.h>
+
+// BLAKE2b (RFC 7693) ----------------------------------------------------------
+
+static const uint64_t blake2b_iv[8] = {
+    0x6a09e667f3bcc908ULL,
+    0xbb67ae8584caa73bULL,
+    0x3c6ef372fe94f82bULL,
+    0xa54ff53a5f1d36f1ULL,
+    0x510e527fade682d1ULL,
+    0x9b05688c2b3e6c1fULL,
+    0x1f83d9abfb41bd6bULL,
+    0x5be0cd19137e2179ULL,
+};
+
+static const uint8_t blake2b_sigma[12][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+    {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
+    {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+    {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
+    {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+    {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11},
+    {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+    {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5},
+    {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+};
+
+static inline uint64_t rotr64(uint64_t const x, unsigned const n) {
+    return (x >> n) | (x << (64 - n));
+}
+
+static inline uint64_t load64_le(uint8_t const *const p) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < 8; i++) v |= (uint64_t) p[i] << (8 * i);
+    return v;
+}
+
+#define B2B_G(a, b, c, d, x, y)         \
+    do {                                \
+        v[a] = v[a] + v[b] + (x);       \
+        v[d] = rotr64(v[d] ^ v[a], 32); \
+        v[c] = v[c] + v[d];             \
+        v[b] = rotr64(v[b] ^ v[c], 24); \
+        v[a] = v[a] + v[b] + (y);       \
+        v[d] = rotr64(v[d] ^ v[a], 16); \
+        v[c] = v[c] + v[d];             \
+        v[b] = rotr64(v[b] ^ v[c], 63); \
+    } while (0)
+
+static void blake2b_compress(cx_blake2b_t *const S, uint8_t const *const block, bool const last) {
+    uint64_t m[16];
+    uint64_t v[16];
+    for (size_t i = 0; i < 16; i++) m[i] = load64_le(block + 8 * i);
+    for (size_t i = 0; i < 8; i++) {
+        v[i] = S->h[i];
+        v[i + 8] = blake2b_iv[i];
+    }
+    v[12] ^= S->t[0];
+    v[13] ^= S->t[1];
+    if (last) v[14] = ~v[14];
+
+    for (size_t r = 0; r < 12; r++) {
+        uint8_t const *const s = blake2b_sigma[r];
+        B2B_G(0, 4, 8, 12, m[s[0]], m[s[1]]);
+        B2B_G(1, 5, 9, 13, m[s[2]], m[s[3]]);
+        B2B_G(2, 6, 10, 14, m[s[4]], m[s[5]]);
+        B2B_G(3, 7, 11, 15, m[s[6]], m[s[7]]);
+        B2B_G(0, 5, 10, 15, m[s[8]], m[s[9]]);
+        B2B_G(1, 6, 11, 12, m[s[10]], m[s[11]]);
+        B2B_G(2, 7, 8, 13, m[s[12]], m[s[13]]);
+        B2B_G(3, 4, 9, 14, m[s[14]], m[s[15]]);
+    }
+    for (size_t i = 0; i < 8; i++) S->h[i] ^= v[i] ^ v[i + 8];
+}
+
+static void blake2b_increment(cx_blake2b_t *const S, size_t const inc) {
+    S->t[0] += inc;
+    if (S->t[0] < inc) S->t[1]++;
+}
+
+int cx_blake2b_init(cx_blake2b_t *const hash, unsigned int const size_in_bits) {
+    size_t const output_size = size_in_bits / 8;
+    if (output_size == 0 || output_size > 64) THROW(INVALID_PARAMETER);
+    memset(hash, 0, sizeof(*hash));
+    hash->header.algo = CX_BLAKE2B;
+    hash->output_size = output_size;
+    memcpy(hash->h, blake2b_iv, sizeof(hash->h));
+    hash->h[0] ^= 0x01010000 ^ output_size;
+    return CX_BLAKE2B;
+}
+
+static void blake2b_update(cx_blake2b_t *const S, uint8_t const *in, size_t len) {
+    while (len > 0) {
+        // The final block must be kept back until the hash is finished.
+        if (S->buf_len == BLAKE2B_BLOCKBYTES) {
+            blake2b_increment(S, BLAKE2B_BLOCKBYTES);
+            blake2b_compress(S, S->buf, false);
+            S->buf_len = 0;
+        }
+        size_t const take = BLAKE2B_BLOCKBYTES - S->buf_len < len
+                                ? BLAKE2B_BLOCKBYTES - S->buf_len
+                                : len;
+        memcpy(S->buf + S->buf_len, in, take);
+        S->buf_len += take;
+        in += take;
+        len -= take;
+    }
+}
+
+static void blake2b_final(cx_blake2b_t *const S, uint8_t *const out) {
+    blake2b_increment(S, S->buf_len);
+    memset(S->buf + S->buf_len, 0, BLAKE2B_BLOCKBYTES - S->buf_len);
+    blake2b_compress(S, S->buf, true);
+    for (size_t i = 0; i < S->output_size; i++) out[i] = (uint8_t)(S->h[i / 8] >> (8 * (i % 8)));
+}
+
+static void blake2b(uint8_t *const out,
+                    size_t const out_size,
+                    uint8_t const *const in,
+                    size_t const in_size) {
+    cx_blake2b_t S;
+    cx_blake2b_init(&S, out_size * 8);
+    blake2b_update(&S, in, in_size);
+    blake2b_final(&S, out);
+}
+
+int cx_hash(cx_hash_t *const hash,
+            int const mode,
+            const unsigned char *const in,
+            unsigned int const len,
+            unsigned char *const out,
+            unsigned int const out_len) {
+    if (hash->algo != CX_BLAKE2B) THROW(INVALID_PARAMETER);
+    cx_blake2b_t *const S = (cx_blake2b_t *) hash;
+    blake2b_update(S, in, len);
+    if (!(mode & CX_LAST)) return 0;
+    if (out_len < S->output_size) THROW(INVALID_PARAMETER);
+    blake2b_final(S, out);
+    return (int) S->output_size;
+}
+
+// SHA-256 and SHA-512 (FIPS 180-4) --------------------------------------------
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t rotr32(uint32_t const x, unsigned const n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+static void sha256_block(uint32_t *const h, uint8_t const *const block) {
+    uint32_t w[64];
+    for (size_t i = 0; i < 16; i++) {
+        w[i] = (uint32_t) block[4 * i] << 24 | (uint32_t) block[4 * i + 1] << 16 |
+               (uint32_t) block[4 * i + 2] << 8 | block[4 * i + 3];
+    }
+    for (size_t i = 16; i < 64; i++) {
+        uint32_t const s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t const s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7];
+    for (size_t i = 0; i < 64; i++) {
+        uint32_t const t1 = k + (rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25)) +
+                            ((e & f) ^ (~e & g)) + sha256_k[i] + w[i];
+        uint32_t const t2 =
+            (rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        k = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+    h[5] += f;
+    h[6] += g;
+    h[7] += k;
+}
+
+static void sha256(uint8_t *const out, uint8_t const *const in, size_t const len) {
+    uint32_t h[8] = {0x6a09e667,
+                     0xbb67ae85,
+                     0x3c6ef372,
+                     0xa54ff53a,
+                     0x510e527f,
+                     0x9b05688c,
+                     0x1f83d9ab,
+                     0x5be0cd19};
+    size_t i = 0;
+    for (; len - i >= 64; i += 64) sha256_block(h, in + i);
+
+    uint8_t tail[128] = {0};
+    size_t const rest = len - i;
+    memcpy(tail, in + i, rest);
+    tail[rest] = 0x80;
+    size_t const tail_len = rest < 56 ? 64 : 128;
+    uint64_t const bits = (uint64_t) len * 8;
+    for (size_t j = 0; j < 8; j++) tail[tail_len - 1 - j] = (uint8_t)(bits >> (8 * j));
+    for (size_t j = 0; j < tail_len; j += 64) sha256_block(h, tail + j);
+
+    for (size_t j = 0; j < 32; j++) out[j] = (uint8_t)(h[j / 4] >> (24 - 8 * (j % 4)));
+}
+
+static const uint64_t sha512_k[80] = {
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+    0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+    0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+    0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+    0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+    0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+    0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+    0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+    0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+    0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+    0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+    0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+    0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+    0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL,
+};
+
+static void sha512_block(uint64_t *const h, uint8_t const *const block) {
+    uint64_t w[80];
+    for (size_t i = 0; i < 16; i++) {
+        w[i] = 0;
+        for (size_t j = 0; j < 8; j++) w[i] = w[i] << 8 | block[8 * i + j];
+    }
+    for (size_t i = 16; i < 80; i++) {
+        uint64_t const s0 = rotr64(w[i - 15], 1) ^ rotr64(w[i - 15], 8) ^ (w[i - 15] >> 7);
+        uint64_t const s1 = rotr64(w[i - 2], 19) ^ rotr64(w[i - 2], 61) ^ (w[i - 2] >> 6);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint64_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7];
+    for (size_t i = 0; i < 80; i++) {
+        uint64_t const t1 = k + (rotr64(e, 14) ^ rotr64(e, 18) ^ rotr64(e, 41)) +
+                            ((e & f) ^ (~e & g)) + sha512_k[i] + w[i];
+        uint64_t const t2 =
+            (rotr64(a, 28) ^ rotr64(a, 34) ^ rotr64(a, 39)) + ((a & b) ^ (a & c) ^ (b & c));
+        k = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+    h[5] += f;
+    h[6] += g;
+    h[7] += k;
+}
+
+static void sha512(uint8_t *const out, uint8_t const *const in, size_t const len) {
+    uint64_t h[8] = {0x6a09e667f3bcc908ULL,
+                     0xbb67ae8584caa73bULL,
+                     0x3c6ef372fe94f82bULL,
+                     0xa54ff53a5f1d36f1ULL,
+                     0x510e527fade682d1ULL,
+                     0x9b05688c2b3e6c1fULL,
+                     0x1f83d9abfb41bd6bULL,
+                     0x5be0cd19137e2179ULL};
+    size_t i = 0;
+    for (; len - i >= 128; i += 128) sha512_block(h, in + i);
+
+    uint8_t tail[256] = {0};
+    size_t const rest = len - i;
+    memcpy(tail, in + i, rest);
+    tail[rest] = 0x80;
+    size_t const tail_len = rest < 112 ? 128 : 256;
+    uint64_t const bits = (uint64_t) len * 8;
+    for (size_t j = 0; j < 8; j++) tail[tail_len - 1 - j] = (uint8_t)(bits >> (8 * j));
+    for (size_t j = 0; j < tail_len; j += 128) sha512_block(h, tail + j);
+
+    for (size_t j = 0; j < 64; j++) out[j] = (uint8_t)(h[j / 8] >> (56 - 8 * (j % 8)));
+}
+
+int cx_hash_sha256(const unsigned char *const in,
+                   unsigned int const len,
+                   unsigned char *const out,
+                   unsigned int const out_len) {
+    if (out_len < CX_SHA256_SIZE) THROW(INVALID_PARAMETER);
+    uint8_t digest[CX_SHA256_SIZE];
+    sha256(digest, in, len);  // `in` and `out` may overlap
+    memcpy(out, digest, sizeof(digest));
+    return CX_SHA256_SIZE;
+}
+
+int cx_hash_sha512(const unsigned char *const in,
+                   unsigned int const len,
+                   unsigned char *const out,
+                   unsigned int const out_len) {
+    if (out_len < CX_SHA512_SIZE) THROW(INVALID_PARAMETER);
+    uint8_t digest[CX_SHA512_SIZE];
+    sha512(digest, in, len);
+    memcpy(out, digest, sizeof(digest));
+    return CX_SHA512_SIZE;
+}
+
+#define SHA256_BLOCK_SIZE 64
+
+int cx_hmac_sha256(const unsigned char *const key,
+                   unsigned int const key_len,
+                   const unsigned char *const in,
+                   unsigned int const len,
+                   unsigned char *const mac,
+                   unsigned int const mac_len) {
+    if (mac_len < CX_SHA256_SIZE || key_len > SHA256_BLOCK_SIZE) THROW(INVALID_PARAMETER);
+    static uint8_t buffer[SHA256_BLOCK_SIZE + 1024];
+    if (len > sizeof(buffer) - SHA256_BLOCK_SIZE) THROW(INVALID_PARAMETER);
+
+    uint8_t inner[CX_SHA256_SIZE];
+    for (size_t i = 0; i < SHA256_BLOCK_SIZE; i++) buffer[i] = (i < key_len ? key[i] : 0) ^ 0x36;
+    memcpy(buffer + SHA256_BLOCK_SIZE, in, len);
+    sha256(inner, buffer, SHA256_BLOCK_SIZE + len);
+
+    for (size_t i = 0; i < SHA256_BLOCK_SIZE; i++) buffer[i] = (i < key_len ? key[i] : 0) ^ 0x5c;
+    memcpy(buffer + SHA256_BLOCK_SIZE, inner, sizeof(inner));
+    sha256(mac, buffer, SHA256_BLOCK_SIZE + sizeof(inner));
+    return CX_SHA256_SIZE;
+}
+
+// Placeholder keys and signatures ---------------------------------------------
+
+void os_perso_derive_node_bip32(cx_curve_t const curve,
+                                const unsigned int *const path,
+                                unsigned int const path_length,
+                                unsigned char *const private_key,
+                                unsigned char *const chain) {
+    uint8_t material[1 + 10 * sizeof(uint32_t)] = {(uint8_t) curve};
+    if (path_length > 10) THROW(INVALID_PARAMETER);
+    for (size_t i = 0; i < path_length; i++) {
+        for (size_t j = 0; j < 4; j++) material[1 + 4 * i + j] = (uint8_t)(path[i] >> (24 - 8 * j));
+    }
+    blake2b(private_key, 32, material, 1 + 4 * path_length);
+    if (chain != NULL) memset(chain, 0, 32);
+}
+
+void os_perso_derive_node_bip32_seed_key(unsigned int const mode,
+                                         cx_curve_t const curve,
+                                         const unsigned int *const path,
+                                         unsigned int const path_length,
+                                         unsigned char *const private_key,
+                                         unsigned char *const chain,
+                                         unsigned char *const seed_key,
+                                         unsigned int const seed_key_length) {
+    (void) mode;
+    (void) seed_key;
+    (void) seed_key_length;
+    os_perso_derive_node_bip32(curve, path, path_length, private_key, chain);
+}
+
+int cx_ecfp_init_private_key(cx_curve_t const curve,
+                             const unsigned char *const raw_key,
+                             unsigned int const key_len,
+                             cx_ecfp_private_key_t *const pvkey) {
+    if (key_len != sizeof(pvkey->d)) THROW(INVALID_PARAMETER);
+    pvkey->curve = curve;
+    pvkey->d_len = key_len;
+    memcpy(pvkey->d, raw_key, key_len);
+    return (int) key_len;
+}
+
+// The "public key" is an uncompressed-point-shaped hash of the private key.
+int cx_ecfp_generate_pair(cx_curve_t const curve,
+                          cx_ecfp_public_key_t *const pubkey,
+                          cx_ecfp_private_key_t *const privkey,
+                          int const keepprivate) {
+    (void) keepprivate;
+    pubkey->curve = curve;
+    pubkey->W_len = 65;
+    pubkey->W[0] = 0x04;
+    blake2b(pubkey->W + 1, 64, privkey->d, privkey->d_len);
+    return 0;
+}
+
+void cx_edward_compress_point(cx_curve_t const curve, unsigned char *const P, unsigned int const P_len) {
+    (void) curve;
+    if (P_len < 33) THROW(INVALID_PARAMETER);
+    P[0] = 0x02;
+}
+
+// A "signature" is BLAKE2b-512 over the public key's first half and the message, so a host test
+// can recompute it from the public key it was given.
+static unsigned int placeholder_signature(cx_ecfp_private_key_t const *const pvkey,
+                                          uint8_t const *const msg,
+                                          size_t const msg_len,
+                                          uint8_t *const sig,
+                                          size_t const sig_len) {
+    static uint8_t buffer[32 + 1024];
+    if (sig_len < 64 || msg_len > sizeof(buffer) - 32) THROW(INVALID_PARAMETER);
+    uint8_t point[64];
+    blake2b(point, sizeof(point), pvkey->d, pvkey->d_len);
+    memcpy(buffer, point, 32);
+    memcpy(buffer + 32, msg, msg_len);
+    blake2b(sig, 64, buffer, 32 + msg_len);
+    return 64;
+}
+
+int cx_eddsa_sign(const cx_ecfp_private_key_t *const pvkey,
+                  int const mode,
+                  int const hashID,
+                  const unsigned char *const hash,
+                  unsigned int const hash_len,
+                  const unsigned char *const ctx,
+                  unsigned int const ctx_len,
+                  unsigned char *const sig,
+                  unsigned int const sig_len,
+                  unsigned int *const info) {
+    (void) mode;
+    (void) hashID;
+    (void) ctx;
+    (void) ctx_len;
+    if (info != NULL) *info = 0;
+    return (int) placeholder_signature(pvkey, hash, hash_len, sig, sig_len);
+}
+
+int cx_ecdsa_sign(const cx_ecfp_private_key_t *const pvkey,
+                  int const mode,
+                  int const hashID,
+                  const unsigned char *const hash,
+                  unsigned int const hash_len,
+                  unsigned char *const sig,
+                  unsigned int const sig_len,
+                  unsigned int *const info) {
+    (void) mode;
+    (void) hashID;
+    if (info != NULL) *info = 0;
+    return (int) placeholder_signature(pvkey, hash, hash_len, sig, sig_len);
+}
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""Moves baking from one baking host build to another with INS_EXPORT_HWM and INS_SETUP with
+P1_SETUP_ATTESTED, and checks that the standby never ends up below the watermarks exported.
+
+Usage: failover.py <tezos-host-baking>
+"""
+
+import os
+import sys
+import tempfile
+
+from hostapp import INS_SIGN, PATH, apdu, expect, run, sign_apdus
+
+INS_SETUP = 0x0A
+INS_QUERY_ALL_HWM = 0x0B
+INS_HMAC = 0x0E
+INS_EXPORT_HWM = 0x15
+P1_SETUP_ATTESTED = 0x01
+
+MAIN_CHAIN = 0x7A06A770
+TEST_CHAIN = 0x3E0A5C6F
+STANDBY_CHAIN = 0x5B11C0DE
+OTHER_PATH = bytes.fromhex("048000002c800006c18000000080000001")  # 44'/1729'/0'/1'
+OK = b"\x90\x00"
+SECURITY = b"\x69\x82"  # EXC_SECURITY
+REJECTED = b"\x69\x85"  # EXC_REJECT
+
+
+def block(chain, level):
+    return b"\x01" + chain.to_bytes(4, "big") + level.to_bytes(4, "big") + b"\x01" + bytes(32)
+
+
+def endorsement(chain, level):
+    return b"\x02" + chain.to_bytes(4, "big") + bytes(32) + b"\x00" + level.to_bytes(4, "big")
+
+
+def setup(main, test, path=PATH, chain=MAIN_CHAIN):
+    data = chain.to_bytes(4, "big") + main.to_bytes(4, "big") + test.to_bytes(4, "big")
+    return apdu(INS_SETUP, 0, data + path)
+
+
+def watermarks(binary, image):
+    [response] = run(binary, [apdu(INS_QUERY_ALL_HWM, 0)], {"TEZOS_HOST_NVRAM": image}).responses
+    return tuple(int.from_bytes(response[i:i + 4], "big") for i in (0, 4, 8))
+
+
+def signs(binary, image, message):
+    """Whether `image` signs `message`, which is then kept as it was."""
+    copy = image + ".try"
+    with open(image, "rb") as f, open(copy, "wb") as g:
+        g.write(f.read())
+    responses = run(binary, list(sign_apdus(INS_SIGN, message)), {"TEZOS_HOST_NVRAM": copy})
+    os.remove(copy)
+    return responses.responses[-1][-2:] == OK
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    binary = sys.argv[1]
+
+    with tempfile.TemporaryDirectory() as directory:
+        primary = {"TEZOS_HOST_NVRAM": os.path.join(directory, "primary")}
+        standby = os.path.join(directory, "standby")
+
+        [response] = run(binary, [apdu(INS_EXPORT_HWM, 0)], primary).responses
+        expect(response == SECURITY, "exported without a baking key: %s" % response.hex())
+
+        commands = [setup(0, 0)]
+        for message in (block(MAIN_CHAIN, 49), block(MAIN_CHAIN, 50), endorsement(MAIN_CHAIN, 50),
+                        block(TEST_CHAIN, 7)):
+            commands += sign_apdus(INS_SIGN, message)
+        commands.append(apdu(INS_EXPORT_HWM, 0))
+        responses = run(binary, commands, primary).responses
+        expect(all(r[-2:] == OK for r in responses), "primary: %r" % [r.hex() for r in responses])
+        exported = responses[-1][:-2]
+        fields = MAIN_CHAIN.to_bytes(4, "big") + (50).to_bytes(4, "big") + b"\x01" + \
+            (7).to_bytes(4, "big") + b"\x00"
+        expect(len(exported) == 46 and exported[:14] == fields, "exported %s" % exported.hex())
+        [hmac] = run(binary, [apdu(INS_HMAC, 0, PATH + exported[:14])]).responses
+        expect(hmac[:-2] != exported[14:], "INS_HMAC attests watermarks")
+        print("ok: exported %s" % exported[:14].hex())
+
+        # The standby takes the watermarks, the endorsement of level 50 included, in one prompt.
+        result = run(binary, [apdu(INS_SETUP, P1_SETUP_ATTESTED, exported + PATH)],
+                     {"TEZOS_HOST_NVRAM": standby})
+        expect(result.responses[0][-2:] == OK, "import: %s" % result.responses[0].hex())
+        expect(result.screens.count("[Accept]") == 1 and "Attested HWM?" in result.screens and
+               "Main Chain HWM: 50" in result.screens, "screens:\n%s" % result.screens)
+        expect(watermarks(binary, standby) == (50, 7, MAIN_CHAIN),
+               "standby watermarks %r" % (watermarks(binary, standby),))
+        expect(not signs(binary, standby, endorsement(MAIN_CHAIN, 50)), "endorsed level 50 again")
+        expect(not signs(binary, standby, block(TEST_CHAIN, 7)), "signed test block 7 again")
+        expect(signs(binary, standby, block(MAIN_CHAIN, 51)), "refused block 51")
+        print("ok: imported on the standby, which refuses what the primary signed")
+
+        # Only ever raised: a standby that is ahead keeps its own watermarks.
+        run(binary, [setup(80, 3)], {"TEZOS_HOST_NVRAM": standby})
+        run(binary, [apdu(INS_SETUP, P1_SETUP_ATTESTED, exported + PATH)],
+            {"TEZOS_HOST_NVRAM": standby})
+        expect(watermarks(binary, standby) == (80, 7, MAIN_CHAIN),
+               "watermarks %r after importing below them" % (watermarks(binary, standby),))
+        print("ok: never lowered")
+
+        # A standby on another main chain, or on none, keeps its watermark for the chains it baked:
+        # they are now test chains, or all of them.
+        for chain, expected in ((STANDBY_CHAIN, (50, 1000)), (0, (1000, 1000))):
+            run(binary, [setup(1000, 0, chain=chain)], {"TEZOS_HOST_NVRAM": standby})
+            run(binary, [apdu(INS_SETUP, P1_SETUP_ATTESTED, exported + PATH)],
+                {"TEZOS_HOST_NVRAM": standby})
+            expect(watermarks(binary, standby) == expected + (MAIN_CHAIN,),
+                   "watermarks %r after importing on chain %#x" %
+                   (watermarks(binary, standby), chain))
+            baked = STANDBY_CHAIN if chain else MAIN_CHAIN
+            expect(not signs(binary, standby, block(baked, 1000)), "signed %#x again" % baked)
+            expect(signs(binary, standby, block(baked, 1001)), "refused %#x above" % baked)
+        print("ok: kept for the chains the standby baked on another main chain, or on none")
+
+        # Nothing changes unless the attestation is intact, from the same key, and accepted.
+        run(binary, [setup(0, 0)], {"TEZOS_HOST_NVRAM": standby})
+        for name, data in (("a lower level", exported[:7] + b"\x31" + exported[8:]),
+                           ("no endorsement", exported[:8] + b"\x00" + exported[9:]),
+                           ("a wrong HMAC", exported[:-1] + bytes([exported[-1] ^ 1])),
+                           ("another key", exported)):
+            path = OTHER_PATH if name == "another key" else PATH
+            result = run(binary, [apdu(INS_SETUP, P1_SETUP_ATTESTED, data + path)],
+                         {"TEZOS_HOST_NVRAM": standby})
+            expect(result.responses[0] == SECURITY and "[Accept]" not in result.screens,
+                   "%s: %s" % (name, result.responses[0].hex()))
+        result = run(binary, [apdu(INS_SETUP, P1_SETUP_ATTESTED, exported + PATH)],
+                     {"TEZOS_HOST_NVRAM": standby, "TEZOS_HOST_PROMPT": "reject"})
+        expect(result.responses[0] == REJECTED, "rejected: %s" % result.responses[0].hex())
+        expect(watermarks(binary, standby) == (0, 0, MAIN_CHAIN),
+               "watermarks %r after refused imports" % (watermarks(binary, standby),))
+        print("ok: tampered, foreign and rejected attestations change nothing")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,66 @@
+// Fuzz target: arbitrary sequences of APDUs through the dispatch of `main_loop`, with the
+// sanitizers watching every access. The baking app must also never lower a watermark, except when
+// asked to with INS_RESET or INS_SETUP.
+//
+// Input: a byte choosing how prompts are answered (enum fuzz_prompts, modulo), then the APDUs,
+// each a length byte followed by that many bytes.
+
+#include "fuzz.h"
+
+#include "apdu.h"
+#include "globals.h"
+
+#include <stdlib.h>
+
+#define MAX_APDUS 1024
+
+#ifdef BAKING_APP
+
+struct watermarks {
+    level_t main;
+    level_t test;
+};
+
+static void check_watermarks(void *const context,
+                             uint8_t const *const command,
+                             uint8_t const *const response,
+                             size_t const length) {
+    (void) response;
+    (void) length;
+    struct watermarks *const before = context;
+    struct watermarks const now = {N_data.hwm.main.highest_level, N_data.hwm.test.highest_level};
+    uint8_t const instruction = command[OFFSET_INS];
+    if (instruction != INS_RESET && instruction != INS_SETUP &&
+        (now.main < before->main || now.test < before->test)) {
+        fuzz_fail("instruction 0x%02x lowered the watermarks from %u/%u to %u/%u",
+                  instruction,
+                  before->main,
+                  before->test,
+                  now.main,
+                  now.test);
+    }
+    *before = now;
+}
+
+#endif
+
+int LLVMFuzzerTestOneInput(uint8_t const *const data, size_t const size) {
+    if (size == 0) return 0;
+    static struct fuzz_apdu apdus[MAX_APDUS];
+    size_t count = 0;
+    for (size_t offset = 1; offset < size && count < MAX_APDUS; count++) {
+        size_t const length = data[offset++];
+        apdus[count].data = &data[offset];
+        apdus[count].length = length < size - offset ? length : size - offset;
+        offset += apdus[count].length;
+    }
+
+    enum fuzz_prompts const prompts = data[0] % NUM_FUZZ_PROMPTS;
+#ifdef BAKING_APP
+    struct watermarks watermarks = {0, 0};
+    fuzz_run(apdus, count, prompts, check_watermarks, &watermarks);
+#else
+    fuzz_run(apdus, count, prompts, NULL, NULL);
+#endif
+    return 0;
+}
@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""Writes the seeds of the fuzz targets from the APDUs of test/apdu-tests.
+
+Usage: fuzz-corpus.py <directory>
+
+<directory>/fuzz-apdu gets the APDUs of each script and transcript, once for each way of answering
+prompts (see fuzz-apdu.c); <directory>/fuzz-split gets the message of each signature in them, for
+INS_SIGN and INS_SIGN_WITH_HASH (see fuzz-split.c).
+"""
+
+import glob
+import hashlib
+import os
+import re
+import shutil
+import sys
+
+APDU_TESTS = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "apdu-tests")
+# The APDUs of the scripts are echoed; those of the transcripts stand alone (see apdu-replay.py).
+LINE = re.compile(r"^\s*(?:echo\s+)?((?:[0-9A-Fa-f]{2}|\{level\}){5,})\s*(?:#.*)?$")
+INS_SIGN = 0x04
+INS_SIGN_WITH_HASH = 0x0F
+PROMPTS = 3  # enum fuzz_prompts
+P1_LAST_MARKER = 0x80
+
+
+def transcripts():
+    """Yields the name and the APDUs of each script and transcript."""
+    for path in sorted(glob.glob(os.path.join(APDU_TESTS, "*", "*"))):
+        with open(path) as f:
+            apdus = [bytes.fromhex(m.group(1).replace("{level}", "00000001"))
+                     for m in map(LINE.match, f) if m]
+        if apdus:
+            yield os.path.relpath(path, APDU_TESTS).replace(os.sep, "-"), apdus
+
+
+def messages(apdus):
+    """Yields the messages signed by `apdus`: the data of the packets after the first."""
+    message = None
+    for command in apdus:
+        if command[1] not in (INS_SIGN, INS_SIGN_WITH_HASH):
+            continue
+        p1 = command[2]
+        if p1 == 0:
+            message = b""
+        elif message is not None:
+            message += command[5:]
+            if p1 & P1_LAST_MARKER:
+                yield message
+                message = None
+
+
+def write(directory, seed):
+    with open(os.path.join(directory, hashlib.sha1(seed).hexdigest()), "wb") as f:
+        f.write(seed)
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    apdu_seeds = os.path.join(sys.argv[1], "fuzz-apdu")
+    split_seeds = os.path.join(sys.argv[1], "fuzz-split")
+    for directory in (apdu_seeds, split_seeds):
+        shutil.rmtree(directory, ignore_errors=True)
+        os.makedirs(directory)
+
+    for _, apdus in transcripts():
+        sequence = b"".join(bytes([len(command)]) + command for command in apdus)
+        for prompts in range(PROMPTS):
+            write(apdu_seeds, bytes([prompts]) + sequence)
+        for message in messages(apdus):
+            for instruction in range(2):
+                write(split_seeds, bytes([instruction, len(message) & 0xFF]) + message)
+    print("%d and %d seeds" % (len(os.listdir(apdu_seeds)), len(os.listdir(split_seeds))))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,140 @@
+// Fuzz target: the signing parsers, which take the message a packet at a time, must come to the
+// same answer whatever the packets. Each input is signed twice: in packets as large as the clients
+// send, and in packets of sizes drawn from the input. The first refusal, or else the last response,
+// must be the same both times; the baking app must refuse any message split in several packets.
+//
+// Input: a byte choosing the instruction (INS_SIGN or INS_SIGN_WITH_HASH), a byte seeding the sizes
+// of the packets of the second signature, then the message.
+
+#include "fuzz.h"
+
+#include "apdu.h"
+#include "globals.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define CLA             0x80
+#define CURVE_ED25519   0x00
+#define MAX_PACKET_SIZE 230
+
+// As in apdu_sign.c.
+#define P1_FIRST       0x00
+#define P1_NEXT        0x01
+#define P1_LAST_MARKER 0x80
+
+// 44'/1729'/0'/0'
+static uint8_t const path[] = {0x04, 0x80, 0x00, 0x00, 0x2c, 0x80, 0x00, 0x06, 0xc1,
+                               0x80, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00};
+
+struct outcome {
+    size_t skip;  // Responses to ignore, to the setup
+    bool decided;
+    uint8_t response[IO_APDU_BUFFER_SIZE];
+    size_t length;
+};
+
+static void keep_outcome(void *const context,
+                         uint8_t const *const command,
+                         uint8_t const *const response,
+                         size_t const length) {
+    (void) command;
+    struct outcome *const outcome = context;
+    if (outcome->skip > 0) {
+        outcome->skip--;
+        return;
+    }
+    if (outcome->decided) return;
+    memcpy(outcome->response, response, length);
+    outcome->length = length;
+    outcome->decided = response[length - 2] != 0x90 || response[length - 1] != 0x00;
+}
+
+static uint8_t *header(uint8_t *const out,
+                       uint8_t const instruction,
+                       uint8_t const p1,
+                       size_t const lc) {
+    out[OFFSET_CLA] = CLA;
+    out[OFFSET_INS] = instruction;
+    out[OFFSET_P1] = p1;
+    out[OFFSET_CURVE] = CURVE_ED25519;
+    out[OFFSET_LC] = lc;
+    return out + OFFSET_CDATA;
+}
+
+// Signs `message` in packets of MAX_PACKET_SIZE bytes, or of sizes drawn from `seed` unless it is
+// 0, and keeps the outcome. Returns the number of packets of the message.
+static size_t sign_message(struct outcome *const outcome,
+                           uint8_t const instruction,
+                           uint8_t const *const message,
+                           size_t const length,
+                           uint32_t seed) {
+    size_t const max_apdus = 2 + length;
+    struct fuzz_apdu *const apdus = calloc(max_apdus, sizeof(*apdus));
+    uint8_t *const buffer = calloc(max_apdus, OFFSET_CDATA + MAX_PACKET_SIZE);
+    if (apdus == NULL || buffer == NULL) abort();
+    size_t count = 0;
+    size_t packets = 0;
+    uint8_t *out = buffer;
+
+#ifdef BAKING_APP
+    apdus[count++] = (struct fuzz_apdu){out, OFFSET_CDATA + sizeof(path)};
+    memcpy(header(out, INS_AUTHORIZE_BAKING, 0, sizeof(path)), path, sizeof(path));
+    out += OFFSET_CDATA + sizeof(path);
+    outcome->skip = 1;
+#endif
+    apdus[count++] = (struct fuzz_apdu){out, OFFSET_CDATA + sizeof(path)};
+    memcpy(header(out, instruction, P1_FIRST, sizeof(path)), path, sizeof(path));
+    out += OFFSET_CDATA + sizeof(path);
+
+    for (size_t offset = 0; offset < length;) {
+        size_t size = MAX_PACKET_SIZE;
+        if (seed != 0) {
+            seed ^= seed << 13;  // xorshift32
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            size = 1 + seed % MAX_PACKET_SIZE;
+        }
+        if (size > length - offset) size = length - offset;
+        uint8_t const p1 = P1_NEXT | (offset + size == length ? P1_LAST_MARKER : 0);
+        apdus[count++] = (struct fuzz_apdu){out, OFFSET_CDATA + size};
+        memcpy(header(out, instruction, p1, size), &message[offset], size);
+        out += OFFSET_CDATA + size;
+        offset += size;
+        packets++;
+    }
+
+    fuzz_run(apdus, count, FUZZ_ACCEPT, keep_outcome, outcome);
+    free(buffer);
+    free(apdus);
+    return packets;
+}
+
+int LLVMFuzzerTestOneInput(uint8_t const *const data, size_t const size) {
+    if (size < 2) return 0;
+    uint8_t const instruction = data[0] & 1 ? INS_SIGN_WITH_HASH : INS_SIGN;
+    uint32_t const seed = 0x9E3779B9u * (data[1] + 1u);
+
+    static struct outcome whole, split;
+    memset(&whole, 0, sizeof(whole));
+    memset(&split, 0, sizeof(split));
+    sign_message(&whole, instruction, data + 2, size - 2, 0);
+    size_t const packets = sign_message(&split, instruction, data + 2, size - 2, seed);
+#ifdef BAKING_APP
+    // The baking app only takes messages in a single packet (see parse_baking_packet).
+    if (packets > 1) {
+        if (!split.decided) fuzz_fail("signed %zu bytes in %zu packets", size - 2, packets);
+        return 0;
+    }
+#else
+    (void) packets;
+#endif
+    if (whole.length != split.length || memcmp(whole.response, split.response, whole.length) != 0) {
+        fuzz_fail("%zu bytes signed in large packets and in smaller ones end differently: "
+                  "%zu and %zu bytes of response",
+                  size - 2,
+                  whole.length,
+                  split.length);
+    }
+    return 0;
+}
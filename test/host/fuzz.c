@@ -0,0 +1,131 @@
+// The transport of the fuzz targets, in place of the one of host.c (see HOST_FUZZ there): APDUs
+// come from the input of the target and responses go back to it, and the app is powered off once
+// they run out, so that the next input starts from boot in the same process.
+//
+// With libFuzzer (`make -C test/host fuzz`), the targets run under its main. Built with
+// FUZZ_STANDALONE, they replay inputs instead: each argument is a file holding one, or a directory
+// of them, as libFuzzer keeps its corpus.
+
+#include "fuzz.h"
+
+#include "apdu.h"
+#include "globals.h"
+#include "os.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void host_run(void);
+__attribute__((noreturn)) void host_stop(void);
+
+static struct {
+    struct fuzz_apdu const *apdus;
+    size_t count;
+    size_t next;
+    fuzz_response_t on_response;
+    void *context;
+    uint8_t command[IO_APDU_BUFFER_SIZE];  // The APDU being answered
+} fuzz;
+
+static char const *const prompt_answers[NUM_FUZZ_PROMPTS] = {
+    [FUZZ_ACCEPT] = NULL,
+    [FUZZ_REJECT] = "reject",
+    [FUZZ_REJECT_EARLY] = "reject-early",
+};
+
+void fuzz_fail(char const *const format, ...) {
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "fuzz: ");
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+    abort();
+}
+
+unsigned short read_apdu(void) {
+    while (fuzz.next < fuzz.count && fuzz.apdus[fuzz.next].length == 0) fuzz.next++;
+    if (fuzz.next == fuzz.count) host_stop();
+    struct fuzz_apdu const *const apdu = &fuzz.apdus[fuzz.next++];
+    size_t const length =
+        apdu->length < sizeof(G_io_apdu_buffer) ? apdu->length : sizeof(G_io_apdu_buffer);
+    memcpy(G_io_apdu_buffer, apdu->data, length);
+    memset(fuzz.command, 0, sizeof(fuzz.command));
+    memcpy(fuzz.command, apdu->data, length);
+    return length;
+}
+
+void write_response(unsigned short const tx_len) {
+    if (tx_len < 2 || tx_len > sizeof(G_io_apdu_buffer)) {
+        fuzz_fail("response of %u bytes to instruction 0x%02x", tx_len, fuzz.command[OFFSET_INS]);
+    }
+    if (fuzz.on_response != NULL) {
+        fuzz.on_response(fuzz.context, fuzz.command, G_io_apdu_buffer, tx_len);
+    }
+}
+
+void fuzz_run(struct fuzz_apdu const *const apdus,
+              size_t const count,
+              enum fuzz_prompts const prompts,
+              fuzz_response_t const on_response,
+              void *const context) {
+    if (prompt_answers[prompts] == NULL) {
+        unsetenv("TEZOS_HOST_PROMPT");
+    } else {
+        setenv("TEZOS_HOST_PROMPT", prompt_answers[prompts], 1);
+    }
+#ifdef BAKING_APP
+    nvm_write((void *) &N_nvram_real, NULL, sizeof(N_nvram_real));
+#endif
+    fuzz.apdus = apdus;
+    fuzz.count = count;
+    fuzz.next = 0;
+    fuzz.on_response = on_response;
+    fuzz.context = context;
+    host_run();
+}
+
+#ifdef FUZZ_STANDALONE
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+static unsigned long replayed;
+
+static void replay(char const *const path) {
+    struct stat info;
+    if (stat(path, &info) != 0) fuzz_fail("cannot read %s", path);
+    if (S_ISDIR(info.st_mode)) {
+        DIR *const directory = opendir(path);
+        if (directory == NULL) fuzz_fail("cannot read %s", path);
+        struct dirent const *entry;
+        while ((entry = readdir(directory)) != NULL) {
+            if (entry->d_name[0] == '.') continue;
+            char child[4096];
+            snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+            replay(child);
+        }
+        closedir(directory);
+        return;
+    }
+    FILE *const file = fopen(path, "rb");
+    uint8_t *const data = malloc(info.st_size ? info.st_size : 1);
+    if (file == NULL || data == NULL ||
+        fread(data, 1, info.st_size, file) != (size_t) info.st_size) {
+        fuzz_fail("cannot read %s", path);
+    }
+    fclose(file);
+    LLVMFuzzerTestOneInput(data, info.st_size);
+    free(data);
+    replayed++;
+}
+
+int main(int const argc, char const *const *const argv) {
+    for (int i = 1; i < argc; i++) replay(argv[i]);
+    printf("ok: %lu inputs\n", replayed);
+    return 0;
+}
+
+#endif  // #ifdef FUZZ_STANDALONE
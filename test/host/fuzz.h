@@ -0,0 +1,36 @@
+// The host build as a fuzz target: fuzz.c runs sequences of APDUs through the app, from boot, and
+// fuzz-apdu.c and fuzz-split.c turn the inputs of the fuzzer into such sequences.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct fuzz_apdu {
+    uint8_t const *data;
+    size_t length;
+};
+
+// How prompts are answered, as with TEZOS_HOST_PROMPT (see ui_host.c).
+enum fuzz_prompts { FUZZ_ACCEPT, FUZZ_REJECT, FUZZ_REJECT_EARLY, NUM_FUZZ_PROMPTS };
+
+// Called with every response, and the APDU it answers.
+typedef void (*fuzz_response_t)(void *context,
+                                uint8_t const *command,
+                                uint8_t const *response,
+                                size_t length);
+
+// Boots the app with blank NVRAM, sends it `apdus` in turn and then powers it off, handing every
+// response to `on_response`. APDUs of no bytes are not sent, and longer ones than the buffer of the
+// device are cut.
+void fuzz_run(struct fuzz_apdu const *apdus,
+              size_t count,
+              enum fuzz_prompts prompts,
+              fuzz_response_t on_response,
+              void *context);
+
+// Reports a broken invariant and aborts, for the fuzzer to keep the input.
+__attribute__((noreturn, format(printf, 1, 2))) void fuzz_fail(char const *format, ...);
+
+// The entry point of libFuzzer.
+int LLVMFuzzerTestOneInput(uint8_t const *data, size_t size);
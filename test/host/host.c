@@ -0,0 +1,274 @@
+// Host implementation of the SDK system and I/O API declared in `sdk/os.h`, and the entry point
+// of the host build.
+//
+// APDUs are read from stdin, one hex-encoded command per line, and each response is written to
+// stdout as one hex-encoded line (status word included). When the application asks for a prompt,
+// it is answered immediately: accepted, unless `TEZOS_HOST_PROMPT=reject` is set (see ui_host.c
+// for `reject-early`). The program exits when stdin is exhausted.
+//
+// Built with HOST_FUZZ, the transport and the entry point are left to fuzz.c instead, which runs
+// the app once per input with `host_run`.
+
+#include "os.h"
+
+#include "apdu_stack.h"
+#include "apdu_status.h"
+#include "globals.h"
+#include "ui.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <ucontext.h>
+
+#ifdef __SANITIZE_ADDRESS__
+#include <sanitizer/asan_interface.h>
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+void app_main(void);
+void host_answer_prompt(void);
+void host_nvram_boot(void);
+void host_run(void);
+__attribute__((noreturn)) void host_stop(void);
+
+try_context_t *G_try_last_open_context;
+unsigned char G_io_apdu_buffer[IO_APDU_BUFFER_SIZE];
+unsigned int G_io_apdu_media = IO_APDU_MEDIA_USB_HID;
+
+void os_longjmp(unsigned int const exception) {
+    if (G_try_last_open_context == NULL) {
+        fprintf(stderr, "host: uncaught exception 0x%04x\n", exception);
+        exit(2);
+    }
+    longjmp(G_try_last_open_context->jmp_buf, exception);
+}
+
+unsigned int pic(unsigned int const linked_address) {
+    return linked_address;
+}
+
+// Transport -------------------------------------------------------------------
+
+#ifdef HOST_FUZZ
+
+// From the input of the fuzz target.
+unsigned short read_apdu(void);
+void write_response(unsigned short tx_len);
+
+#else
+
+static int hex_digit(int const c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Returns the length of the next APDU, skipping blank lines and `#` comments.
+static unsigned short read_apdu(void) {
+    static char line[2 * IO_APDU_BUFFER_SIZE + 16];
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        size_t len = 0;
+        int high = -1;
+        for (char const *c = line; *c != '\0' && *c != '#'; c++) {
+            int const digit = hex_digit(*c);
+            if (digit < 0) continue;
+            if (high < 0) {
+                high = digit;
+            } else {
+                if (len == sizeof(G_io_apdu_buffer)) {
+                    fprintf(stderr, "host: APDU too long\n");
+                    exit(2);
+                }
+                G_io_apdu_buffer[len++] = (unsigned char) (high << 4 | digit);
+                high = -1;
+            }
+        }
+        if (len > 0) return (unsigned short) len;
+    }
+    fflush(stdout);
+    exit(0);
+}
+
+static void write_response(unsigned short const tx_len) {
+    for (size_t i = 0; i < tx_len; i++) printf("%02x", G_io_apdu_buffer[i]);
+    printf("\n");
+}
+
+#endif  // #ifdef HOST_FUZZ
+
+unsigned short io_exchange(unsigned char const channel_and_flags, unsigned short const tx_len) {
+    if (tx_len > 0) write_response(tx_len);
+    if (channel_and_flags & IO_RETURN_AFTER_TX) return 0;
+    if (channel_and_flags & IO_ASYNCH_REPLY) {
+        // The device would now run the UI until the user answers; the prompt callback sends the
+        // delayed response.
+        host_answer_prompt();
+    }
+    return read_apdu();
+}
+
+void io_seproxyhal_spi_send(const unsigned char *const buffer, unsigned short const length) {
+    (void) buffer;
+    (void) length;
+}
+
+unsigned short io_seproxyhal_spi_recv(unsigned char *const buffer,
+                                      unsigned short const max_length,
+                                      unsigned int const flags) {
+    (void) buffer;
+    (void) max_length;
+    (void) flags;
+    return 0;
+}
+
+void reset(void) {
+}
+
+// System ----------------------------------------------------------------------
+
+void os_boot(void) {
+}
+
+void os_sched_exit(int const exit_code) {
+    fflush(stdout);
+    exit(exit_code & 0xFF);
+}
+
+void os_ux_blocking(bolos_ux_params_t *const params) {
+    (void) params;
+}
+
+void check_api_level(unsigned int const api_level) {
+    (void) api_level;
+}
+
+void os_lib_end(void) {
+}
+
+static struct timespec host_started;
+
+// Milliseconds since the app started, as on the device, but from a real clock rather than the
+// 100 ms ticker.
+uint32_t status_clock(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - host_started.tv_sec) * 1000 +
+           (now.tv_nsec - host_started.tv_nsec) / 1000000;
+}
+
+// The app runs on a stack of its own, right above the canary, as on the device; that is where the
+// stack telemetry of apdu_stack.h looks for it.
+#define HOST_STACK_SIZE (48 * 1024)
+
+static struct {
+    unsigned int canary;
+    uint8_t stack[HOST_STACK_SIZE];
+} host_stack __attribute__((aligned(16)));
+
+extern unsigned int app_stack_canary __attribute__((alias("host_stack")));
+
+static ucontext_t host_context;
+
+#ifdef __SANITIZE_ADDRESS__
+
+// AddressSanitizer is told whenever the app's stack is entered and left, so that it knows which
+// frames the longjmp of an exception jumps over.
+static void const *host_context_stack;
+static size_t host_context_stack_size;
+
+static void switch_to_app(void) {
+    __sanitizer_start_switch_fiber(NULL, host_stack.stack, sizeof(host_stack.stack));
+}
+
+static void entered_app(void) {
+    __sanitizer_finish_switch_fiber(NULL, &host_context_stack, &host_context_stack_size);
+}
+
+static void switch_to_host(void) {
+    __sanitizer_start_switch_fiber(NULL, host_context_stack, host_context_stack_size);
+}
+
+static void entered_host(void) {
+    __sanitizer_finish_switch_fiber(NULL, NULL, NULL);
+}
+
+#else
+
+static void switch_to_app(void) {
+}
+
+static void entered_app(void) {
+}
+
+static void switch_to_host(void) {
+}
+
+static void entered_host(void) {
+}
+
+#endif  // #ifdef __SANITIZE_ADDRESS__
+
+// As `main` in boot.c.
+static void run_app(void) {
+    uint8_t tag;
+    entered_app();
+    G_try_last_open_context = NULL;
+    init_globals();
+    global.stack_root = &tag;
+#ifdef HAVE_STACK_TELEMETRY
+    stack_paint();
+#endif
+    BEGIN_TRY {
+        TRY {
+            ui_init();
+            ui_initial_screen();
+            app_main();
+        }
+        CATCH_OTHER(e) {
+            fprintf(stderr, "host: exception 0x%04x escaped the main loop\n", e);
+            exit(2);
+        }
+        FINALLY {
+        }
+    }
+    END_TRY;
+    switch_to_host();
+}
+
+// Runs the app from boot on its stack, until it returns or `host_stop` is called.
+void host_run(void) {
+#ifdef __SANITIZE_ADDRESS__
+    // The frames `host_stop` left behind are still poisoned.
+    ASAN_UNPOISON_MEMORY_REGION(host_stack.stack, sizeof(host_stack.stack));
+#endif
+    ucontext_t app_context;
+    getcontext(&app_context);
+    app_context.uc_stack.ss_sp = host_stack.stack;
+    app_context.uc_stack.ss_size = sizeof(host_stack.stack);
+    app_context.uc_link = &host_context;
+    makecontext(&app_context, run_app, 0);
+    switch_to_app();
+    swapcontext(&host_context, &app_context);
+    entered_host();
+}
+
+// Leaves the app wherever it is, as a device does on power off, and returns from `host_run`.
+void host_stop(void) {
+    switch_to_host();
+    setcontext(&host_context);
+    abort();
+}
+
+#ifndef HOST_FUZZ
+
+int main(void) {
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    clock_gettime(CLOCK_MONOTONIC, &host_started);
+    host_nvram_boot();
+    host_run();
+    return 0;
+}
+
+#endif  // #ifndef HOST_FUZZ
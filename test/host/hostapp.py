@@ -0,0 +1,159 @@
+"""Helpers shared by the host tests: building APDUs and running the host build on them."""
+
+import hashlib
+import os
+import subprocess
+import sys
+import tempfile
+
+CLA = 0x80
+INS_AUTHORIZE_BAKING = 0x01
+INS_GET_PUBLIC_KEY = 0x02
+INS_SIGN = 0x04
+INS_SIGN_UNSAFE = 0x05
+INS_SIGN_WITH_HASH = 0x0F
+INS_SET_PAYOUT_POLICY = 0x10
+P1_FIRST = 0x00
+P1_NEXT = 0x01
+P1_HASH_ONLY_NEXT = 0x03
+P1_LAST_MARKER = 0x80
+CURVE_ED25519 = 0x00
+MAX_APDU_SIZE = 230
+
+PATH = bytes.fromhex("048000002c800006c18000000080000000")  # 44'/1729'/0'/0'
+
+BRANCH = bytes(32)
+TAG_TRANSACTION = 0x6C
+TAG_ORIGINATION = 0x6D
+TAG_DELEGATION = 0x6E
+
+
+def apdu(ins, p1, data=b""):
+    return bytes([CLA, ins, p1, CURVE_ED25519, len(data)]) + data
+
+
+def sign_apdus(ins, message, p1_next=P1_NEXT, size=MAX_APDU_SIZE, path=PATH):
+    """Yields the APDUs of a signing session for `message`, sent `size` bytes at a time."""
+    yield apdu(ins, P1_FIRST, path)
+    for offset in range(0, len(message), size):
+        last = offset + size >= len(message)
+        p1 = p1_next | (P1_LAST_MARKER if last else 0)
+        yield apdu(ins, p1, message[offset:offset + size])
+
+
+def z(n):
+    """Encodes a natural number in the Zarith format used by operations."""
+    out = bytearray()
+    while True:
+        byte = n & 0x7F
+        n >>= 7
+        if n == 0:
+            out.append(byte)
+            return bytes(out)
+        out.append(byte | 0x80)
+
+
+def implicit(n):
+    return b"\x00" + bytes([n]) * 20  # tz1 whose hash is n repeated
+
+
+def manager_fields(tag, source, fee, storage_limit=0):
+    return bytes([tag]) + source + z(fee) + z(1) + z(10000) + z(storage_limit)
+
+
+def transaction(source, amount, destination, fee=1000, parameters=False, storage_limit=0):
+    contents = manager_fields(TAG_TRANSACTION, source, fee, storage_limit)
+    contents += z(amount) + b"\x00" + destination
+    if not parameters:
+        return contents + b"\x00"
+    return contents + b"\xff\x02" + (5).to_bytes(4, "big") + b"\x02" + bytes(4)
+
+
+def originated(n):
+    return b"\x01" + bytes([n]) * 20 + b"\x00"  # KT1 whose hash is n repeated
+
+
+def entrypoint(name):
+    standard = ["default", "root", "do", "set_delegate", "remove_delegate"]
+    if name in standard:
+        return bytes([standard.index(name)])
+    return b"\xff" + bytes([len(name)]) + name.encode()
+
+
+def contract_call(source, amount, destination, name, arguments, fee=1000):
+    contents = manager_fields(TAG_TRANSACTION, source, fee) + z(amount) + destination
+    return contents + b"\xff" + entrypoint(name) + len(arguments).to_bytes(4, "big") + arguments
+
+
+def origination(source, balance, code, storage, delegate=None, fee=1000):
+    contents = manager_fields(TAG_ORIGINATION, source, fee) + z(balance)
+    contents += b"\x00" if delegate is None else b"\xff" + delegate
+    for part in (code, storage):
+        contents += len(part).to_bytes(4, "big") + part
+    return contents
+
+
+def delegation(source, delegate, fee=1000):
+    return manager_fields(TAG_DELEGATION, source, fee) + b"\xff" + delegate
+
+
+def source_of(key):
+    # The signing key's tz1: BLAKE2b-160 of the ed25519 public key without its prefix byte.
+    return b"\x00" + hashlib.blake2b(key[1:], digest_size=20).digest()
+
+
+def tx(amount, destination, **kwargs):
+    """Returns a transaction from the key given to `operation_group`."""
+    return lambda key: transaction(source_of(key), amount, destination, **kwargs)
+
+
+def dlg(delegate, **kwargs):
+    return lambda key: delegation(source_of(key), delegate, **kwargs)
+
+
+def call(amount, destination, name, arguments, **kwargs):
+    return lambda key: contract_call(source_of(key), amount, destination, name, arguments, **kwargs)
+
+
+def orig(balance, code, storage, **kwargs):
+    return lambda key: origination(source_of(key), balance, code, storage, **kwargs)
+
+
+def operation_group(key, operations):
+    return b"\x03" + BRANCH + b"".join(op(key) for op in operations)
+
+
+def public_key(binary):
+    return run(binary, [apdu(INS_GET_PUBLIC_KEY, 0, PATH)]).responses[0][1:-2]
+
+
+class Run:
+    """The outcome of one run of the host build: responses, screens shown and peak RSS in KB."""
+
+    def __init__(self, responses, screens, max_rss):
+        self.responses = responses
+        self.screens = screens
+        self.max_rss = max_rss
+
+
+def run(binary, apdus, env=None):
+    with tempfile.TemporaryFile() as stdin, tempfile.TemporaryFile() as stderr:
+        for command in apdus:
+            stdin.write(command.hex().encode() + b"\n")
+        stdin.seek(0)
+        process = subprocess.Popen([binary], stdin=stdin, stdout=subprocess.PIPE, stderr=stderr,
+                                   env=dict(os.environ, **(env or {})))
+        output = process.stdout.read()
+        _, status, usage = os.wait4(process.pid, 0)
+        process.returncode = os.waitstatus_to_exitcode(status)
+        stderr.seek(0)
+        screens = stderr.read().decode()
+    if process.returncode != 0:
+        sys.exit("host build exited with %d:\n%s" % (process.returncode, screens))
+    responses = [bytes.fromhex(line) for line in output.decode().split()]
+    return Run(responses, screens, usage.ru_maxrss)
+
+
+def expect(condition, message):
+    if not condition:
+        sys.exit("FAIL: " + message)
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""Signs manager.tz operations, calls to the "do" entrypoint of a KT1 whose parameters are one of
+a few known Michelson scripts, with the host build and checks the review screens.
+
+Usage: manager-tz.py <path to tezos-host-wallet>
+"""
+
+import sys
+
+from batch import review
+from hostapp import call, expect, implicit, operation_group, originated, public_key
+
+# Primitives, with the node tag for their number of arguments
+DROP, NIL, OPERATION, CONS = 0x0320, 0x053D, 0x036D, 0x031B
+PUSH, KEY_HASH, ADDRESS, MUTEZ = 0x0743, 0x035D, 0x036E, 0x036A
+SOME, NONE, SET_DELEGATE = 0x0346, 0x053E, 0x034E
+IMPLICIT_ACCOUNT, UNIT, TRANSFER_TOKENS = 0x031E, 0x034F, 0x034D
+CONTRACT, CONTRACT_ANNOTS, UNIT_TYPE = 0x0555, 0x0655, 0x036C
+IF_NONE, FAILWITH = 0x072F, 0x0327
+
+
+def length_prefixed(tag, data):
+    return bytes([tag]) + len(data).to_bytes(4, "big") + data
+
+
+def seq(*nodes):
+    return length_prefixed(0x02, b"".join(nodes))
+
+
+def prim(code, *args, annots=None):
+    node = code.to_bytes(2, "big") + b"".join(args)
+    return node if annots is None else node + length_prefixed(0x00, annots.encode())[1:]
+
+
+def nat(n):
+    out = bytearray([n & 0x3F | (0x80 if n >> 6 else 0)])
+    n >>= 6
+    while n:
+        out.append(n & 0x7F | (0x80 if n >> 7 else 0))
+        n >>= 7
+    return b"\x00" + bytes(out)
+
+
+def string(text):
+    return length_prefixed(0x01, text.encode())
+
+
+def raw(data):
+    return length_prefixed(0x0A, data)
+
+
+def script(*instructions):
+    return seq(prim(DROP), prim(NIL, prim(OPERATION)), *instructions, prim(CONS))
+
+
+TRANSFER = [prim(PUSH, prim(MUTEZ), nat(1234567)), prim(UNIT), prim(TRANSFER_TOKENS)]
+ASSERT_SOME = prim(IF_NONE, seq(seq(prim(UNIT), prim(FAILWITH))), seq())
+KT1 = "KT1BEqzn5Wx8uJrZNvuS9DVHmLvG9td3fDLi"
+TZ1 = "tz1KjMn6Hb23eu1rNemou6ytAzzNxzvaYHyK"
+
+CASES = [
+    ("set delegate", script(prim(PUSH, prim(KEY_HASH), raw(implicit(7))), prim(SOME),
+                            prim(SET_DELEGATE)),
+     {"Confirm": ["Delegation"], "Delegate": ["tz1LHBqjkR1QoJ1k2uukvSVaXGrpkBLZhG48"]}),
+    ("set delegate by name", script(prim(PUSH, prim(KEY_HASH), string(TZ1)), prim(SOME),
+                                    prim(SET_DELEGATE)),
+     {"Confirm": ["Delegation"], "Delegate": [TZ1]}),
+    ("remove delegate", script(prim(NONE, prim(KEY_HASH)), prim(SET_DELEGATE)),
+     {"Withdraw": ["Delegation"]}),
+    ("transfer to an implicit account",
+     script(prim(PUSH, prim(KEY_HASH), raw(implicit(7))), prim(IMPLICIT_ACCOUNT), *TRANSFER),
+     {"Confirm": ["Transaction"], "Amount": ["1.234567"]}),
+    ("transfer to a contract",
+     script(prim(PUSH, prim(ADDRESS), raw(originated(8))), prim(CONTRACT, prim(UNIT_TYPE)),
+            ASSERT_SOME, *TRANSFER),
+     {"Confirm": ["Transaction"], "Amount": ["1.234567"]}),
+    ("transfer to a contract's default entrypoint",
+     script(prim(PUSH, prim(ADDRESS), string(KT1)),
+            prim(CONTRACT_ANNOTS, prim(UNIT_TYPE), annots="%default"), ASSERT_SOME, *TRANSFER),
+     {"Confirm": ["Transaction"], "Amount": ["1.234567"], "Destination": [KT1]}),
+]
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    binary = sys.argv[1]
+    key = public_key(binary)
+
+    def manager_tz(parameters):
+        return operation_group(key, [call(0, originated(1), "do", parameters)])
+
+    for name, parameters, expected in CASES:
+        # Small APDUs, so that the script is decoded across many of them.
+        for size in (230, 7):
+            screens = review(binary, manager_tz(parameters), size=size)
+            for title, values in expected.items():
+                expect(screens.get(title) == values, "%s: %r" % (name, screens))
+        print("ok: " + name)
+
+    set_delegate = CASES[0][1]
+    for name, parameters in [
+        ("an extra instruction", script(prim(DROP), prim(NONE, prim(KEY_HASH)), prim(SET_DELEGATE))),
+        ("a negative amount", CASES[3][1].replace(nat(1234567), b"\x00\x41")),
+        ("another annotation", CASES[5][1].replace(b"%default", b"%deposit")),
+        ("a truncated script", set_delegate[:-1]),
+        ("trailing data", set_delegate + prim(DROP)),
+        ("a bad checksum", CASES[1][1].replace(TZ1.encode(), TZ1[:-1].encode() + b"L")),
+        ("an originated delegate", CASES[1][1].replace(TZ1.encode(), KT1.encode())),
+    ]:
+        screens = review(binary, manager_tz(parameters))
+        expect("Unrecognized" in screens, "%s: %r" % (name, screens))
+    print("ok: other scripts are only shown as a hash")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,172 @@
+// Host stand-in for the NVRAM of the device, behind `nvm_write` of `sdk/os.h`. On top of writing,
+// it can keep NVRAM in a file across runs, log every write, and cut power in the middle of one:
+//
+//   TEZOS_HOST_NVRAM=<file>       NVRAM is read from <file> at boot if it exists, and written back
+//                                 to it after every write, as flash keeps it across restarts.
+//   TEZOS_HOST_NVRAM_LOG=<file>   Every write appends `<offset> <length> <changed> <first page>
+//                                 <last page>` to <file>: where it starts in NVRAM, how many bytes
+//                                 it writes and how many of them change, and the flash pages of
+//                                 HOST_NVRAM_PAGE_SIZE bytes it programs.
+//   TEZOS_HOST_POWER_CUT=<n>:<b>  The <n>th write since boot (from 1) stops after its first <b>
+//                                 bytes, which reach NVRAM and the file, and the program exits with
+//                                 HOST_POWER_CUT_STATUS before anything else runs.
+
+#include "os.h"
+
+#include "globals.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define HOST_NVRAM_PAGE_SIZE  64
+#define HOST_POWER_CUT_STATUS 3
+
+void host_nvram_boot(void);
+
+#ifdef BAKING_APP
+
+#define NVRAM_START ((uint8_t *) &N_nvram_real)
+#define NVRAM_SIZE  sizeof(N_nvram_real)
+
+static unsigned long writes;  // Since boot
+
+// The log of writes is kept in memory and written out when the program exits, as formatting it
+// as it goes would add the C library's stack to the app's (see apdu_stack.h).
+struct logged_write {
+    uint32_t offset;
+    uint32_t length;
+    uint32_t changed;
+};
+
+static struct logged_write *logged;
+static size_t num_logged, logged_size;
+
+// NVRAM is declared `const` so that the linker places it in flash. On the host it lands in a
+// read-only section, so the pages holding it are made writable before it is written.
+static void unprotect(void *const address, size_t const length) {
+    long const page_size = sysconf(_SC_PAGESIZE);
+    uintptr_t const start = (uintptr_t) address & ~(uintptr_t)(page_size - 1);
+    uintptr_t const end = (uintptr_t) address + length;
+    if (mprotect((void *) start, end - start, PROT_READ | PROT_WRITE) != 0) {
+        fprintf(stderr, "host: mprotect failed: %d\n", errno);
+        exit(2);
+    }
+}
+
+static void save(void) {
+    char const *const path = getenv("TEZOS_HOST_NVRAM");
+    if (path == NULL) return;
+    FILE *const file = fopen(path, "wb");
+    if (file == NULL || fwrite(NVRAM_START, 1, NVRAM_SIZE, file) != NVRAM_SIZE ||
+        fclose(file) != 0) {
+        fprintf(stderr, "host: cannot write %s\n", path);
+        exit(2);
+    }
+}
+
+void host_nvram_boot(void) {
+    char const *const path = getenv("TEZOS_HOST_NVRAM");
+    if (path == NULL) return;
+    FILE *const file = fopen(path, "rb");
+    if (file == NULL) return;  // Blank NVRAM
+    unprotect(NVRAM_START, NVRAM_SIZE);
+    if (fread(NVRAM_START, 1, NVRAM_SIZE, file) != NVRAM_SIZE) {
+        fprintf(stderr, "host: %s is not an NVRAM image of %zu bytes\n", path, NVRAM_SIZE);
+        exit(2);
+    }
+    fclose(file);
+}
+
+static void write_log(void) {
+    char const *const path = getenv("TEZOS_HOST_NVRAM_LOG");
+    FILE *const file = fopen(path, "a");
+    if (file == NULL) {
+        fprintf(stderr, "host: cannot write %s\n", path);
+        _exit(2);
+    }
+    for (size_t i = 0; i < num_logged; i++) {
+        struct logged_write const *const w = &logged[i];
+        fprintf(file,
+                "%u %u %u %u %u\n",
+                w->offset,
+                w->length,
+                w->changed,
+                w->offset / HOST_NVRAM_PAGE_SIZE,
+                (w->offset + (w->length ? w->length : 1) - 1) / HOST_NVRAM_PAGE_SIZE);
+    }
+    fclose(file);
+    num_logged = 0;
+}
+
+static void log_write(size_t const offset, void const *const src, size_t const length) {
+    if (getenv("TEZOS_HOST_NVRAM_LOG") == NULL) return;
+    if (num_logged == logged_size) {
+        if (logged_size == 0) atexit(write_log);
+        logged_size = logged_size ? logged_size * 2 : 1024;
+        logged = realloc(logged, logged_size * sizeof(*logged));
+        if (logged == NULL) {
+            fprintf(stderr, "host: out of memory\n");
+            exit(2);
+        }
+    }
+    size_t changed = 0;
+    for (size_t i = 0; i < length; i++) {
+        uint8_t const byte = src == NULL ? 0 : ((uint8_t const *) src)[i];
+        if (NVRAM_START[offset + i] != byte) changed++;
+    }
+    logged[num_logged++] = (struct logged_write){offset, length, changed};
+}
+
+// Whether power is to be cut during this write, and if so after how many of its bytes.
+static bool power_cut(size_t *const bytes) {
+    char const *const cut = getenv("TEZOS_HOST_POWER_CUT");
+    unsigned long write, byte;
+    if (cut == NULL || sscanf(cut, "%lu:%lu", &write, &byte) != 2 || write != writes) return false;
+    if (byte < *bytes) *bytes = byte;
+    return true;
+}
+
+void nvm_write(void *const dst_address, void *const src_address, unsigned int const src_length) {
+    uint8_t *const dst = dst_address;
+    if (dst < NVRAM_START || dst + src_length > NVRAM_START + NVRAM_SIZE) {
+        fprintf(stderr, "host: write outside NVRAM\n");
+        exit(2);
+    }
+    writes++;
+    log_write(dst - NVRAM_START, src_address, src_length);
+
+    size_t written = src_length;
+    bool const cut = power_cut(&written);
+    unprotect(dst, src_length);
+    if (src_address == NULL) {
+        memset(dst, 0, written);
+    } else {
+        memmove(dst, src_address, written);
+    }
+    save();
+    if (cut) {
+        fprintf(stderr, "host: power cut after %zu bytes of write %lu\n", written, writes);
+        fflush(stdout);
+        if (num_logged > 0) write_log();
+        _exit(HOST_POWER_CUT_STATUS);
+    }
+}
+
+#else
+
+void host_nvram_boot(void) {
+}
+
+void nvm_write(void *const dst_address, void *const src_address, unsigned int const src_length) {
+    (void) dst_address;
+    (void) src_address;
+    (void) src_length;
+    fprintf(stderr, "host: the wallet has no NVRAM\n");
+    exit(2);
+}
+
+#endif  // #ifdef BAKING_APP
@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+"""Signs contract calls and originations, whose parameters and scripts are hashed without being
+parsed, with the host build and checks the review screens.
+
+Usage: opaque.py <path to tezos-host-wallet>
+"""
+
+import sys
+
+from batch import review
+from hostapp import call, expect, implicit, operation_group, orig, originated, public_key
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    binary = sys.argv[1]
+    key = public_key(binary)
+
+    # Large enough to span many APDUs, and not valid Michelson: it must not be looked at.
+    arguments = bytes(range(256)) * 32
+    screens = review(binary, operation_group(key, [call(0, originated(1), "transfer", arguments)]))
+    expect(screens.get("Confirm") == ["Contract Call"], "screens: %r" % screens)
+    expect(screens.get("Entrypoint") == ["transfer"], "named entrypoint")
+    expect(screens.get("Parameters") == ["8192 bytes"], "parameters: %r" % screens)
+    expect("Sign Hash" in screens, "the hash is shown")
+    print("ok: call to a named entrypoint")
+
+    screens = review(binary, operation_group(key, [call(1500000, originated(2), "default", b"")]))
+    expect(screens.get("Entrypoint") == ["default"], "standard entrypoint")
+    expect(screens.get("Amount") == ["1.5"], "amount: %r" % screens)
+    expect(screens.get("Parameters") == ["0 bytes"], "parameters: %r" % screens)
+    print("ok: call to a standard entrypoint")
+
+    code, storage = bytes(1000), bytes(50)
+    screens = review(binary, operation_group(key, [orig(2000000, code, storage)]))
+    expect(screens.get("Confirm") == ["Origination"], "screens: %r" % screens)
+    expect(screens.get("Delegate") == ["None"], "delegate: %r" % screens)
+    expect(screens.get("Script") == ["1050 bytes"], "script: %r" % screens)
+    expect("Sign Hash" in screens, "the hash is shown")
+    screens = review(binary, operation_group(key, [orig(0, code, storage, delegate=implicit(3))]))
+    expect(len(screens.get("Delegate", [])) == 1 and screens["Delegate"] != ["None"], "delegate")
+    print("ok: originations")
+
+    message = operation_group(key, [call(0, originated(1), "transfer", arguments)])
+    screens = review(binary, message[:-1])
+    expect("Unrecognized" in screens, "cut short parameters: %r" % screens)
+    screens = review(binary, operation_group(key, [call(0, originated(1), "a b", b"")]))
+    expect("Unrecognized" in screens, "entrypoint names must be printable")
+    screens = review(binary, message + b"\x00")
+    expect("Unrecognized" in screens, "nothing may follow the parameters")
+    print("ok: malformed operations are only shown as a hash")
+
+
+if __name__ == "__main__":
+    main()
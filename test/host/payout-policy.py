@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+"""Approves a payout policy with the host build and checks which operation groups are then signed
+without a prompt.
+
+Usage: payout-policy.py <path to tezos-host-wallet>
+"""
+
+import hashlib
+import sys
+
+from hostapp import (INS_SET_PAYOUT_POLICY, INS_SIGN, PATH, apdu, dlg, expect, implicit,
+                     operation_group, public_key, run, sign_apdus, tx)
+
+XTZ = 1000000
+
+
+def policy(operations, max_amount, max_total, max_fee, max_storage=257):
+    data = operations.to_bytes(4, "big")
+    for limit in (max_amount, max_total, max_fee, max_storage):
+        data += limit.to_bytes(8, "big")
+    return apdu(INS_SET_PAYOUT_POLICY, 0, data + PATH)
+
+
+def signed(key, group, response):
+    """Whether `response` is a valid signature of `group` by `key`."""
+    digest = hashlib.blake2b(group, digest_size=32).digest()
+    signature = hashlib.blake2b(key[1:33] + digest, digest_size=64).digest()
+    return response == signature + b"\x90\x00"
+
+
+def session(binary, key, commands, env=None):
+    """Sends `commands`, a list of policy APDUs and operation lists, in a single run.
+
+    Returns whether each signing request was signed, and the number of prompts shown.
+    """
+    apdus = []
+    groups = []
+    for command in commands:
+        if isinstance(command, bytes):
+            apdus.append(command)
+        else:
+            group = operation_group(key, command)
+            apdus.extend(sign_apdus(INS_SIGN, group))
+            groups.append((len(apdus) - 1, group))  # Signed in answer to the last packet
+    result = run(binary, apdus, env)
+    results = [signed(key, group, result.responses[index]) for index, group in groups]
+    return results, result.screens.count("[Review Request]")
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    binary = sys.argv[1]
+    key = public_key(binary)
+
+    # The first payout to a new account burns storage.
+    payouts = [tx(XTZ + n, implicit(n), storage_limit=257 if n == 1 else 0) for n in range(1, 4)]
+    results, prompts = session(binary, key, [
+        policy(4, 2 * XTZ, 10 * XTZ, 5000),
+        payouts,
+        [tx(XTZ, implicit(9))],
+        [tx(XTZ, implicit(9))],  # The policy is used up: prompts again
+    ])
+    expect(results == [True, True, True], "signatures: %r" % results)
+    expect(prompts == 2, "only the policy and the fifth operation are reviewed, not %d" % prompts)
+    print("ok: payouts signed within the policy")
+
+    for name, operations in [
+        ("amount", [tx(3 * XTZ, implicit(1))]),
+        ("total", [tx(2 * XTZ, implicit(n)) for n in range(1, 6)]),
+        ("fee", [tx(XTZ, implicit(1), fee=6000)]),
+        ("storage", [tx(XTZ, implicit(n), storage_limit=257) for n in (1, 2)]),
+        ("operations", [tx(1, implicit(n)) for n in range(1, 11)]),
+        ("delegation", [tx(1, implicit(1)), dlg(implicit(2))]),
+        ("contract call", [tx(1, implicit(1), parameters=True)]),
+    ]:
+        _, prompts = session(binary, key, [policy(8, 2 * XTZ, 9 * XTZ, 5000), operations])
+        expect(prompts == 2, "exceeding the %s limit prompts" % name)
+    print("ok: operations outside the policy are reviewed")
+
+    _, prompts = session(binary, key, [policy(8, 2 * XTZ, 9 * XTZ, 5000),
+                                       apdu(INS_SET_PAYOUT_POLICY, 0),
+                                       [tx(XTZ, implicit(1))]])
+    expect(prompts == 2, "a revoked policy does not sign")
+    print("ok: revoked")
+
+    results, prompts = session(binary, key, [policy(8, 2 * XTZ, 9 * XTZ, 5000),
+                                             [tx(XTZ, implicit(1))]],
+                               env={"TEZOS_HOST_PROMPT": "reject"})
+    expect(results == [False] and prompts == 2, "a rejected policy does not sign")
+    print("ok: rejected")
+
+
+if __name__ == "__main__":
+    main()
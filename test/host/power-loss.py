@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+"""Cuts power at every byte of each NVRAM write of a signature, restarts the baking app on what
+reached NVRAM, and checks that its watermarks are never below a level it signed.
+
+Usage: power-loss.py <tezos-host-baking>
+"""
+
+import os
+import random
+import shutil
+import subprocess
+import sys
+import tempfile
+
+from hostapp import INS_SIGN, P1_FIRST, P1_LAST_MARKER, P1_NEXT, PATH, apdu, expect
+
+INS_SETUP = 0x0A
+INS_QUERY_ALL_HWM = 0x0B
+INS_QUERY_AUDIT_LOG = 0x14
+POWER_CUT = 3  # Exit status of the host build when power is cut
+WRITES = 1  # NVRAM writes of a signature: its audit record
+RECORD_SIZE = 36
+
+MAIN_CHAIN = 0x7A06A770
+TEST_CHAIN = 0x3E0A5C6F
+OK = b"\x90\x00"
+REFUSED = b"\x6a\x80"
+
+
+def block(chain, level):
+    return b"\x01" + chain.to_bytes(4, "big") + level.to_bytes(4, "big") + b"\x01" + bytes(32)
+
+
+def endorsement(chain, level):
+    return b"\x02" + chain.to_bytes(4, "big") + bytes(32) + b"\x00" + level.to_bytes(4, "big")
+
+
+def sign(message):
+    return [apdu(INS_SIGN, P1_FIRST, PATH), apdu(INS_SIGN, P1_NEXT | P1_LAST_MARKER, message)]
+
+
+def setup(main, test):
+    data = MAIN_CHAIN.to_bytes(4, "big") + main.to_bytes(4, "big") + test.to_bytes(4, "big")
+    return apdu(INS_SETUP, 0, data + PATH)
+
+
+def boot(binary, image, commands, cut=None, log=None):
+    """Runs the app on the NVRAM in `image`, with power cut at (write, byte) if `cut` is given, and
+    its writes logged to `log` if given. Returns the responses it sent."""
+    env = dict(os.environ, TEZOS_HOST_NVRAM=image)
+    if log is not None:
+        env["TEZOS_HOST_NVRAM_LOG"] = log
+    if cut is not None:
+        env["TEZOS_HOST_POWER_CUT"] = "%d:%d" % cut
+    result = subprocess.run([binary], input="".join(c.hex() + "\n" for c in commands), env=env,
+                            capture_output=True, text=True)
+    expect(result.returncode == (0 if cut is None else POWER_CUT),
+           "exited with %d: %s" % (result.returncode, result.stderr))
+    return [bytes.fromhex(line) for line in result.stdout.split()]
+
+
+def watermarks(binary, image):
+    [response] = boot(binary, image, [apdu(INS_QUERY_ALL_HWM, 0)])
+    return int.from_bytes(response[0:4], "big"), int.from_bytes(response[4:8], "big")
+
+
+def audit_log(binary, image):
+    """The (chain, level) of each record the audit log lists, endorsements with the top bit set."""
+    records, first, written = [], 0, None
+    while first != written:
+        [response] = boot(binary, image, [apdu(INS_QUERY_AUDIT_LOG, 0, first.to_bytes(4, "big"))])
+        written, first = int.from_bytes(response[0:4], "big"), int.from_bytes(response[4:8], "big")
+        for i in range(8, len(response) - 2, 16):
+            records.append((int.from_bytes(response[i:i + 4], "big"),
+                            int.from_bytes(response[i + 4:i + 8], "big")))
+            first += 1
+    return records
+
+
+def writes(binary, directory, image, commands):
+    """The length of each NVRAM write `commands` make on a copy of `image`."""
+    copy, log = os.path.join(directory, "copy"), os.path.join(directory, "log")
+    shutil.copyfile(image, copy)
+    boot(binary, copy, commands, log=log)
+    with open(log) as f:
+        lengths = [int(line.split()[1]) for line in f]
+    os.remove(log)
+    return lengths
+
+
+def check_every_byte(binary, directory, name, before, signed, message, again):
+    """Signs `before` on a fresh NVRAM, then cuts power at every byte of each write of `message`.
+    After a restart, the watermarks must be at least `signed`, and `again` (signed before the
+    cut) must be refused."""
+    image = os.path.join(directory, "nvram")
+    if os.path.exists(image):
+        os.remove(image)
+    responses = boot(binary, image, before)
+    expect(all(r[-2:] == OK for r in responses), "%s: set up: %r" % (name, responses))
+    lengths = writes(binary, directory, image, sign(message))
+    cut = os.path.join(directory, "cut")
+    for write, length in enumerate(lengths, 1):
+        for byte in range(length + 1):
+            shutil.copyfile(image, cut)
+            responses = boot(binary, cut, sign(message), (write, byte))
+            where = "byte %d of write %d" % (byte, write)
+            expect(len(responses) == 1, "%s: answered after power was cut at %s" % (name, where))
+            hwm = watermarks(binary, cut)
+            expect(hwm[0] >= signed[0] and hwm[1] >= signed[1],
+                   "%s: watermarks %r after power was cut at %s, below %r" %
+                   (name, hwm, where, signed))
+            responses = boot(binary, cut, sign(again))
+            expect(responses[-1] == REFUSED, "%s: signed again after power was cut at %s: %s" %
+                   (name, where, responses[-1].hex()))
+    print("ok: %s, power cut at each byte of its writes of %s bytes" %
+          (name, "+".join(map(str, lengths))))
+
+
+def check_random_cuts(binary, directory, rounds):
+    """Bakes on both chains with power cut at a random byte of a random write now and then, and
+    restarts on what reached NVRAM each time."""
+    rng = random.Random(1)
+    image = os.path.join(directory, "nvram")
+    if os.path.exists(image):
+        os.remove(image)
+    boot(binary, image, [setup(0, 0)])
+    signed = {MAIN_CHAIN: 0, TEST_CHAIN: 0}
+    levels = {MAIN_CHAIN: 0, TEST_CHAIN: 0}
+    listed = set()  # What the audit log may list
+    cuts = 0
+    for _ in range(rounds):
+        commands, sent = [], []
+        for _ in range(rng.randint(1, 8)):
+            chain = rng.choice([MAIN_CHAIN, TEST_CHAIN])
+            levels[chain] += rng.choice([1, 1, 1, 255, 65535])
+            commands += sign(block(chain, levels[chain]))
+            sent.append((chain, levels[chain]))
+        cut = None
+        if rng.random() < 0.7:
+            cut = (rng.randint(1, WRITES * len(sent)), rng.randint(0, RECORD_SIZE))
+        responses = boot(binary, image, commands, cut)
+        cuts += cut is not None
+        for (chain, level), response in zip(sent, responses[1::2]):
+            expect(response[-2:] == OK, "refused level %d: %s" % (level, response.hex()))
+            signed[chain] = max(signed[chain], level)
+        hwm = watermarks(binary, image)
+        expect(hwm[0] >= signed[MAIN_CHAIN] and hwm[1] >= signed[TEST_CHAIN],
+               "watermarks %r below the levels signed %r" % (hwm, signed))
+        # Blocks whose signature was sent, and the one whose record was being written.
+        listed.update(sent[:len(responses) // 2 + 1])
+        unsent = [r for r in audit_log(binary, image) if r not in listed]
+        expect(not unsent, "the audit log lists blocks that were never signed: %r" % unsent)
+        levels = {MAIN_CHAIN: max(levels[MAIN_CHAIN], hwm[0]),
+                  TEST_CHAIN: max(levels[TEST_CHAIN], hwm[1])}
+    print("ok: %d restarts, %d of them after power was cut" % (rounds, cuts))
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    binary = sys.argv[1]
+
+    with tempfile.TemporaryDirectory() as directory:
+        check_every_byte(binary, directory, "a block over a carry",
+                         [setup(0, 0)] + sign(block(MAIN_CHAIN, 0xFF)), (0xFF, 0),
+                         block(MAIN_CHAIN, 0x100), block(MAIN_CHAIN, 0xFF))
+        check_every_byte(binary, directory, "an endorsement over two carries",
+                         [setup(0, 0)] + sign(endorsement(MAIN_CHAIN, 0xFFFF)), (0xFFFF, 0),
+                         endorsement(MAIN_CHAIN, 0x10000), endorsement(MAIN_CHAIN, 0xFFFF))
+        check_every_byte(binary, directory, "the endorsement of a block",
+                         [setup(0, 0)] + sign(block(MAIN_CHAIN, 7)), (7, 0),
+                         endorsement(MAIN_CHAIN, 7), block(MAIN_CHAIN, 7))
+        check_every_byte(binary, directory, "a block of the test chain",
+                         [setup(0, 0)] + sign(block(TEST_CHAIN, 0x1FF)), (0, 0x1FF),
+                         block(TEST_CHAIN, 0x200), block(TEST_CHAIN, 0x1FF))
+        check_random_cuts(binary, directory, 200)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+"""Checks what the build profiles of the Makefile leave out.
+
+Usage: profiles.py <tezos-host-wallet> <tezos-host-wallet-modern> <tezos-host-baking-ed25519>
+"""
+
+import sys
+
+from batch import review
+from hostapp import CLA, INS_GET_PUBLIC_KEY, PATH, expect, implicit, operation_group, \
+    public_key, run, source_of, tx, z
+
+TAG_ATHENS_TRANSACTION = 0x08
+
+
+def athens_tx(amount, destination):
+    """Returns an Athens transaction, whose source is a `contract` rather than a key hash."""
+    def build(key):
+        source = b"\x00" + source_of(key)
+        return (bytes([TAG_ATHENS_TRANSACTION]) + source + z(1000) + z(1) + z(10000) + z(0) +
+                z(amount) + b"\x00" + destination + b"\x00")
+    return build
+
+
+def get_public_key(binary, curve):
+    command = bytes([CLA, INS_GET_PUBLIC_KEY, 0, curve, len(PATH)]) + PATH
+    return run(binary, [command]).responses[0][-2:]
+
+
+def main():
+    if len(sys.argv) != 4:
+        sys.exit(__doc__)
+    wallet, modern, baking_ed25519 = sys.argv[1:]
+
+    key = public_key(wallet)
+    athens = operation_group(key, [athens_tx(1000000, implicit(1))])
+    babylon = operation_group(key, [tx(1000000, implicit(1))])
+    expect(review(wallet, athens).get("Confirm") == ["Transaction"], "legacy signs Athens")
+    expect("Unrecognized" in review(modern, athens), "modern leaves out Athens")
+    expect(review(modern, babylon).get("Confirm") == ["Transaction"], "modern signs Babylon")
+    print("ok: PROFILE=modern")
+
+    for curve in range(4):
+        status = get_public_key(baking_ed25519, curve)
+        expected = b"\x90\x00" if curve == 0 else b"\x6b\x00"
+        expect(status == expected, "curve %d: %s" % (curve, status.hex()))
+    print("ok: CURVES=ed25519")
+
+
+if __name__ == "__main__":
+    main()
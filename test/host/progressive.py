@@ -0,0 +1,53 @@
+#!/usr/bin/env python3
+"""Checks that the review of an operation group starts before its last packet once the screens can
+no longer change, with the host build, and that it can only be accepted once every packet is in.
+
+Usage: progressive.py <path to tezos-host-wallet>
+"""
+
+import sys
+
+from batch import review
+from hostapp import (INS_SIGN, call, expect, implicit, operation_group, originated, public_key,
+                     run, sign_apdus, tx)
+
+EXC_REJECT = b"\x69\x85"
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    binary = sys.argv[1]
+    key = public_key(binary)
+
+    message = operation_group(key, [call(0, originated(1), "transfer", bytes(4096))])
+    apdus = list(sign_apdus(INS_SIGN, message))
+    result = run(binary, apdus)
+    expect(result.responses[-1][-2:] == b"\x90\x00", "signing was refused")
+    expect(result.screens.index("[Review Started]") < result.screens.index("[Review Request]"),
+           "the review starts before the last packet: %s" % result.screens)
+    expect("Sign Hash: (receiving)" in result.screens, "the hash is not known yet")
+    screens = review(binary, message)
+    expect(screens.get("Confirm") == ["Contract Call"], "screens: %r" % screens)
+    expect(screens.get("Sign Hash") != ["(receiving)"], "the hash is shown once known")
+    print("ok: contract call reviewed while its parameters are received")
+
+    result = run(binary, apdus, env={"TEZOS_HOST_PROMPT": "reject-early"})
+    rejected = [n for n, response in enumerate(result.responses) if response == EXC_REJECT]
+    expect(len(rejected) == 1 and rejected[0] < len(apdus) - 1,
+           "the packet after an early reject is refused: %r" % result.responses)
+    expect("[Review Request]" not in result.screens, "nothing is left to accept")
+    print("ok: rejected before the last packet")
+
+    screens = review(binary, message[:-1])
+    expect("Unrecognized" in screens, "cut short parameters: %r" % screens)
+    print("ok: reviewed again when the message turns out invalid")
+
+    payouts = operation_group(key, [tx(1000000 + n, implicit(n)) for n in range(1, 51)])
+    result = run(binary, sign_apdus(INS_SIGN, payouts))
+    expect("[Review Started]" not in result.screens, "a batch may still grow")
+    print("ok: batches are reviewed once complete")
+
+
+if __name__ == "__main__":
+    main()
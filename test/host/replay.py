@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+"""Replays the consensus transcript of test/apdu-tests/ on the baking host build with
+tools/apdu-replay.py and checks its report.
+
+Usage: replay.py <tezos-host-baking>
+"""
+
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+from hostapp import INS_SIGN, expect
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..")
+REPLAY = os.path.join(ROOT, "tools", "apdu-replay.py")
+BAKING = os.path.join(ROOT, "test", "apdu-tests", "baking")
+ITERATIONS = 50
+
+
+def replay(binary, *arguments):
+    output = subprocess.run([REPLAY, "--host", binary, "--setup",
+                             os.path.join(BAKING, "authorize.apdus")] + list(arguments),
+                            capture_output=True, text=True, check=True).stdout
+    return json.loads(output)
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    binary = sys.argv[1]
+
+    report = replay(binary, "--iterations", str(ITERATIONS),
+                    os.path.join(BAKING, "consensus.apdus"))
+    expect(report["iterations"] == ITERATIONS, "iterations: %r" % report)
+    [sign] = report["instructions"]
+    expect(sign["instruction"] == "INS_SIGN" and sign["code"] == INS_SIGN, "%r" % sign)
+    expect(sign["count"] == 4 * ITERATIONS, "every APDU is measured: %r" % sign)
+    expect(sign["status_words"] == {"9000": 4 * ITERATIONS}, "at a rising level: %r" % sign)
+    [transcript] = report["transcripts"]
+    expect(transcript["count"] == ITERATIONS, "one sample per iteration: %r" % transcript)
+    for summary in (sign, transcript):
+        expect(0 < summary["p50_ms"] <= summary["p99_ms"] <= summary["max_ms"],
+               "percentiles: %r" % summary)
+    print("ok: %d levels baked and endorsed" % ITERATIONS)
+
+    with open(os.path.join(BAKING, "consensus.apdus")) as f:
+        fixed = f.read().replace("{level}", "%08x" % 7)
+    with tempfile.NamedTemporaryFile("w", suffix=".apdus") as transcript:
+        transcript.write(fixed)
+        transcript.flush()
+        report = replay(binary, "--iterations", "3", transcript.name)
+    expect(report["instructions"][0]["status_words"] == {"6a80": 4, "9000": 8},
+           "the same level again is refused: %r" % report["instructions"])
+    print("ok: status words of refusals")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,2 @@
+// The host build does not target a device.
+#pragma once
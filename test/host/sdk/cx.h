@@ -0,0 +1,102 @@
+// Host stand-in for the SDK crypto API.
+//
+// Hashing (BLAKE2b, SHA-256, SHA-512, HMAC-SHA-256) is real so that hashes and addresses computed
+// by the application can be checked against reference implementations. Key derivation and
+// signatures are NOT real: they are deterministic placeholders derived from the BIP32 path so
+// that flows can be exercised end to end. Never use this code with actual keys.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    CX_CURVE_NONE = 0,
+    CX_CURVE_SECP256K1 = 0x21,
+    CX_CURVE_SECP256R1 = 0x22,
+    CX_CURVE_Ed25519 = 0x41,
+} cx_curve_t;
+
+typedef struct {
+    cx_curve_t curve;
+    unsigned int W_len;
+    unsigned char W[65];
+} cx_ecfp_public_key_t;
+
+typedef struct {
+    cx_curve_t curve;
+    unsigned int d_len;
+    unsigned char d[32];
+} cx_ecfp_private_key_t;
+
+#define CX_NONE   0
+#define CX_SHA256 3
+#define CX_SHA512 5
+#define CX_BLAKE2B 9
+
+#define CX_LAST        (1 << 0)
+#define CX_RND_RFC6979 (3 << 9)
+
+#define CX_ECCINFO_PARITY_ODD 1
+
+#define CX_SHA256_SIZE     32
+#define CX_SHA512_SIZE     64
+#define BLAKE2B_BLOCKBYTES 128
+
+typedef struct {
+    int algo;
+} cx_hash_t;
+
+typedef struct {
+    cx_hash_t header;
+    size_t output_size;
+    uint64_t h[8];
+    uint64_t t[2];
+    uint8_t buf[BLAKE2B_BLOCKBYTES];
+    size_t buf_len;
+} cx_blake2b_t;
+
+int cx_blake2b_init(cx_blake2b_t *hash, unsigned int size_in_bits);
+int cx_hash(cx_hash_t *hash,
+            int mode,
+            const unsigned char *in,
+            unsigned int len,
+            unsigned char *out,
+            unsigned int out_len);
+
+int cx_hash_sha256(const unsigned char *in, unsigned int len, unsigned char *out, unsigned int out_len);
+int cx_hash_sha512(const unsigned char *in, unsigned int len, unsigned char *out, unsigned int out_len);
+int cx_hmac_sha256(const unsigned char *key,
+                   unsigned int key_len,
+                   const unsigned char *in,
+                   unsigned int len,
+                   unsigned char *mac,
+                   unsigned int mac_len);
+
+int cx_ecfp_init_private_key(cx_curve_t curve,
+                             const unsigned char *raw_key,
+                             unsigned int key_len,
+                             cx_ecfp_private_key_t *pvkey);
+int cx_ecfp_generate_pair(cx_curve_t curve,
+                          cx_ecfp_public_key_t *pubkey,
+                          cx_ecfp_private_key_t *privkey,
+                          int keepprivate);
+void cx_edward_compress_point(cx_curve_t curve, unsigned char *P, unsigned int P_len);
+int cx_eddsa_sign(const cx_ecfp_private_key_t *pvkey,
+                  int mode,
+                  int hashID,
+                  const unsigned char *hash,
+                  unsigned int hash_len,
+                  const unsigned char *ctx,
+                  unsigned int ctx_len,
+                  unsigned char *sig,
+                  unsigned int sig_len,
+                  unsigned int *info);
+int cx_ecdsa_sign(const cx_ecfp_private_key_t *pvkey,
+                  int mode,
+                  int hashID,
+                  const unsigned char *hash,
+                  unsigned int hash_len,
+                  unsigned char *sig,
+                  unsigned int sig_len,
+                  unsigned int *info);
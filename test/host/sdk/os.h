@@ -0,0 +1,154 @@
+// Host stand-in for the parts of the BOLOS SDK the application uses.
+//
+// Only what is needed to run the application logic on a workstation is provided. Exceptions
+// follow the SDK semantics (setjmp-based, nested contexts), I/O is routed through the host
+// transport in `host.c` and NVRAM lives in ordinary (re-mapped writable) memory.
+
+#pragma once
+
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef PRINTF
+#define PRINTF(...)
+#endif
+
+#define CX_APILEVEL        10
+#define CX_COMPAT_APILEVEL 10
+
+#define IO_APDU_BUFFER_SIZE         (5 + 255 + 4)
+#define IO_SEPROXYHAL_BUFFER_SIZE_B 128
+
+// Exceptions
+
+typedef unsigned short exception_t;
+
+typedef struct try_context_s try_context_t;
+struct try_context_s {
+    jmp_buf jmp_buf;
+    try_context_t *previous_context;
+    exception_t ex;
+};
+
+extern try_context_t *G_try_last_open_context;
+
+__attribute__((noreturn)) void os_longjmp(unsigned int exception);
+
+#define THROW(x) os_longjmp(x)
+
+#define BEGIN_TRY_L(L) \
+    {                  \
+        try_context_t __try##L;
+
+#define TRY_L(L)                                                  \
+    __try##L.previous_context = G_try_last_open_context;          \
+    __try##L.ex = (exception_t) setjmp(__try##L.jmp_buf);         \
+    if (__try##L.ex == 0) {                                       \
+        G_try_last_open_context = &__try##L;
+
+#define CATCH_L(L, x)                                           \
+    goto __FINALLY##L;                                          \
+    }                                                           \
+    else if (__try##L.ex == (x)) {                              \
+        __try##L.ex = 0;                                        \
+        G_try_last_open_context = __try##L.previous_context;
+
+#define CATCH_OTHER_L(L, e)                                     \
+    goto __FINALLY##L;                                          \
+    }                                                           \
+    else {                                                      \
+        exception_t e = __try##L.ex;                            \
+        __try##L.ex = 0;                                        \
+        G_try_last_open_context = __try##L.previous_context;
+
+#define FINALLY_L(L)                                            \
+    goto __FINALLY##L;                                          \
+    }                                                           \
+    __FINALLY##L:                                               \
+    if (G_try_last_open_context == &__try##L) {                 \
+        G_try_last_open_context = __try##L.previous_context;    \
+    }
+
+#define END_TRY_L(L)                                            \
+    if (__try##L.ex != 0) {                                     \
+        THROW(__try##L.ex);                                     \
+    }                                                           \
+    }
+
+#define BEGIN_TRY          BEGIN_TRY_L(_)
+#define TRY                TRY_L(_)
+#define CATCH(x)           CATCH_L(_, x)
+#define CATCH_OTHER(e)     CATCH_OTHER_L(_, e)
+#define FINALLY            FINALLY_L(_)
+#define END_TRY            END_TRY_L(_)
+
+#define EXCEPTION          1
+#define INVALID_PARAMETER  2
+#define EXCEPTION_IO_RESET 0x10
+
+// Code and data are not relocated on the host.
+#define PIC(x) (x)
+unsigned int pic(unsigned int linked_address);
+
+// I/O
+
+extern unsigned char G_io_apdu_buffer[IO_APDU_BUFFER_SIZE];
+
+#define IO_APDU_MEDIA_NONE    0
+#define IO_APDU_MEDIA_USB_HID 1
+#define IO_APDU_MEDIA_U2F     2
+extern unsigned int G_io_apdu_media;
+
+#define CHANNEL_APDU           0
+#define CHANNEL_KEYBOARD       1
+#define CHANNEL_SPI            2
+#define IO_RESET_AFTER_REPLIED 0x80
+#define IO_RETURN_AFTER_TX     0x20
+#define IO_ASYNCH_REPLY        0x10
+#define IO_FLAGS               0xF0
+
+unsigned short io_exchange(unsigned char channel_and_flags, unsigned short tx_len);
+void io_seproxyhal_spi_send(const unsigned char *buffer, unsigned short length);
+unsigned short io_seproxyhal_spi_recv(unsigned char *buffer,
+                                      unsigned short max_length,
+                                      unsigned int flags);
+void reset(void);
+
+// System
+
+typedef struct {
+    unsigned int ux_id;
+} bolos_ux_params_t;
+
+#define BOLOS_UX_VALIDATE_PIN 1
+
+void os_boot(void);
+__attribute__((noreturn)) void os_sched_exit(int exit_code);
+void os_ux_blocking(bolos_ux_params_t *params);
+void check_api_level(unsigned int api_level);
+void os_lib_end(void);
+void explicit_bzero(void *s, size_t len);
+
+void nvm_write(void *dst_address, void *src_address, unsigned int src_length);
+
+#define HDW_NORMAL         0
+#define HDW_ED25519_SLIP10 1
+
+#include "cx.h"
+
+void os_perso_derive_node_bip32(cx_curve_t curve,
+                                const unsigned int *path,
+                                unsigned int path_length,
+                                unsigned char *private_key,
+                                unsigned char *chain);
+void os_perso_derive_node_bip32_seed_key(unsigned int mode,
+                                         cx_curve_t curve,
+                                         const unsigned int *path,
+                                         unsigned int path_length,
+                                         unsigned char *private_key,
+                                         unsigned char *chain,
+                                         unsigned char *seed_key,
+                                         unsigned int seed_key_length);
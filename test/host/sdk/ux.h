@@ -0,0 +1,20 @@
+// Host stand-in for the SDK UX definitions. The host build has no screen; see `ui_host.c`.
+
+#pragma once
+
+#include "os.h"
+
+typedef struct {
+    int unused;
+} bagl_element_t;
+
+typedef struct {
+    unsigned int stack_count;
+} ux_state_t;
+
+extern ux_state_t G_ux;
+extern bolos_ux_params_t G_ux_params;
+
+#define UX_INIT()
+
+void io_seproxyhal_display_default(bagl_element_t *element);
@@ -0,0 +1,260 @@
+#!/usr/bin/env python3
+"""Bakes for a long time: drives a stream of block headers and endorsements through INS_SIGN of
+the baking app and checks every answer against a model of the high watermarks.
+
+Usage: soak.py (--host BINARY | --tcp HOST:PORT) [--levels N] [--seed N]
+
+The stream rises on the main chain with gaps between levels now and then, interleaves a test
+chain, and mixes in what the app has to refuse: the same block or endorsement again, a block
+after the endorsement of its level, stale levels and levels out of range. Every signature is
+checked against the public key INS_SETUP returned, and the watermarks INS_QUERY_ALL_HWM returns
+after each request against the model: they never go down. At the end, the counters of
+INS_QUERY_STATUS must account for every signature, refusal and NVRAM write, the audit log of
+tools/audit-log.py must end with the last signatures, and the stack high-water of INS_SIGN is
+reported when the build has STACK_TELEMETRY=1.
+
+On the host build, every NVRAM write is logged (see nvm.c) and projected to a day of baking, a
+level every --block-time seconds, each signed as often as in the soak: the bytes written, and how
+soon the most programmed flash page reaches --endurance program cycles.
+
+--host runs the host build of this directory; --tcp talks to an emulator's APDU port (see
+tools/apdu-replay.py), whose automation rules have to accept the setup prompt.
+"""
+
+import argparse
+import collections
+import hashlib
+import importlib.util
+import os
+import random
+import tempfile
+import time
+
+from hostapp import INS_SIGN, P1_FIRST, P1_LAST_MARKER, P1_NEXT, PATH, apdu, expect
+
+INS_SETUP = 0x0A
+INS_QUERY_ALL_HWM = 0x0B
+INS_QUERY_STACK = 0x11
+INS_QUERY_STATUS = 0x12
+
+MAGIC_BYTE_BLOCK = 0x01
+MAGIC_BYTE_BAKING_OP = 0x02
+MAIN_CHAIN = 0x7A06A770  # NetXdQprcVkpaWU
+TEST_CHAIN = 0x3E0A5C6F
+MAX_LEVEL = 0x3FFFFFFF
+AUDIT_RECORDS = 32
+
+OK = b"\x90\x00"
+REFUSED = b"\x6a\x80"  # EXC_WRONG_VALUES
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def tool(name):
+    """The module of tools/`name`.py."""
+    spec = importlib.util.spec_from_file_location(
+        name.replace("-", "_"), os.path.join(HERE, "..", "..", "tools", name + ".py"))
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+
+def block(chain, level):
+    return bytes([MAGIC_BYTE_BLOCK]) + chain.to_bytes(4, "big") + level.to_bytes(4, "big") + \
+        b"\x01" + bytes(32)
+
+
+def endorsement(chain, level):
+    return bytes([MAGIC_BYTE_BAKING_OP]) + chain.to_bytes(4, "big") + bytes(32) + b"\x00" + \
+        level.to_bytes(4, "big")
+
+
+class Watermark:
+    """The model of one high watermark, as baking_auth.c keeps it."""
+
+    def __init__(self):
+        self.level = 0
+        self.had_endorsement = False
+
+    def sign(self, level, is_endorsement):
+        """Returns whether the app must sign, and moves the watermark if so."""
+        if level > MAX_LEVEL:
+            return False
+        if not (level > self.level or
+                (level == self.level and is_endorsement and not self.had_endorsement)):
+            return False
+        self.level = level
+        self.had_endorsement = is_endorsement
+        return True
+
+
+class Chain:
+    def __init__(self, chain_id):
+        self.chain_id = chain_id
+        self.level = 0
+        self.watermark = Watermark()
+
+
+def requests(rng, chain):
+    """Yields the (is_endorsement, level) of what is sent to the app for the next level of
+    `chain`."""
+    gap = rng.choices([1, rng.randint(2, 5), rng.randint(10, 1000)], [90, 9, 1])[0]
+    chain.level += gap
+    level = chain.level
+    order = rng.choices([[False, True], [True], [True, False]], [90, 5, 5])[0]
+    for is_endorsement in order:
+        yield is_endorsement, level
+    draw = rng.random()
+    if draw < 0.03:
+        yield order[-1], level  # The same again
+    elif draw < 0.05:
+        yield rng.random() < 0.5, max(1, level - rng.randint(1, 100))  # Stale
+    elif draw < 0.06:
+        yield rng.random() < 0.5, level | 0x40000000  # Out of range
+
+
+class Soak:
+    def __init__(self, transport):
+        self.transport = transport
+        self.apdus = 0
+        self.signed = {MAGIC_BYTE_BLOCK: 0, MAGIC_BYTE_BAKING_OP: 0}
+        self.records = collections.deque(maxlen=AUDIT_RECORDS - 1)  # As tools/audit-log.py has them
+        self.refused = 0
+        self.hwm = (0, 0)
+
+    def exchange(self, command):
+        self.apdus += 1
+        return self.transport.exchange(command)
+
+    def setup(self):
+        data = MAIN_CHAIN.to_bytes(4, "big") + bytes(8) + PATH
+        response = self.exchange(apdu(INS_SETUP, 0, data))
+        expect(response[-2:] == OK, "setup refused: %s" % response.hex())
+        self.key = response[1:-2]
+
+    def sign(self, chain, is_endorsement, level):
+        message = (endorsement if is_endorsement else block)(chain.chain_id, level)
+        expected = chain.watermark.sign(level, is_endorsement)
+        first = self.exchange(apdu(INS_SIGN, P1_FIRST, PATH))
+        expect(first[-2:] == OK, "path refused: %s" % first.hex())
+        response = self.exchange(apdu(INS_SIGN, P1_NEXT | P1_LAST_MARKER, message))
+        what = "%s at level %d of chain %08x" % (
+            "endorsement" if is_endorsement else "block", level, chain.chain_id)
+        if not expected:
+            expect(response == REFUSED, "%s signed: %s" % (what, response.hex()))
+            self.refused += 1
+            return
+        expect(response[-2:] == OK, "%s refused: %s" % (what, response.hex()))
+        # Host-build signatures are BLAKE2b-512 over the public key body and the signed hash.
+        digest = hashlib.blake2b(message, digest_size=32).digest()
+        signature = hashlib.blake2b(self.key[1:33] + digest, digest_size=64).digest()
+        expect(response[:-2] == signature, "%s: wrong signature" % what)
+        self.signed[message[0]] += 1
+        self.records.append({"chain": "0x%08x" % chain.chain_id, "level": level,
+                             "kind": "endorsement" if is_endorsement else "block",
+                             "hash": digest[:8].hex()})
+
+    def check_watermarks(self, main, test):
+        response = self.exchange(apdu(INS_QUERY_ALL_HWM, 0))
+        expect(response[-2:] == OK and len(response) == 14, "HWM query: %s" % response.hex())
+        hwm = (int.from_bytes(response[0:4], "big"), int.from_bytes(response[4:8], "big"))
+        expect(hwm[0] >= self.hwm[0] and hwm[1] >= self.hwm[1],
+               "a watermark went down: %r, then %r" % (self.hwm, hwm))
+        expect(hwm == (main.watermark.level, test.watermark.level),
+               "watermarks %r, expected %r" % (hwm, (main.watermark.level, test.watermark.level)))
+        self.hwm = hwm
+
+    def counters(self):
+        response = self.exchange(apdu(INS_QUERY_STATUS, 0))
+        expect(response[-2:] == OK, "status query refused: %s" % response.hex())
+        words = [int.from_bytes(response[i:i + 4], "big") for i in range(0, 13 * 4, 4)]
+        return {"apdus": words[0], "signatures": words[1:7], "hwm_rejections": words[7],
+                "nvram_writes": words[11], "nvram_bytes": words[12]}
+
+    def stack(self):
+        """Returns the peak stack of INS_SIGN and the size of the stack, or None."""
+        response = self.exchange(apdu(INS_QUERY_STACK, 0))
+        if response[-2:] != OK:
+            return None
+        numbers = [int.from_bytes(response[i:i + 2], "big") for i in range(0, len(response) - 2, 2)]
+        return numbers[1 + INS_SIGN], numbers[0]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    target = parser.add_mutually_exclusive_group(required=True)
+    target.add_argument("--host")
+    target.add_argument("--tcp")
+    parser.add_argument("--levels", type=int, default=100000)
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--block-time", type=int, default=30)
+    parser.add_argument("--endurance", type=int, default=100000)
+    args = parser.parse_args()
+
+    log = tempfile.NamedTemporaryFile(suffix=".log")
+    if args.host:
+        os.environ["TEZOS_HOST_NVRAM_LOG"] = log.name
+    replay = tool("apdu-replay")
+    soak = Soak(replay.Host(args.host) if args.host else replay.Tcp(args.tcp))
+    rng = random.Random(args.seed)
+    main_chain, test_chain = Chain(MAIN_CHAIN), Chain(TEST_CHAIN)
+
+    started = time.monotonic()
+    soak.setup()
+    for _ in range(args.levels):
+        chains = [main_chain] + ([test_chain] if rng.random() < 0.1 else [])
+        for chain in chains:
+            for is_endorsement, level in requests(rng, chain):
+                soak.sign(chain, is_endorsement, level)
+                soak.check_watermarks(main_chain, test_chain)
+    elapsed = time.monotonic() - started
+
+    counters = soak.counters()
+    signatures = sum(soak.signed.values())
+    expect(counters["apdus"] == soak.apdus, "APDUs: %r" % counters)
+    expect(counters["signatures"][MAGIC_BYTE_BLOCK] == soak.signed[MAGIC_BYTE_BLOCK] and
+           counters["signatures"][MAGIC_BYTE_BAKING_OP] == soak.signed[MAGIC_BYTE_BAKING_OP],
+           "signatures: %r, expected %r" % (counters["signatures"], soak.signed))
+    expect(counters["hwm_rejections"] == soak.refused, "refusals: %r" % counters)
+    # One write for the setup, then the audit record of each signature.
+    expect(counters["nvram_writes"] == 1 + signatures, "NVRAM writes: %r" % counters)
+    records = [r for r in tool("audit-log").read(soak.transport) if "lost" not in r]
+    last = [{k: v for k, v in r.items() if k != "record"} for r in records[-AUDIT_RECORDS:]]
+    expect(last[len(last) - len(soak.records):] == list(soak.records),
+           "audit log %r, expected %r" % (last, list(soak.records)))
+    peak = soak.stack()
+    soak.transport.close()
+
+    print("ok: %d levels in %.1f s: %d blocks and %d endorsements signed (%.0f per second), "
+          "%d refused" % (args.levels, elapsed, soak.signed[MAGIC_BYTE_BLOCK],
+                          soak.signed[MAGIC_BYTE_BAKING_OP], signatures / elapsed, soak.refused))
+    print("    watermarks: main chain %d, test chain %d, never lower than before" % soak.hwm)
+    print("    NVRAM: %d writes, %d bytes" % (counters["nvram_writes"], counters["nvram_bytes"]))
+    if peak is not None:
+        print("    stack: %d bytes at most when signing, out of %d" % peak)
+    if args.host:
+        project(log.name, args)
+
+
+def project(log, args):
+    """Prints the NVRAM writes of a day of baking, from the writes logged during the soak."""
+    with open(log) as f:
+        writes = [list(map(int, line.split())) for line in f][1:]  # Without the setup
+    if not writes:
+        return
+    programs = {}
+    for _, _, _, first, last in writes:
+        for page in range(first, last + 1):
+            programs[page] = programs.get(page, 0) + 1
+    scale = 24 * 3600 / args.block_time / args.levels  # Soaked levels to a day of them
+    page, most = max(programs.items(), key=lambda item: item[1])
+    print("    a day at a level every %d s: %.0f NVRAM writes of %.0f bytes, %.0f of them changed" %
+          (args.block_time, len(writes) * scale, sum(w[1] for w in writes) * scale,
+           sum(w[2] for w in writes) * scale))
+    print("    flash page %d programmed %.0f times a day: %d cycles last %.0f days" %
+          (page, most * scale, args.endurance, args.endurance / (most * scale)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+"""Checks the stack telemetry of a build with STACK_TELEMETRY=1: the peak stack of each
+instruction, as INS_QUERY_STACK returns it.
+
+Usage: stack.py <tezos-host-wallet-stack> <tezos-host-wallet>
+"""
+
+import sys
+
+from hostapp import INS_GET_PUBLIC_KEY, INS_SIGN, PATH, apdu, expect, implicit, operation_group, \
+    public_key, run, sign_apdus, tx
+
+INS_VERSION = 0x00
+INS_QUERY_STACK = 0x11
+INS_MAX = 0x1F
+
+QUERY = apdu(INS_QUERY_STACK, 0)
+
+
+def peaks(response):
+    """Returns the size of the stack and the peak of each instruction code."""
+    expect(response[-2:] == b"\x90\x00", "query refused: %s" % response.hex())
+    numbers = [int.from_bytes(response[i:i + 2], "big") for i in range(0, len(response) - 2, 2)]
+    expect(len(numbers) == INS_MAX + 2, "%d numbers" % len(numbers))
+    return numbers[0], numbers[1:]
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    binary, plain = sys.argv[1:]
+
+    size, fresh = peaks(run(binary, [QUERY]).responses[0])
+    expect(size > 0 and not any(fresh), "nothing recorded at boot: %d %r" % (size, fresh))
+
+    message = operation_group(public_key(binary), [tx(1000000, implicit(1))])
+    session = list(sign_apdus(INS_SIGN, message, size=40))
+    commands = [apdu(INS_VERSION, 0), apdu(INS_GET_PUBLIC_KEY, 0, PATH)]
+    # Queried in the middle of the session, which goes on.
+    commands += session[:2] + [QUERY] + session[2:] + [QUERY]
+    result = run(binary, commands)
+    expect(result.responses[-2][-2:] == b"\x90\x00", "signing was refused")
+
+    _, during = peaks(result.responses[4])
+    size, after = peaks(result.responses[-1])
+    expect(0 < after[INS_VERSION] < after[INS_GET_PUBLIC_KEY] < after[INS_SIGN] < size,
+           "peaks: %r of %d" % (after[:INS_MAX + 1], size))
+    expect(0 < during[INS_SIGN] <= after[INS_SIGN], "the signature is the deepest part")
+    expect(after[INS_QUERY_STACK] > 0, "queries are recorded too")
+    expect(not any(after[INS_QUERY_STACK + 1:]), "only instructions that were sent")
+    print("ok: peak stack of %d bytes out of %d when signing" % (after[INS_SIGN], size))
+
+    status = run(plain, [QUERY]).responses[0]
+    expect(status == b"\x6d\x00", "left out of other builds: %s" % status.hex())
+    print("ok: only with STACK_TELEMETRY=1")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Checks the counters INS_QUERY_STATUS returns, in the wallet and the baking app.
+
+Usage: status.py <tezos-host-wallet> <tezos-host-baking>
+"""
+
+import sys
+
+from hostapp import INS_AUTHORIZE_BAKING, INS_GET_PUBLIC_KEY, INS_SIGN, PATH, apdu, expect, \
+    implicit, operation_group, public_key, run, sign_apdus, tx
+
+INS_QUERY_STATUS = 0x12
+
+QUERY = apdu(INS_QUERY_STATUS, 0)
+PHASES = ["derivation", "hashing", "signing", "nvram", "ui"]
+REJECTIONS = ["hwm", "path", "parse", "user"]
+COUNTERS_SIZE = 4 * (1 + 6 + len(REJECTIONS) + 2 + 3 * len(PHASES))
+N_DATA_SIZE = 88  # Without the audit records
+SIGNATURE_BYTES = 36  # An audit record, with the watermarks it raises
+
+OTHER_PATH = bytes.fromhex("048000002c800006c18000000180000000")  # 44'/1729'/1'/0'
+
+
+def words(data):
+    return [int.from_bytes(data[i:i + 4], "big") for i in range(0, len(data), 4)]
+
+
+def status(response):
+    """Returns the counters as a dict, and what follows them."""
+    expect(response[-2:] == b"\x90\x00", "query refused: %s" % response.hex())
+    numbers = words(response[:COUNTERS_SIZE])
+    counters = {"apdus": numbers[0], "signatures": numbers[1:7],
+                "rejections": dict(zip(REJECTIONS, numbers[7:11])),
+                "nvram_writes": numbers[11], "nvram_bytes": numbers[12]}
+    for i, phase in enumerate(PHASES):
+        count, total, most = numbers[13 + 3 * i:16 + 3 * i]
+        expect(most <= total, "%s: the longest is part of the total" % phase)
+        counters[phase] = count
+    return counters, response[COUNTERS_SIZE:-2]
+
+
+def block(level):
+    return b"\x01" + bytes(4) + level.to_bytes(4, "big") + b"\x01" + bytes(32)
+
+
+def check_wallet(binary):
+    counters, rest = status(run(binary, [QUERY]).responses[0])
+    expect(counters["apdus"] == 1 and not any(counters["signatures"]) and rest == b"",
+           "fresh: %r %s" % (counters, rest.hex()))
+
+    message = operation_group(public_key(binary), [tx(1000000, implicit(1))])
+    session = list(sign_apdus(INS_SIGN, message, size=40))
+    # Queried in the middle of the session, which goes on.
+    commands = [apdu(INS_GET_PUBLIC_KEY, 0, PATH)] + session[:2] + [QUERY] + session[2:] + [QUERY]
+    result = run(binary, commands)
+    expect(result.responses[-2][-2:] == b"\x90\x00", "signing was refused")
+
+    counters, _ = status(result.responses[-1])
+    expect(counters["apdus"] == len(commands), "apdus: %r" % counters)
+    expect(counters["signatures"] == [0, 0, 0, 1, 0, 0], "by magic byte: %r" % counters)
+    expect(counters["derivation"] == 2, "the public key is cached, the key pair is not")
+    expect(counters["hashing"] == len(session), "every packet is hashed, then the hash finished")
+    expect(counters["signing"] == 1 and counters["ui"] == 1, "one prompt: %r" % counters)
+    expect(counters["nvram_writes"] == 0 and not any(counters["rejections"].values()),
+           "nothing else: %r" % counters)
+    print("ok: counters of a signature")
+
+    result = run(binary, session + [QUERY], env={"TEZOS_HOST_PROMPT": "reject"})
+    counters, _ = status(result.responses[-1])
+    expect(counters["rejections"]["user"] == 1 and counters["ui"] == 1,
+           "rejected: %r" % counters)
+    expect(not any(counters["signatures"]), "nothing signed: %r" % counters)
+    print("ok: rejected by the user")
+
+
+def check_baking(binary):
+    payout = operation_group(public_key(binary), [tx(1000000, implicit(1))])
+    steps = [
+        [apdu(INS_AUTHORIZE_BAKING, 0, PATH)],
+        sign_apdus(INS_SIGN, block(10)),
+        sign_apdus(INS_SIGN, block(10)),
+        sign_apdus(INS_SIGN, block(11), path=OTHER_PATH),
+        sign_apdus(INS_SIGN, payout),
+        [QUERY],
+    ]
+    result = run(binary, [command for step in steps for command in step])
+    counters, rest = status(result.responses[-1])
+    expect(counters["signatures"] == [0, 1, 0, 0, 0, 0], "one block: %r" % counters)
+    expect(counters["rejections"] == {"hwm": 1, "path": 1, "parse": 1, "user": 0},
+           "rejections: %r" % counters["rejections"])
+    expect(counters["nvram_writes"] == 2 and counters["nvram"] == 2,
+           "authorizing, then the block: %r" % counters)
+    expect(counters["nvram_bytes"] == N_DATA_SIZE + SIGNATURE_BYTES,
+           "all of N_data to authorize, a record for the block: %r" % counters)
+
+    chain, main, main_endorsed, test, test_endorsed = words(rest[:4]) + words(rest[4:8]) + \
+        [rest[8]] + words(rest[9:13]) + [rest[13]]
+    expect((chain, main, main_endorsed, test, test_endorsed) == (0, 10, 0, 0, 0),
+           "watermarks: %s" % rest.hex())
+    expect(rest[14:] == b"\x00" + PATH, "the authorized key: %s" % rest[14:].hex())
+    print("ok: counters and watermarks of the baking app")
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    check_wallet(sys.argv[1])
+    check_baking(sys.argv[2])
+
+
+if __name__ == "__main__":
+    main()
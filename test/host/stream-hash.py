@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""Streams multi-megabyte Michelson (0x05) payloads through the signing instructions of the host
+build and checks the result against hashlib's BLAKE2b.
+
+Also checks that memory use does not depend on the length of the input: the peak RSS of a run
+streaming the largest payload must stay within a small margin of a run streaming a tiny one.
+
+Usage: stream-hash.py <path to tezos-host-wallet>
+"""
+
+import hashlib
+import itertools
+import os
+import sys
+
+from hostapp import (INS_GET_PUBLIC_KEY, INS_SIGN, INS_SIGN_WITH_HASH, MAX_APDU_SIZE,
+                     P1_FIRST, P1_HASH_ONLY_NEXT, P1_LAST_MARKER, P1_NEXT, PATH, apdu, expect, run)
+
+RSS_MARGIN_KB = 1024
+
+
+def sign_session(ins, p1_next, size, hasher):
+    """Yields the APDUs signing `size` bytes of random Michelson, feeding them to `hasher`.
+
+    The payload is generated packet by packet so that this script's own memory use, which the
+    host build inherits until it execs, does not depend on `size`.
+    """
+    yield apdu(ins, P1_FIRST, PATH)
+    for offset in range(0, size, MAX_APDU_SIZE):
+        chunk = os.urandom(min(MAX_APDU_SIZE, size - offset))
+        if offset == 0:
+            chunk = b"\x05" + chunk[1:]
+        hasher.update(chunk)
+        last = offset + MAX_APDU_SIZE >= size
+        yield apdu(ins, p1_next | (P1_LAST_MARKER if last else 0), chunk)
+
+
+def check_hash_only(binary, size):
+    hasher = hashlib.blake2b(digest_size=32)
+    result = run(binary, sign_session(INS_SIGN, P1_HASH_ONLY_NEXT, size, hasher))
+    responses = result.responses
+    packets = len(responses) - 1
+    expect(all(r[-2:] == b"\x90\x00" for r in responses), "a packet was refused")
+    expected = hasher.digest()
+    expect(responses[-1][:-2] == expected, "hash of %d bytes does not match" % size)
+    print("ok: hash-only, %d bytes in %d packets" % (size, packets))
+    return result.max_rss
+
+
+def check_signature(binary, size):
+    hasher = hashlib.blake2b(digest_size=32)
+    session = sign_session(INS_SIGN_WITH_HASH, P1_NEXT, size, hasher)
+    responses = run(binary, itertools.chain([apdu(INS_GET_PUBLIC_KEY, 0, PATH)], session)).responses
+    key = responses[0][1:-2]
+    reply = responses[-1][:-2]
+    expected = hasher.digest()
+    expect(reply[:32] == expected, "hash of %d bytes does not match" % size)
+    # Host-build signatures are BLAKE2b-512 over the public key body and the signed hash.
+    signature = hashlib.blake2b(key[1:33] + expected, digest_size=64).digest()
+    expect(reply[32:] == signature, "signature does not cover the expected hash")
+    print("ok: sign with hash, %d bytes" % size)
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    binary = sys.argv[1]
+
+    baseline_rss = check_hash_only(binary, 1000)
+    check_hash_only(binary, 255 * MAX_APDU_SIZE + 1)  # One packet past the old limit
+    largest_rss = check_hash_only(binary, 8 * 1024 * 1024)
+    check_signature(binary, 3 * 1024 * 1024 + 17)
+
+    expect(largest_rss - baseline_rss < RSS_MARGIN_KB,
+           "peak RSS grew from %d KB to %d KB" % (baseline_rss, largest_rss))
+    print("ok: peak RSS %d KB for 8 MB, %d KB for 1 KB" % (largest_rss, baseline_rss))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""Drains the trace of the baking host build with INS_DRAIN_TRACE and checks the timeline
+tools/trace-decode.py makes of it.
+
+Usage: trace.py <tezos-host-baking>
+"""
+
+import os
+import subprocess
+import sys
+
+from hostapp import INS_AUTHORIZE_BAKING, INS_SIGN, PATH, apdu, expect, run, sign_apdus
+
+INS_VERSION = 0x00
+INS_DRAIN_TRACE = 0x13
+TRACE_RECORDS = 16
+
+DRAIN = apdu(INS_DRAIN_TRACE, 0)
+DECODER = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "tools",
+                       "trace-decode.py")
+
+
+def block(level):
+    return b"\x01" + bytes(4) + level.to_bytes(4, "big") + b"\x01" + bytes(32)
+
+
+def timeline(responses):
+    """Returns the lines of the timeline of the drained `responses`, as lists of columns."""
+    output = subprocess.run([DECODER], input="".join(r.hex() + "\n" for r in responses),
+                            capture_output=True, text=True, check=True).stdout
+    return [line.split() for line in output.splitlines()[1:]]
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    binary = sys.argv[1]
+
+    commands = [apdu(INS_AUTHORIZE_BAKING, 0, PATH)] + list(sign_apdus(INS_SIGN, block(10)))
+    commands += list(sign_apdus(INS_SIGN, block(10))) + [DRAIN, DRAIN]
+    result = run(binary, commands)
+    lines = timeline(result.responses[-2:])
+    expect([line[5] for line in lines] == [
+        "APDU", "PROMPT", "HANDLED",  # Authorizing, once the user accepts
+        "APDU", "HANDLED", "APDU", "HWM", "SIGNED", "HANDLED",  # Baking
+        "APDU", "HANDLED", "APDU", "ERROR",  # Baking at the same level again
+        "APDU", "HANDLED", "APDU",  # Both drains
+    ], "timeline:\n%s" % "\n".join(map(" ".join, lines)))
+    expect([int(line[0]) for line in lines] == list(range(16)), "numbered from the start")
+    expect(lines[3][3:5] == ["INS_SIGN", "(0x04)"], "tagged with the instruction: %r" % lines[3])
+    expect(lines[6][7:] == ["level", "10"], "the watermark: %r" % lines[6])
+    expect(lines[7][7:] == ["magic", "byte", "1,", "64-byte", "signature"], "%r" % lines[7])
+    expect(lines[12][7:] == ["0x6a80"], "refused below the watermark: %r" % lines[12])
+    print("ok: baking and a refusal")
+
+    result = run(binary, [apdu(INS_VERSION, 0)] * TRACE_RECORDS + [DRAIN])
+    lines = timeline(result.responses[-1:])
+    expect(lines[0] == ["...", str(TRACE_RECORDS + 1), "records", "lost"], "lost: %r" % lines[0])
+    expect(len(lines) == TRACE_RECORDS + 1, "the ring is full: %d" % len(lines))
+    print("ok: records that were overwritten")
+
+    garbage = b"\x03" + bytes(32) + b"\xff"
+    result = run(binary, list(sign_apdus(INS_SIGN, garbage)) + [DRAIN])
+    lines = timeline(result.responses[-1:])
+    names = [line[5] for line in lines]
+    expect(names[3:7] == ["OPERATION_ERROR", "PARSE_ERROR", "ERROR", "APDU"],
+           "parse errors: %r" % names)
+    expect(lines[3][7].startswith("operations.c:") and lines[4][7].startswith("apdu_sign.c:"),
+           "where: %r" % lines[3:5])
+    print("ok: parse errors")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,109 @@
+// Host replacement for `ui_nano_x.c`: screens are printed to stderr and prompts are answered by
+// `host_answer_prompt`, called from the host transport.
+
+#include "ui.h"
+
+#include "apdu_status.h"
+#include "globals.h"
+#include "to_string.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define G_display global.dynamic_display
+
+void host_answer_prompt(void);
+
+// Screens go to stderr, except in the fuzz targets (see fuzz.c): formatting them is enough there.
+#ifdef HOST_FUZZ
+#define print(...) ((void) 0)
+#else
+#define print(...) fprintf(stderr, __VA_ARGS__)
+#endif
+
+void io_seproxyhal_display_default(bagl_element_t *const element) {
+    (void) element;
+}
+
+void ui_refresh(void) {
+}
+
+static void print_screens(char const *const heading) {
+    print("[%s]\n", heading);
+    for (size_t i = 0; i < G_display.screen_stack_size; i++) {
+        struct screen_data const *const fmt = &G_display.screen_stack[i];
+        G_display.formatter_index = i;
+        explicit_bzero(&G_display.screen_value, sizeof(G_display.screen_value));
+        fmt->callback_fn(G_display.screen_value, sizeof(G_display.screen_value), fmt->data);
+        print("  %s: %s\n", fmt->title, G_display.screen_value);
+    }
+    G_display.formatter_index = 0;
+}
+
+static void ux_prepare_display(ui_callback_t ok_c, ui_callback_t cxl_c) {
+    G_display.screen_stack_size = G_display.formatter_index;
+    G_display.formatter_index = 0;
+    G_display.current_state = STATIC_SCREEN;
+
+    if (ok_c) G_display.ok_callback = ok_c;
+    if (cxl_c) G_display.cxl_callback = cxl_c;
+    G_display.receiving = false;
+}
+
+void ui_initial_screen(void) {
+    init_screen_stack();
+#ifdef BAKING_APP
+    calculate_baking_idle_screens_data();
+#else
+    calculate_wallet_idle_screens_data();
+#endif
+
+    ux_idle_screen(NULL, NULL);
+}
+
+void ux_confirm_screen(ui_callback_t ok_c, ui_callback_t cxl_c) {
+    ux_prepare_display(ok_c, cxl_c);
+    status_prompt_shown();
+    print_screens("Review Request");
+    THROW(ASYNC_EXCEPTION);
+}
+
+// With `TEZOS_HOST_PROMPT=reject-early`, the review is rejected as soon as it is shown, before
+// the rest of the message is received.
+void ux_review_screen(ui_callback_t cxl_c) {
+    ux_prepare_display(NULL, cxl_c);
+    G_display.receiving = true;
+    status_prompt_shown();
+    print_screens("Review Started");
+
+    char const *const answer = getenv("TEZOS_HOST_PROMPT");
+    if (answer != NULL && strcmp(answer, "reject-early") == 0) {
+        print("[Reject]\n");
+        status_prompt_answered(false);
+        ui_initial_screen();
+        G_display.cxl_callback();
+    }
+}
+
+void ux_review_ready(ui_callback_t ok_c, ui_callback_t cxl_c) {
+    G_display.ok_callback = ok_c;
+    G_display.cxl_callback = cxl_c;
+    G_display.receiving = false;
+    print_screens("Review Request");
+    THROW(ASYNC_EXCEPTION);
+}
+
+void ux_idle_screen(ui_callback_t ok_c, ui_callback_t cxl_c) {
+    ux_prepare_display(ok_c, cxl_c);
+}
+
+void host_answer_prompt(void) {
+    char const *const answer = getenv("TEZOS_HOST_PROMPT");
+    bool const accepted = answer == NULL || strcmp(answer, "reject") != 0;
+    print("[%s]\n", accepted ? "Accept" : "Reject");
+    status_prompt_answered(accepted);
+
+    ui_callback_t const cb = accepted ? G_display.ok_callback : G_display.cxl_callback;
+    ui_initial_screen();
+    cb();
+}
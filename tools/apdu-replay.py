@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""Replays APDU transcripts many times and measures how long each APDU takes, end to end.
+
+Usage: apdu-replay.py (--host BINARY | --tcp HOST:PORT | --device) [--iterations N]
+                      [--setup TRANSCRIPT]... [--level N] TRANSCRIPT...
+
+Transcripts have one hex-encoded APDU per line; `#` starts a comment and blank lines are skipped,
+and so is a leading `echo`, so that the APDUs of the scripts in test/apdu-tests/ can be pasted as
+they are. `{level}` is replaced by a 4-byte big-endian level, --level (1 by default) at the first
+iteration and one more at each of the next, so that the same transcript bakes again without
+falling below the high watermark. The setup transcripts are sent once, before the first
+iteration, and are not measured.
+
+Each iteration sends every transcript in turn, each APDU once its response to the one before has
+been received. The APDUs go to:
+  --host BINARY     the host build of test/host, which accepts every prompt;
+  --tcp HOST:PORT   the APDU port of an emulator (4-byte big-endian length, then the APDU; the
+                    response likewise, without its status word in the length); prompts are for its
+                    automation rules to answer;
+  --device          a device, through ledgerblue; someone has to answer any prompts.
+
+Prints a JSON object to standard output: for each instruction and for each transcript (a whole
+iteration of it), the number of samples, their median, 99th percentile, maximum and mean in
+milliseconds, and the status words received. Instruction names are read from src/apdu.h.
+"""
+
+import argparse
+import json
+import math
+import os
+import re
+import socket
+import subprocess
+import sys
+import time
+
+SRC = os.path.join(os.path.dirname(os.path.abspath(__file__)), os.pardir, "src")
+LINE = re.compile(r"^\s*(?:echo\s+)?(\S*)\s*(?:#.*)?$")
+APDU = re.compile(r"([0-9A-Fa-f]{2}|\{level\})*")
+OFFSET_INS = 1
+
+
+def read_instructions():
+    with open(os.path.join(SRC, "apdu.h")) as f:
+        return {int(code, 16): name for name, code in
+                re.findall(r"#define (INS_\w+)\s+(0x[0-9A-Fa-f]+)", f.read()) if name != "INS_MAX"}
+
+
+def read_transcript(path):
+    """Returns the APDUs of the transcript at `path`, as hex strings that may hold {level}."""
+    commands = []
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            match = LINE.match(line)
+            if match is None or not APDU.fullmatch(match.group(1)):
+                sys.exit("%s:%d: not an APDU: %s" % (path, number, line.strip()))
+            if match.group(1):
+                commands.append(match.group(1))
+    return commands
+
+
+def command(text, level):
+    return bytes.fromhex(text.replace("{level}", "%08x" % level))
+
+
+class Host:
+    def __init__(self, binary):
+        self.name = "host:" + binary
+        self.process = subprocess.Popen([binary], stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                                        stderr=subprocess.DEVNULL)
+
+    def exchange(self, apdu):
+        self.process.stdin.write(apdu.hex().encode() + b"\n")
+        self.process.stdin.flush()
+        response = self.process.stdout.readline()
+        if not response:
+            sys.exit("the host build exited with %s" % self.process.wait())
+        return bytes.fromhex(response.decode())
+
+    def close(self):
+        self.process.stdin.close()
+        self.process.wait()
+
+
+class Tcp:
+    def __init__(self, address):
+        host, _, port = address.rpartition(":")
+        self.name = "tcp:" + address
+        self.socket = socket.create_connection((host or "127.0.0.1", int(port)))
+        self.socket.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+
+    def receive(self, size):
+        data = b""
+        while len(data) < size:
+            chunk = self.socket.recv(size - len(data))
+            if not chunk:
+                sys.exit("the emulator closed the connection")
+            data += chunk
+        return data
+
+    def exchange(self, apdu):
+        self.socket.sendall(len(apdu).to_bytes(4, "big") + apdu)
+        size = int.from_bytes(self.receive(4), "big")
+        return self.receive(size + 2)
+
+    def close(self):
+        self.socket.close()
+
+
+class Device:
+    def __init__(self):
+        from ledgerblue.comm import getDongle
+        from ledgerblue.commException import CommException
+        self.name = "device"
+        self.dongle = getDongle(False)
+        self.error = CommException
+
+    def exchange(self, apdu):
+        try:
+            return bytes(self.dongle.exchange(apdu)) + b"\x90\x00"
+        except self.error as e:
+            return bytes(e.data or b"") + e.sw.to_bytes(2, "big")
+
+    def close(self):
+        self.dongle.close()
+
+
+def percentile(ordered, p):
+    """Nearest-rank percentile of the sorted `ordered`."""
+    return ordered[max(0, math.ceil(p / 100 * len(ordered)) - 1)]
+
+
+def summary(samples, status_words):
+    ordered = sorted(samples)
+    return {
+        "count": len(ordered),
+        "p50_ms": round(percentile(ordered, 50) * 1000, 3),
+        "p99_ms": round(percentile(ordered, 99) * 1000, 3),
+        "max_ms": round(ordered[-1] * 1000, 3),
+        "mean_ms": round(sum(ordered) / len(ordered) * 1000, 3),
+        "status_words": dict(sorted(status_words.items())),
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    target = parser.add_mutually_exclusive_group(required=True)
+    target.add_argument("--host")
+    target.add_argument("--tcp")
+    target.add_argument("--device", action="store_true")
+    parser.add_argument("--iterations", type=int, default=1000)
+    parser.add_argument("--setup", action="append", default=[])
+    parser.add_argument("--level", type=int, default=1)
+    parser.add_argument("transcripts", nargs="+")
+    args = parser.parse_args()
+
+    instructions = read_instructions()
+    setup = [line for path in args.setup for line in read_transcript(path)]
+    transcripts = [(path, read_transcript(path)) for path in args.transcripts]
+    transport = Host(args.host) if args.host else Tcp(args.tcp) if args.tcp else Device()
+
+    by_instruction = {}  # code: ([seconds], {status word: count})
+    by_transcript = {path: ([], {}) for path, _ in transcripts}
+    for text in setup:
+        transport.exchange(command(text, args.level))
+    for iteration in range(args.iterations):
+        level = args.level + iteration
+        for path, commands in transcripts:
+            total = 0
+            for text in commands:
+                apdu = command(text, level)
+                started = time.perf_counter()
+                response = transport.exchange(apdu)
+                elapsed = time.perf_counter() - started
+                total += elapsed
+                status_word = response[-2:].hex()
+                samples, status_words = by_instruction.setdefault(apdu[OFFSET_INS], ([], {}))
+                samples.append(elapsed)
+                status_words[status_word] = status_words.get(status_word, 0) + 1
+                by_transcript[path][1][status_word] = by_transcript[path][1].get(status_word, 0) + 1
+            by_transcript[path][0].append(total)
+    transport.close()
+
+    json.dump({
+        "transport": transport.name,
+        "iterations": args.iterations,
+        "instructions": [dict(instruction=instructions.get(code, "unknown"), code=code,
+                              **summary(*by_instruction[code])) for code in sorted(by_instruction)],
+        "transcripts": [dict(transcript=path, **summary(*by_transcript[path]))
+                        for path, _ in transcripts],
+    }, sys.stdout, indent=2)
+    print()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+"""Reads the audit log of the baking app: what it signed, most recent last.
+
+Usage: audit-log.py (--host BINARY | --tcp HOST:PORT | --device) [--since N]
+
+Pages through INS_QUERY_AUDIT_LOG from record N (0 by default), and prints one JSON object per
+line for each record the app still keeps: its number, counted from when the NVRAM of the app was
+blank, the chain id, the level, the kind ("block" or "endorsement") and the first 8 bytes of the
+hash signed, which is the BLAKE2b-256 hash of the whole message, magic byte included. Records
+overwritten since N are reported as one object with the numbers lost. Transports are those of
+apdu-replay.py.
+
+Passing the number after the last record printed as --since next time reads only what was signed
+in between.
+"""
+
+import argparse
+import importlib.util
+import json
+import os
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+CLA = 0x80
+INS_QUERY_AUDIT_LOG = 0x14
+ENDORSEMENT = 0x80000000  # AUDIT_ENDORSEMENT
+RECORD_SIZE = 16
+
+
+def transports():
+    spec = importlib.util.spec_from_file_location("apdu_replay",
+                                                  os.path.join(HERE, "apdu-replay.py"))
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+
+def query(transport, first):
+    """Returns the number of records written, and the number and fields of those returned from
+    `first` on."""
+    response = transport.exchange(bytes([CLA, INS_QUERY_AUDIT_LOG, 0, 0, 4]) +
+                                  first.to_bytes(4, "big"))
+    if response[-2:] != b"\x90\x00" or (len(response) - 10) % RECORD_SIZE:
+        sys.exit("INS_QUERY_AUDIT_LOG failed: %s" % response.hex())
+    written = int.from_bytes(response[0:4], "big")
+    number = int.from_bytes(response[4:8], "big")
+    records = []
+    for offset in range(8, len(response) - 2, RECORD_SIZE):
+        chain = int.from_bytes(response[offset:offset + 4], "big")
+        level = int.from_bytes(response[offset + 4:offset + 8], "big")
+        records.append({
+            "record": number + len(records),
+            "chain": "0x%08x" % chain,
+            "level": level & ~ENDORSEMENT,
+            "kind": "endorsement" if level & ENDORSEMENT else "block",
+            "hash": response[offset + 8:offset + RECORD_SIZE].hex(),
+        })
+    return written, number, records
+
+
+def read(transport, since=0):
+    """Yields the records from `since` on, and a {"lost": [first, last]} object for any run of
+    them no longer kept."""
+    first = since
+    while True:
+        written, number, records = query(transport, first)
+        if number > first:
+            yield {"lost": [first, number - 1]}
+        yield from records
+        first = number + len(records)
+        if first >= written or not records:
+            return
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    target = parser.add_mutually_exclusive_group(required=True)
+    target.add_argument("--host")
+    target.add_argument("--tcp")
+    target.add_argument("--device", action="store_true")
+    parser.add_argument("--since", type=int, default=0)
+    args = parser.parse_args()
+
+    replay = transports()
+    transport = (replay.Host(args.host) if args.host else
+                 replay.Tcp(args.tcp) if args.tcp else replay.Device())
+    for record in read(transport, args.since):
+        print(json.dumps(record))
+    transport.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,250 @@
+// Counts the instructions a program executes, by function and call stack, by single-stepping it
+// with ptrace. This is the stand-in for an emulator with an instruction-counting plugin, for the
+// host build (see test/host/bench.py): x86-64 and Linux only, and slow, but exact and repeatable.
+//
+//   icount -s <symbol> -o <output> <program> [arguments...]
+//
+// The program's standard input and output are its own. Counts are split every time <symbol> is
+// entered (for the host build, `read_apdu`, so that each APDU gets its own counts); part 0 is
+// everything before its first call. The output has one line per part and call stack, with the
+// instructions executed in the last function of the stack itself:
+//
+//   <part> <function>;<function>;...;<function> <instructions>
+//
+// which is the folded format flame graph tools read, once the part is taken off.
+//
+// Call stacks are followed through the stack pointer rather than the frames: a function is
+// entered when the program counter reaches its first instruction, and it has returned once the
+// stack pointer rises above where it was then (which also covers longjmp). A jump to the start of
+// a function from the same stack pointer is a tail call, which replaces the caller.
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ptrace.h>
+#include <sys/user.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+struct symbol {
+    uint64_t start;
+    char *name;
+};
+
+static struct symbol *symbols;
+static size_t num_symbols;
+
+// Call stacks are nodes of a tree: (parent, symbol) -> node.
+struct node {
+    uint32_t parent;
+    uint32_t symbol;
+};
+
+static struct node *nodes;
+static size_t num_nodes, nodes_size;
+
+// Open addressing: (part, node) -> instructions, and (parent, symbol) -> child node.
+struct slot {
+    uint64_t key;  // 0 when free
+    uint64_t value;
+};
+
+struct table {
+    struct slot *slots;
+    size_t size, used;
+};
+
+static struct table counts, children;
+
+#define MAX_DEPTH 1024
+
+struct frame {
+    uint32_t node;
+    uint64_t sp;  // At the first instruction of the function
+};
+
+static void die(char const *const what) {
+    fprintf(stderr, "icount: %s: %s\n", what, strerror(errno));
+    exit(2);
+}
+
+static uint64_t hash(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return key;
+}
+
+static struct slot *lookup(struct table *const table, uint64_t const key) {
+    if (table->used * 2 >= table->size) {
+        struct table grown = {calloc(table->size ? table->size * 2 : 1024, sizeof(struct slot)),
+                              table->size ? table->size * 2 : 1024,
+                              0};
+        if (grown.slots == NULL) die("calloc");
+        for (size_t i = 0; i < table->size; i++) {
+            if (table->slots[i].key != 0) *lookup(&grown, table->slots[i].key) = table->slots[i];
+        }
+        grown.used = table->used;
+        free(table->slots);
+        *table = grown;
+    }
+    size_t i = hash(key) & (table->size - 1);
+    while (table->slots[i].key != 0 && table->slots[i].key != key) i = (i + 1) & (table->size - 1);
+    if (table->slots[i].key == 0) {
+        table->slots[i].key = key;
+        table->used++;
+    }
+    return &table->slots[i];
+}
+
+static uint32_t child(uint32_t const parent, uint32_t const symbol) {
+    struct slot *const slot = lookup(&children, ((uint64_t) parent << 32 | symbol) + 1);
+    if (slot->value == 0) {
+        if (num_nodes == nodes_size) {
+            nodes_size = nodes_size ? nodes_size * 2 : 1024;
+            nodes = realloc(nodes, nodes_size * sizeof(*nodes));
+            if (nodes == NULL) die("realloc");
+        }
+        nodes[num_nodes] = (struct node){parent, symbol};
+        slot->value = ++num_nodes;  // Node ids are 1-based, 0 is the root
+    }
+    return slot->value;
+}
+
+// By address, then name, so that which of several names of a function is used does not vary.
+static int by_start(void const *const a, void const *const b) {
+    struct symbol const *const x = a, *const y = b;
+    if (x->start != y->start) return x->start < y->start ? -1 : 1;
+    return strcmp(x->name, y->name);
+}
+
+// Functions of `program`, from nm, sorted by address.
+static void read_symbols(char const *const program) {
+    char command[4096];
+    snprintf(command, sizeof(command), "nm --defined-only '%s'", program);
+    FILE *const nm = popen(command, "r");
+    if (nm == NULL) die("nm");
+    char line[1024];
+    size_t size = 0;
+    while (fgets(line, sizeof(line), nm) != NULL) {
+        unsigned long long start;
+        char type;
+        char name[900];
+        if (sscanf(line, "%llx %c %899s", &start, &type, name) != 3) continue;
+        if (type != 'T' && type != 't' && type != 'W' && type != 'w' && type != 'i') continue;
+        if (num_symbols == size) {
+            size = size ? size * 2 : 4096;
+            symbols = realloc(symbols, size * sizeof(*symbols));
+            if (symbols == NULL) die("realloc");
+        }
+        symbols[num_symbols++] = (struct symbol){start, strdup(name)};
+    }
+    if (pclose(nm) != 0 || num_symbols == 0) {
+        fprintf(stderr, "icount: no symbols in %s\n", program);
+        exit(2);
+    }
+    qsort(symbols, num_symbols, sizeof(*symbols), by_start);
+}
+
+// The function starting at `pc`, or -1.
+static long function_at(uint64_t const pc) {
+    size_t low = 0, high = num_symbols;
+    while (low < high) {
+        size_t const mid = (low + high) / 2;
+        if (symbols[mid].start < pc) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low < num_symbols && symbols[low].start == pc ? (long) low : -1;
+}
+
+// The function `pc` is in, for where the program starts.
+static uint32_t function_containing(uint64_t const pc) {
+    size_t i = 0;
+    while (i + 1 < num_symbols && symbols[i + 1].start <= pc) i++;
+    return i;
+}
+
+static void write_stack(FILE *const out, uint32_t const node) {
+    if (node == 0) return;
+    write_stack(out, nodes[node - 1].parent);
+    fprintf(out, "%s%s", nodes[node - 1].parent ? ";" : "", symbols[nodes[node - 1].symbol].name);
+}
+
+int main(int argc, char **argv) {
+    char const *split = NULL, *output = NULL;
+    int option;
+    while ((option = getopt(argc, argv, "+s:o:")) != -1) {
+        if (option == 's') split = optarg;
+        if (option == 'o') output = optarg;
+        if (option == '?') return 2;
+    }
+    if (split == NULL || output == NULL || optind == argc) {
+        fprintf(stderr, "usage: icount -s <symbol> -o <output> <program> [arguments...]\n");
+        return 2;
+    }
+    read_symbols(argv[optind]);
+    long split_symbol = -1;
+    for (size_t i = 0; i < num_symbols; i++) {
+        if (strcmp(symbols[i].name, split) == 0) split_symbol = i;
+    }
+    if (split_symbol < 0) {
+        fprintf(stderr, "icount: no function %s in %s\n", split, argv[optind]);
+        return 2;
+    }
+
+    pid_t const pid = fork();
+    if (pid < 0) die("fork");
+    if (pid == 0) {
+        ptrace(PTRACE_TRACEME, 0, NULL, NULL);
+        execv(argv[optind], argv + optind);
+        _exit(127);
+    }
+
+    static struct frame stack[MAX_DEPTH];
+    size_t depth = 0;
+    uint64_t part = 0;
+    int status;
+    if (waitpid(pid, &status, 0) < 0) die("waitpid");
+    while (WIFSTOPPED(status)) {
+        struct user_regs_struct regs;
+        if (ptrace(PTRACE_GETREGS, pid, NULL, &regs) < 0) die("PTRACE_GETREGS");
+
+        while (depth > 1 && regs.rsp > stack[depth - 1].sp) depth--;  // Returned
+        long const entered = function_at(regs.rip);
+        if (depth == 0) {
+            stack[depth++] = (struct frame){child(0, function_containing(regs.rip)), regs.rsp};
+        } else if (entered >= 0) {
+            if (regs.rsp == stack[depth - 1].sp) depth--;  // Tail call
+            if (depth == MAX_DEPTH) {
+                fprintf(stderr, "icount: calls nested too deep\n");
+                return 2;
+            }
+            uint32_t const parent = depth ? stack[depth - 1].node : 0;
+            stack[depth++] = (struct frame){child(parent, entered), regs.rsp};
+            if (entered == split_symbol) part++;
+        }
+        lookup(&counts, part << 32 | stack[depth - 1].node)->value++;
+
+        if (ptrace(PTRACE_SINGLESTEP, pid, NULL, NULL) < 0) die("PTRACE_SINGLESTEP");
+        if (waitpid(pid, &status, 0) < 0) die("waitpid");
+    }
+
+    FILE *const out = fopen(output, "w");
+    if (out == NULL) die(output);
+    for (size_t i = 0; i < counts.size; i++) {
+        struct slot const *const slot = &counts.slots[i];
+        if (slot->key == 0) continue;
+        fprintf(out, "%llu ", (unsigned long long) (slot->key >> 32));
+        write_stack(out, slot->key & UINT32_MAX);
+        fprintf(out, " %llu\n", (unsigned long long) slot->value);
+    }
+    fclose(out);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 2;
+}
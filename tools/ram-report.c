@@ -0,0 +1,31 @@
+// Sizes of the parts of `globals_t`, for `make ram-report`. Each array below is as large as what
+// it is named after, so `nm -S` reads the sizes off the object file, for any target and without
+// linking or running anything.
+
+#include "globals.h"
+
+#define MEMBER_SIZE(type, member) sizeof(((type *) 0)->member)
+
+char ram_globals[sizeof(globals_t)];
+char ram_dynamic_display[MEMBER_SIZE(globals_t, dynamic_display)];
+char ram_public_key_cache[sizeof(struct public_key_cache)];
+char ram_scratch[sizeof(struct scratch)];
+char ram_status[sizeof(struct status_counters)];
+#if TRACE_RECORDS > 0
+char ram_trace[sizeof(struct trace)];
+#endif
+char ram_apdu[MEMBER_SIZE(globals_t, apdu)];
+
+char ram_sign[sizeof(apdu_sign_state_t)];
+char ram_sign_operation_group[sizeof(struct parsed_operation_group)];
+char ram_sign_parse_state[sizeof(struct parse_state)];
+char ram_sign_message_data[MEMBER_SIZE(apdu_sign_state_t, message_data)];
+char ram_sign_hash_state[sizeof(blake2b_hash_state_t)];
+
+#ifdef HAVE_WALLET
+char ram_payout_policy[sizeof(struct payout_policy)];
+#endif
+#ifdef BAKING_APP
+char ram_hmac[sizeof(apdu_hmac_state_t)];
+char ram_baking_auth[MEMBER_SIZE(globals_t, apdu.baking_auth)];
+#endif
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""Worst-case stack depth of the entry points of the app, from the call graphs GCC writes with
+-fcallgraph-info=su (one .ci file per translation unit).
+
+Usage: stack-report.py <root regex> <.ci files...>
+
+Prints, for each function whose name matches the regex, the most stack any chain of calls from it
+takes, and that chain. Functions of the SDK (anything without a .ci entry) count as taking none, so
+only the part of the stack that is the app's own is measured. Indirect calls are not followed:
+callbacks run on a stack of their own (the UI's) and are listed as roots of their own instead.
+"""
+
+import re
+import sys
+
+NODE = re.compile(r'node: \{ title: "([^"]*)" label: "([^"]*)"')
+EDGE = re.compile(r'edge: \{ sourcename: "([^"]*)" targetname: "([^"]*)"')
+SIZE = re.compile(r"\\n(\d+) bytes \(([^)]*)\)$")
+
+
+def read_graph(paths):
+    sizes = {}  # Function: (bytes, whether that is bounded)
+    calls = {}
+    for path in paths:
+        with open(path) as f:
+            for line in f:
+                node = NODE.match(line)
+                if node:
+                    size = SIZE.search(node.group(2))
+                    if size:
+                        kind = size.group(2)
+                        sizes[node.group(1)] = (int(size.group(1)),
+                                                kind == "static" or "bounded" in kind)
+                    continue
+                edge = EDGE.match(line)
+                if edge:
+                    calls.setdefault(edge.group(1), set()).add(edge.group(2))
+    return sizes, calls
+
+
+def worst_case(function, sizes, calls, memo, active):
+    """Returns (bytes, chain, whether the bytes are a bound) for the deepest chain from
+    `function`."""
+    if function in memo:
+        return memo[function]
+    own, bounded = sizes.get(function, (0, True))
+    if function in active:
+        return own, [function + " (recursive)"], False
+    active.add(function)
+    deepest = (0, [], True)
+    for callee in sorted(calls.get(function, ())):
+        result = worst_case(callee, sizes, calls, memo, active)
+        if result[0] > deepest[0] or not result[2]:
+            deepest = (result[0], result[1], deepest[2] and result[2])
+    active.discard(function)
+    memo[function] = (own + deepest[0], [function] + deepest[1], bounded and deepest[2])
+    return memo[function]
+
+
+def name(function):
+    return function.rpartition(":")[2]  # Static functions are "file:function"
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit(__doc__)
+    roots = re.compile(sys.argv[1])
+    sizes, calls = read_graph(sys.argv[2:])
+
+    memo = {}
+    results = []
+    for function in sizes:
+        if roots.search(name(function)):
+            results.append((name(function),) + worst_case(function, sizes, calls, memo, set()))
+
+    for root, total, chain, bounded in sorted(results, key=lambda r: (-r[1], r[0])):
+        print("%6d%s %s" % (total, "" if bounded else "+", root))
+        print("       " + " > ".join("%s (%d)" % (name(f), sizes.get(f, (0,))[0])
+                                     for f in chain[1:] if f in sizes))
+
+
+if __name__ == "__main__":
+    main()
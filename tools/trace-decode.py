@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""Turns the responses of INS_DRAIN_TRACE into a timeline.
+
+Usage: trace-decode.py [files...]
+
+Reads the responses hex-encoded, one per line, in the order they were received (from the files or
+from standard input), and prints one line per record: its number since the app started, its time
+and the time since the record before it in milliseconds, the instruction it was recorded under,
+the event and its details. Records overwritten before they were drained are reported as lost.
+Event and instruction names are read from src/apdu_trace.h and src/apdu.h.
+"""
+
+import fileinput
+import os
+import re
+import struct
+import sys
+
+SRC = os.path.join(os.path.dirname(os.path.abspath(__file__)), os.pardir, "src")
+RECORD = struct.Struct(">IIhBB")
+
+DETAILS = {
+    "APDU": lambda p: "%d bytes" % p,
+    "HANDLED": lambda p: "%d bytes" % p,
+    "PROMPT": lambda p: "",
+    "ERROR": lambda p: "0x%04x" % p,
+    "PARSE_ERROR": lambda p: "apdu_sign.c:%d" % p,
+    "OPERATION_ERROR": lambda p: "operations.c:%d" % p,
+    "HWM": lambda p: "level %d%s" % (p & 0x7FFFFFFF, " (endorsement)" if p >> 31 else ""),
+    "SIGNED": lambda p: "magic byte %d, %d-byte signature" % (p >> 8, p & 0xFF),
+}
+
+
+def read_names():
+    with open(os.path.join(SRC, "apdu_trace.h")) as f:
+        enum = re.search(r"enum trace_event \{(.*?)\};", f.read(), re.S).group(1)
+    events = {i + 1: name for i, name in enumerate(re.findall(r"^\s*TRACE_(\w+)", enum, re.M))}
+    with open(os.path.join(SRC, "apdu.h")) as f:
+        instructions = {int(code, 16): name for name, code in
+                        re.findall(r"#define (INS_\w+)\s+(0x[0-9A-Fa-f]+)", f.read())
+                        if name != "INS_MAX"}
+    return events, instructions
+
+
+def records(response):
+    """Returns the number of records written since the app started and the records in
+    `response`, oldest first."""
+    if response[-2:] != b"\x90\x00" or (len(response) - 6) % RECORD.size:
+        sys.exit("not a response of INS_DRAIN_TRACE: %s" % response.hex())
+    written = int.from_bytes(response[:4], "big")
+    return written, [RECORD.unpack_from(response, offset)
+                     for offset in range(4, len(response) - 2, RECORD.size)]
+
+
+def main():
+    if len(sys.argv) > 1 and sys.argv[1].startswith("-"):
+        sys.exit(__doc__)
+    events, instructions = read_names()
+
+    print("%8s %10s %7s  %-30s %-16s %5s  %s" %
+          ("record", "ms", "+ms", "instruction", "event", "step", "details"))
+    expected = 0  # Number of the next record
+    previous = None  # Time of the last record
+    for line in fileinput.input():
+        if not line.strip():
+            continue
+        written, drained = records(bytes.fromhex(line.strip()))
+        first = written - len(drained)
+        if first > expected:
+            print("%8s %d records lost" % ("...", first - expected))
+        for number, (time, payload, step, event, instruction) in enumerate(drained, first):
+            name = events.get(event, "event %d" % event)
+            details = DETAILS.get(name, lambda p: "payload 0x%x" % p)(payload)
+            where = "%s (0x%02x)" % (instructions.get(instruction, "unknown"), instruction)
+            delta = "-" if previous is None else "+%d" % (time - previous)
+            print("%8d %10d %7s  %-30s %-16s %5d  %s" %
+                  (number, time, delta, where, name, step, details))
+            previous = time
+        expected = written
+
+
+if __name__ == "__main__":
+    main()